@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_BASE_BOUNDED_QUEUE_H_
+#define UBAHN_BASE_BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/**
+ * A thread safe FIFO queue with a fixed capacity. Producers never block, a
+ * full queue rejects new elements, so that callers can push back on their
+ * clients instead of piling up work.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : _capacity(capacity), _closed(false) {}
+
+  // disallow copy and assign
+  BoundedQueue(const BoundedQueue&) = delete;
+  void operator=(BoundedQueue) = delete;
+
+  /** Appends the element, returns false if the queue is full or closed. */
+  bool tryPush(T element) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_closed || _elements.size() >= _capacity) return false;
+      _elements.push_back(std::move(element));
+    }
+    _not_empty.notify_one();
+    return true;
+  }
+
+  /**
+   * Waits for the next element. Returns false if the queue was closed and all
+   * remaining elements have been taken.
+   */
+  bool pop(T* element) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _not_empty.wait(lock, [this] { return _closed || !_elements.empty(); });
+    if (_elements.empty()) return false;
+
+    *element = std::move(_elements.front());
+    _elements.pop_front();
+    return true;
+  }
+
+  /** Rejects all further elements and wakes up all waiting consumers. */
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _closed = true;
+    }
+    _not_empty.notify_all();
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _elements.size();
+  }
+
+ private:
+  const size_t _capacity;
+  bool _closed;
+  std::deque<T> _elements;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _not_empty;
+};
+
+#endif  // UBAHN_BASE_BOUNDED_QUEUE_H_
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_BASE_PARALLEL_H_
+#define UBAHN_BASE_PARALLEL_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+ * Splits the range [0, n) into at most the given number of contiguous blocks
+ * and calls fn(begin, end) for each block in its own thread. The calling
+ * thread processes the first block. Returns when all blocks are done.
+ */
+template <typename Function>
+void runInBlocks(size_t n, int threads, Function fn) {
+  const size_t n_blocks = std::max<size_t>(1, std::min<size_t>(threads, n));
+
+  std::vector<std::thread> workers;
+  for (size_t b = 1; b < n_blocks; b++) {
+    workers.emplace_back(fn, b * n / n_blocks, (b + 1) * n / n_blocks);
+  }
+  fn(0, n / n_blocks);
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+#endif  // UBAHN_BASE_PARALLEL_H_
@@ -18,6 +18,7 @@
 #define UBAHN_BASE_UTILS_H_
 
 #include <algorithm>
+#include <string>
 
 template <class Container>
 auto getFirstElement(const Container& container)
@@ -30,4 +31,46 @@ bool contains(const Container& container, const T& val) {
   return std::find(container.begin(), container.end(), val) != container.end();
 }
 
+/** Returns the string as a quoted JSON string. */
+inline std::string quoteJson(const std::string& field) {
+  static const char HEX[] = "0123456789abcdef";
+
+  std::string quoted = "\"";
+  for (char c : field) {
+    switch (c) {
+      case '"':
+        quoted += "\\\"";
+        break;
+      case '\\':
+        quoted += "\\\\";
+        break;
+      case '\b':
+        quoted += "\\b";
+        break;
+      case '\f':
+        quoted += "\\f";
+        break;
+      case '\n':
+        quoted += "\\n";
+        break;
+      case '\r':
+        quoted += "\\r";
+        break;
+      case '\t':
+        quoted += "\\t";
+        break;
+      default:
+        // all other control characters must be written as code points
+        if (static_cast<unsigned char>(c) < 0x20) {
+          quoted += "\\u00";
+          quoted += HEX[c >> 4];
+          quoted += HEX[c & 0xf];
+        } else {
+          quoted += c;
+        }
+    }
+  }
+  return quoted + "\"";
+}
+
 #endif  // UBAHN_BASE_UTILS_H_
@@ -0,0 +1,346 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bench/bench_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/utils.h"
+
+using std::endl;
+using std::ostream;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char CSV_HEADER[] =
+    "instance,repetitions,parse_ms,build_ms,model_ms,solve_ms,total_ms,"
+    "graph_nodes,graph_arcs,variables,rows,lazy_cuts,callback_calls,bb_nodes,"
+    "objective";
+
+const int CSV_COLUMNS = 15;
+
+string quoteCsv(const string& field) {
+  if (field.find_first_of(",\"\n") == string::npos) {
+    return field;
+  }
+
+  string quoted = "\"";
+  for (char c : field) {
+    if (c == '"') quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+vector<string> splitCsvLine(const string& line) {
+  vector<string> fields(1);
+
+  bool in_quotes = false;
+  for (size_t i = 0; i < line.size(); i++) {
+    const char c = line[i];
+    if (in_quotes) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        fields.back() += '"';
+        i++;
+      } else if (c == '"') {
+        in_quotes = false;
+      } else {
+        fields.back() += c;
+      }
+    } else if (c == '"') {
+      in_quotes = true;
+    } else if (c == ',') {
+      fields.push_back("");
+    } else {
+      fields.back() += c;
+    }
+  }
+
+  return fields;
+}
+
+/** Returns the p-quantile of the sorted values. */
+double quantile(const vector<double>& sorted, double p) {
+  const double pos = p * (sorted.size() - 1);
+  const size_t lower = static_cast<size_t>(pos);
+  if (lower + 1 >= sorted.size()) {
+    return sorted.back();
+  }
+
+  return sorted[lower] + (pos - lower) * (sorted[lower + 1] - sorted[lower]);
+}
+
+void writeSpreadCsv(const Spread& s, ostream& O) {
+  O << "," << s.median << "," << s.q1 << "," << s.q3 << "," << s.max;
+}
+
+void writeSpreadJson(const string& name, const Spread& s, ostream& O) {
+  O << ", \"" << name << "\": {\"median\": " << s.median
+    << ", \"q1\": " << s.q1 << ", \"q3\": " << s.q3
+    << ", \"max\": " << s.max << "}";
+}
+
+/** Checks a single metric, where larger values are worse. */
+bool isRegression(double value, double base, double threshold) {
+  return value > base * (1.0 + threshold);
+}
+
+class RegressionReport {
+ public:
+  RegressionReport(double threshold, ostream& O)
+      : _threshold(threshold), _regressions(0), _out(O) {}
+
+  void check(const string& instance, const string& metric, double value,
+             double base) {
+    if (isRegression(value, base, _threshold)) {
+      _out << " " << instance << ": " << metric << " regressed from " << base
+           << " to " << value << endl;
+      _regressions++;
+    }
+  }
+
+  void checkEqual(const string& instance, const string& metric, double value,
+                  double base) {
+    if (std::fabs(value - base) > 1e-6) {
+      _out << " " << instance << ": " << metric << " changed from " << base
+           << " to " << value << endl;
+      _regressions++;
+    }
+  }
+
+  int getRegressions() const { return _regressions; }
+
+ private:
+  const double _threshold;
+  int _regressions;
+  ostream& _out;
+};
+}  // namespace
+
+double median(vector<double> values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  const size_t mid = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + mid, values.end());
+  if (values.size() % 2 == 1) {
+    return values[mid];
+  }
+
+  const double upper = values[mid];
+  const double lower = *std::max_element(values.begin(), values.begin() + mid);
+  return (lower + upper) / 2.0;
+}
+
+Spread spread(vector<double> values) {
+  Spread result;
+  if (values.empty()) {
+    return result;
+  }
+
+  std::sort(values.begin(), values.end());
+  result.median = quantile(values, 0.5);
+  result.q1 = quantile(values, 0.25);
+  result.q3 = quantile(values, 0.75);
+  result.max = values.back();
+
+  return result;
+}
+
+void writeCsv(const vector<BenchRecord>& records, ostream& O) {
+  O << CSV_HEADER << endl;
+  for (const BenchRecord& r : records) {
+    O << quoteCsv(r.instance) << "," << r.repetitions << "," << r.parse_ms
+      << "," << r.build_ms << "," << r.model_ms << "," << r.solve_ms << ","
+      << r.total_ms << "," << r.graph_nodes << "," << r.graph_arcs << ","
+      << r.variables << "," << r.rows << "," << r.lazy_cuts << ","
+      << r.callback_calls << "," << r.bb_nodes << ","
+      << std::setprecision(10) << r.objective << std::setprecision(6) << endl;
+  }
+}
+
+void writeJson(const vector<BenchRecord>& records, ostream& O) {
+  O << "[" << endl;
+  for (size_t i = 0; i < records.size(); i++) {
+    const BenchRecord& r = records[i];
+    O << "  {\"instance\": " << quoteJson(r.instance)
+      << ", \"repetitions\": " << r.repetitions
+      << ", \"parse_ms\": " << r.parse_ms << ", \"build_ms\": " << r.build_ms
+      << ", \"model_ms\": " << r.model_ms << ", \"solve_ms\": " << r.solve_ms
+      << ", \"total_ms\": " << r.total_ms
+      << ", \"graph_nodes\": " << r.graph_nodes
+      << ", \"graph_arcs\": " << r.graph_arcs
+      << ", \"variables\": " << r.variables << ", \"rows\": " << r.rows
+      << ", \"lazy_cuts\": " << r.lazy_cuts
+      << ", \"callback_calls\": " << r.callback_calls
+      << ", \"bb_nodes\": " << r.bb_nodes
+      << ", \"duplicate_cuts\": " << r.duplicate_cuts
+      << ", \"max_lp_rows\": " << r.max_lp_rows
+      << ", \"heuristic_calls\": " << r.heuristic_calls
+      << ", \"improved_tours\": " << r.improved_tours
+      << ", \"objective\": " << std::setprecision(10) << r.objective
+      << std::setprecision(6) << "}" << (i + 1 < records.size() ? "," : "")
+      << endl;
+  }
+  O << "]" << endl;
+}
+
+void writeVariabilityCsv(const vector<VariabilityRecord>& records,
+                         ostream& O) {
+  O << "instance,runs";
+  for (const char* metric : {"solve_ms", "total_ms", "bb_nodes", "lazy_cuts"}) {
+    O << "," << metric << "_median," << metric << "_q1," << metric << "_q3,"
+      << metric << "_max";
+  }
+  O << ",min_objective,max_objective" << endl;
+
+  for (const VariabilityRecord& r : records) {
+    O << quoteCsv(r.instance) << "," << r.runs;
+    writeSpreadCsv(r.solve_ms, O);
+    writeSpreadCsv(r.total_ms, O);
+    writeSpreadCsv(r.bb_nodes, O);
+    writeSpreadCsv(r.lazy_cuts, O);
+    O << "," << std::setprecision(10) << r.min_objective << ","
+      << r.max_objective << std::setprecision(6) << endl;
+  }
+}
+
+void writeVariabilityJson(const vector<VariabilityRecord>& records,
+                          ostream& O) {
+  O << "[" << endl;
+  for (size_t i = 0; i < records.size(); i++) {
+    const VariabilityRecord& r = records[i];
+    O << "  {\"instance\": " << quoteJson(r.instance)
+      << ", \"runs\": " << r.runs;
+    writeSpreadJson("solve_ms", r.solve_ms, O);
+    writeSpreadJson("total_ms", r.total_ms, O);
+    writeSpreadJson("bb_nodes", r.bb_nodes, O);
+    writeSpreadJson("lazy_cuts", r.lazy_cuts, O);
+    O << ", \"min_objective\": " << std::setprecision(10) << r.min_objective
+      << ", \"max_objective\": " << r.max_objective << std::setprecision(6)
+      << "}" << (i + 1 < records.size() ? "," : "") << endl;
+  }
+  O << "]" << endl;
+}
+
+vector<BenchRecord> readCsv(std::istream& in) {
+  vector<BenchRecord> records;
+
+  string line;
+  if (!std::getline(in, line) || line.compare(CSV_HEADER) != 0) {
+    throw std::runtime_error("Invalid benchmark file: Unexpected header");
+  }
+
+  int line_number = 1;
+  while (std::getline(in, line)) {
+    line_number++;
+    if (line.empty()) continue;
+
+    const vector<string> f = splitCsvLine(line);
+    if (f.size() != CSV_COLUMNS) {
+      std::ostringstream errBuf;
+      errBuf << "Invalid benchmark file: Line " << line_number << " has "
+             << f.size() << " columns";
+      throw std::runtime_error(errBuf.str());
+    }
+
+    try {
+      BenchRecord r;
+      r.instance = f[0];
+      r.repetitions = boost::lexical_cast<int>(f[1]);
+      r.parse_ms = boost::lexical_cast<double>(f[2]);
+      r.build_ms = boost::lexical_cast<double>(f[3]);
+      r.model_ms = boost::lexical_cast<double>(f[4]);
+      r.solve_ms = boost::lexical_cast<double>(f[5]);
+      r.total_ms = boost::lexical_cast<double>(f[6]);
+      r.graph_nodes = boost::lexical_cast<int>(f[7]);
+      r.graph_arcs = boost::lexical_cast<int>(f[8]);
+      r.variables = boost::lexical_cast<int>(f[9]);
+      r.rows = boost::lexical_cast<int>(f[10]);
+      r.lazy_cuts = boost::lexical_cast<int>(f[11]);
+      r.callback_calls = boost::lexical_cast<int>(f[12]);
+      r.bb_nodes = boost::lexical_cast<long>(f[13]);
+      r.objective = boost::lexical_cast<double>(f[14]);
+      records.push_back(r);
+    } catch (const boost::bad_lexical_cast&) {
+      std::ostringstream errBuf;
+      errBuf << "Invalid benchmark file: Line " << line_number
+             << " contains an invalid number";
+      throw std::runtime_error(errBuf.str());
+    }
+  }
+
+  return records;
+}
+
+int compareWithBaseline(const vector<BenchRecord>& records,
+                        const vector<BenchRecord>& baseline, double threshold,
+                        double min_time_ms, ostream& O) {
+  std::map<string, const BenchRecord*> base_by_instance;
+  for (const BenchRecord& r : baseline) {
+    base_by_instance[r.instance] = &r;
+  }
+
+  O << "Comparison with baseline (threshold " << threshold * 100 << "%):"
+    << endl;
+
+  RegressionReport report(threshold, O);
+  for (const BenchRecord& r : records) {
+    auto pos = base_by_instance.find(r.instance);
+    if (pos == base_by_instance.end()) {
+      O << " " << r.instance << ": not contained in the baseline" << endl;
+      continue;
+    }
+    const BenchRecord& b = *pos->second;
+
+    // a different optimum is always a regression, independent of threshold
+    report.checkEqual(r.instance, "objective", r.objective, b.objective);
+
+    // timings are noisy, only track them above a minimal duration
+    const double floor = min_time_ms;
+    report.check(r.instance, "parse_ms", r.parse_ms,
+                 std::max(b.parse_ms, floor));
+    report.check(r.instance, "build_ms", r.build_ms,
+                 std::max(b.build_ms, floor));
+    report.check(r.instance, "model_ms", r.model_ms,
+                 std::max(b.model_ms, floor));
+    report.check(r.instance, "solve_ms", r.solve_ms,
+                 std::max(b.solve_ms, floor));
+    report.check(r.instance, "total_ms", r.total_ms,
+                 std::max(b.total_ms, floor));
+
+    report.check(r.instance, "variables", r.variables, b.variables);
+    report.check(r.instance, "rows", r.rows, b.rows);
+    report.check(r.instance, "lazy_cuts", r.lazy_cuts, b.lazy_cuts);
+    report.check(r.instance, "bb_nodes", r.bb_nodes, b.bb_nodes);
+  }
+
+  if (report.getRegressions() == 0) {
+    O << " No regressions." << endl;
+  }
+
+  return report.getRegressions();
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_BENCH_BENCH_REPORT_H_
+#define UBAHN_BENCH_BENCH_REPORT_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/** The measurements of one instance, aggregated over all repetitions. */
+struct BenchRecord {
+  BenchRecord()
+      : repetitions(0),
+        parse_ms(0.0),
+        build_ms(0.0),
+        model_ms(0.0),
+        solve_ms(0.0),
+        total_ms(0.0),
+        graph_nodes(0),
+        graph_arcs(0),
+        variables(0),
+        rows(0),
+        lazy_cuts(0),
+        callback_calls(0),
+        bb_nodes(0),
+        duplicate_cuts(0),
+        max_lp_rows(0),
+        heuristic_calls(0),
+        improved_tours(0),
+        objective(0.0) {}
+
+  std::string instance;
+  int repetitions;
+
+  /// median wall clock time of each phase in milliseconds
+  double parse_ms;
+  double build_ms;
+  double model_ms;
+  double solve_ms;
+  double total_ms;
+
+  /// size of the problem graph and the MIP model
+  int graph_nodes;
+  int graph_arcs;
+  int variables;
+  int rows;
+
+  /// search statistics of the last repetition
+  int lazy_cuts;
+  int callback_calls;
+  long bb_nodes;
+  int duplicate_cuts;   ///< not part of the CSV
+  int max_lp_rows;      ///< not part of the CSV
+  int heuristic_calls;  ///< not part of the CSV
+  int improved_tours;   ///< not part of the CSV
+  double objective;
+};
+
+/** The distribution of a metric over several runs. */
+struct Spread {
+  Spread() : median(0.0), q1(0.0), q3(0.0), max(0.0) {}
+
+  double iqr() const { return q3 - q1; }
+
+  double median;
+  double q1;  ///< first quartile
+  double q3;  ///< third quartile
+  double max;
+};
+
+/** The variability of one instance over different seeds and orderings. */
+struct VariabilityRecord {
+  VariabilityRecord() : runs(0), min_objective(0.0), max_objective(0.0) {}
+
+  std::string instance;
+  int runs;
+
+  Spread solve_ms;
+  Spread total_ms;
+  Spread bb_nodes;
+  Spread lazy_cuts;
+
+  /// the objective must not depend on the seed, different values are a bug
+  double min_objective;
+  double max_objective;
+};
+
+/** Returns the median of the given values or 0 if there are none. */
+double median(std::vector<double> values);
+
+/**
+ * Returns the quartiles and the maximum of the given values. Quantiles are
+ * interpolated linearly between the closest ranks.
+ */
+Spread spread(std::vector<double> values);
+
+void writeCsv(const std::vector<BenchRecord>& records, std::ostream& O);
+void writeJson(const std::vector<BenchRecord>& records, std::ostream& O);
+
+void writeVariabilityCsv(const std::vector<VariabilityRecord>& records,
+                         std::ostream& O);
+void writeVariabilityJson(const std::vector<VariabilityRecord>& records,
+                          std::ostream& O);
+
+/** Parses records written by writeCsv, throws an exception on invalid input */
+std::vector<BenchRecord> readCsv(std::istream& in);
+
+/**
+ * Compares the records against a baseline and reports every tracked metric
+ * that got worse by more than threshold (relative, e.g. 0.1 for 10%).
+ * Timings below min_time_ms are considered noise and are never reported.
+ * Returns the number of regressions found.
+ */
+int compareWithBaseline(const std::vector<BenchRecord>& records,
+                        const std::vector<BenchRecord>& baseline,
+                        double threshold, double min_time_ms,
+                        std::ostream& O = std::cout);
+
+#endif  // UBAHN_BENCH_BENCH_REPORT_H_
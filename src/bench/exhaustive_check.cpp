@@ -0,0 +1,330 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Compares the branch and bound and the Lagrangian bound with the optimum
+ * found by enumerating every subset of arcs on small random station graphs.
+ * No CPLEX license is required, which makes it possible to check the
+ * exactness of the branch and bound on any machine.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/graph.h"
+#include "solver/branch_and_bound.h"
+#include "solver/euler.h"
+#include "solver/lagrangian_bound.h"
+
+using leda::edge_array;
+using leda::node_array;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const double INFINITE = std::numeric_limits<double>::infinity();
+const double EPSILON = 1e-6;
+const int MAX_ARCS = 24;
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options]" << endl
+       << "Options:" << endl
+       << "  --instances N  number of random instances (default: 200)" << endl
+       << "  --seed S       seed of the first instance (default: 1)" << endl
+       << "  --arcs M       arcs of every instance, at most " << MAX_ARCS
+       << " (default: 16)" << endl
+       << "  --threads N    threads of the branch and bound (default: 4)"
+       << endl;
+}
+
+/** A small random station graph. */
+struct Instance {
+  leda::graph g;
+  node_array<int> station_ids;
+  int n_stations;
+  edge_array<double> costs;
+};
+
+/**
+ * Creates a graph of 3 to 6 stations with one or two nodes each. Half of the
+ * instances get a ring in both directions, so that a tour exists, the rest
+ * are random and may be infeasible. The values are taken from the engine
+ * output directly, as the std distributions differ between libraries.
+ */
+void createInstance(uint32_t seed, int n_arcs, Instance* instance) {
+  std::mt19937 engine(seed);
+  const int n_stations = 3 + engine() % 4;
+  const int per_station = 1 + engine() % 2;
+
+  leda::graph& g = instance->g;
+  vector<vector<node>> nodes(n_stations);
+  for (int s = 0; s < n_stations; s++) {
+    for (int i = 0; i < per_station; i++) {
+      nodes[s].push_back(g.new_node());
+    }
+  }
+
+  vector<std::pair<edge, double>> arcs;
+  auto addArc = [&](node from, node to, int max_cost) {
+    if (g.number_of_edges() >= n_arcs) return;
+    arcs.push_back({g.new_edge(from, to), 1.0 + engine() % max_cost});
+  };
+
+  if (seed % 2 == 1) {
+    for (int s = 0; s < n_stations; s++) {
+      const int t = (s + 1) % n_stations;
+      addArc(nodes[s].front(), nodes[t].back(), 9);
+      addArc(nodes[t].front(), nodes[s].back(), 9);
+    }
+  }
+  if (per_station == 2) {
+    for (int s = 0; s < n_stations; s++) {
+      addArc(nodes[s][0], nodes[s][1], 5);
+      addArc(nodes[s][1], nodes[s][0], 5);
+    }
+  }
+  while (g.number_of_edges() < n_arcs) {
+    const int a = engine() % n_stations;
+    const int b = engine() % n_stations;
+    if (a == b) continue;
+    addArc(nodes[a][engine() % per_station], nodes[b][engine() % per_station],
+           15);
+  }
+
+  instance->n_stations = n_stations;
+  instance->station_ids.init(g, 0);
+  for (int s = 0; s < n_stations; s++) {
+    for (node v : nodes[s]) instance->station_ids[v] = s;
+  }
+  instance->costs.init(g, 0.0);
+  for (const auto& arc : arcs) instance->costs[arc.first] = arc.second;
+}
+
+int findRoot(vector<int>* parents, int v) {
+  while ((*parents)[v] != v) {
+    (*parents)[v] = (*parents)[(*parents)[v]];
+    v = (*parents)[v];
+  }
+  return v;
+}
+
+/**
+ * Returns the cost of the cheapest connected, balanced subset of arcs leaving
+ * every station, or infinity if there is none.
+ */
+double enumerateOptimum(const Instance& instance) {
+  const leda::graph& g = instance.g;
+  node_array<int> index(g, 0);
+  int n_nodes = 0;
+  node v;
+  forall_nodes(v, g) { index[v] = n_nodes++; }
+
+  vector<int> sources, targets;
+  vector<double> costs;
+  vector<uint32_t> leaves;  // the station left by the arc, as a bit
+  edge e;
+  forall_edges(e, g) {
+    sources.push_back(index[source(e)]);
+    targets.push_back(index[target(e)]);
+    costs.push_back(instance.costs[e]);
+    const int station = instance.station_ids[source(e)];
+    leaves.push_back(station != instance.station_ids[target(e)]
+                         ? 1u << station
+                         : 0u);
+  }
+
+  const int m = sources.size();
+  const uint32_t all_stations = (1u << instance.n_stations) - 1;
+  vector<int> balance(n_nodes), parents(n_nodes);
+  double best = INFINITE;
+  for (uint32_t subset = 1; subset < (1u << m); subset++) {
+    uint32_t left = 0;
+    double cost = 0.0;
+    for (int i = 0; i < m; i++) {
+      if (subset >> i & 1) {
+        left |= leaves[i];
+        cost += costs[i];
+      }
+    }
+    if (left != all_stations || cost >= best) continue;
+
+    std::fill(balance.begin(), balance.end(), 0);
+    for (int i = 0; i < m; i++) {
+      if (subset >> i & 1) {
+        balance[sources[i]]--;
+        balance[targets[i]]++;
+      }
+    }
+    bool feasible = true;
+    for (int b : balance) feasible = feasible && b == 0;
+    if (!feasible) continue;
+
+    for (int i = 0; i < n_nodes; i++) parents[i] = i;
+    int components = 0;
+    vector<bool> touched(n_nodes, false);
+    for (int i = 0; i < m; i++) {
+      if (!(subset >> i & 1)) continue;
+      touched[sources[i]] = touched[targets[i]] = true;
+      const int a = findRoot(&parents, sources[i]);
+      const int b = findRoot(&parents, targets[i]);
+      if (a != b) parents[a] = b;
+    }
+    for (int i = 0; i < n_nodes; i++) {
+      if (touched[i] && findRoot(&parents, i) == i) components++;
+    }
+    if (components == 1) best = cost;
+  }
+
+  return best;
+}
+
+/** Throws unless the tour is an Euler tour of the value leaving all. */
+void checkTour(const Instance& instance, const std::list<edge>& tour,
+               double value) {
+  const vector<edge> arcs(tour.begin(), tour.end());
+  buildEulerTour(instance.g, arcs);
+
+  edge_array<bool> used(instance.g, false);
+  vector<bool> left(instance.n_stations, false);
+  double cost = 0.0;
+  for (edge e : arcs) {
+    if (used[e]) throw std::runtime_error("arc used twice");
+    used[e] = true;
+    cost += instance.costs[e];
+
+    const int station = instance.station_ids[source(e)];
+    if (station != instance.station_ids[target(e)]) left[station] = true;
+  }
+  for (int s = 0; s < instance.n_stations; s++) {
+    if (!left[s]) throw std::runtime_error("station not visited");
+  }
+  if (std::abs(cost - value) > EPSILON) {
+    throw std::runtime_error("tour cost differs from the solution value");
+  }
+}
+
+/** Returns an empty string if both solvers agree with the optimum. */
+string checkInstance(const Instance& instance, int threads, double* optimum) {
+  *optimum = enumerateOptimum(instance);
+
+  BranchAndBound solver(instance.g, instance.station_ids,
+                        instance.n_stations, instance.costs);
+  solver.setThreads(threads);
+  solver.solve();
+
+  std::ostringstream errBuf;
+  if (*optimum == INFINITE) {
+    if (solver.isOptimal() || solver.getLowerBound() != INFINITE) {
+      errBuf << "branch and bound found a tour of an infeasible instance";
+    }
+    return errBuf.str();
+  }
+
+  if (!solver.isOptimal()) {
+    errBuf << "branch and bound stopped at lower bound "
+           << solver.getLowerBound();
+    return errBuf.str();
+  }
+  if (std::abs(solver.getSolutionValue() - *optimum) > EPSILON) {
+    errBuf << "branch and bound found " << solver.getSolutionValue();
+    return errBuf.str();
+  }
+  try {
+    checkTour(instance, solver.getSolutionTour(), *optimum);
+  } catch (const std::runtime_error& e) {
+    errBuf << "invalid tour: " << e.what();
+    return errBuf.str();
+  }
+
+  LagrangianBound bound(instance.g, instance.station_ids,
+                        instance.n_stations, instance.costs);
+  const BoundResult relaxation = bound.compute();
+  if (relaxation.lower_bound > *optimum + EPSILON) {
+    errBuf << "Lagrangian bound " << relaxation.lower_bound
+           << " exceeds the optimum";
+  } else if (!relaxation.tour.empty() &&
+             relaxation.upper_bound < *optimum - EPSILON) {
+    errBuf << "repaired tour " << relaxation.upper_bound
+           << " is below the optimum";
+  }
+  return errBuf.str();
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  int instances = 200;
+  uint32_t seed = 1;
+  int n_arcs = 16;
+  int threads = 4;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--instances" && i + 1 < argc) {
+        instances = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--seed" && i + 1 < argc) {
+        seed = boost::lexical_cast<uint32_t>(args[++i]);
+      } else if (arg == "--arcs" && i + 1 < argc) {
+        n_arcs = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--threads" && i + 1 < argc) {
+        threads = boost::lexical_cast<int>(args[++i]);
+      } else {
+        throw std::runtime_error("Unknown option " + arg);
+      }
+    }
+    if (n_arcs < 1 || n_arcs > MAX_ARCS) {
+      throw std::runtime_error("The number of arcs is out of range");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  int infeasible = 0;
+  int failures = 0;
+  for (int i = 0; i < instances; i++) {
+    Instance instance;
+    createInstance(seed + i, n_arcs, &instance);
+
+    double optimum;
+    const string error = checkInstance(instance, threads, &optimum);
+    if (optimum == INFINITE) infeasible++;
+    if (!error.empty()) {
+      cout << "seed " << seed + i << ": optimum " << optimum << ", " << error
+           << endl;
+      failures++;
+    }
+  }
+
+  cout << instances << " instances, " << infeasible << " infeasible, "
+       << failures << " failures" << endl;
+  return failures > 0 ? 1 : 0;
+}
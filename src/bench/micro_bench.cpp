@@ -0,0 +1,297 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Microbenchmarks for the individual components of the pipeline. All inputs
+ * are synthetic networks created by the NetworkGenerator, the argument of
+ * each benchmark is the number of stations.
+ */
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "base/graph.h"
+#include "generator/network_generator.h"
+#include "graph_builder.h"
+#include "io/xml_reader.h"
+#include "io/xml_writer.h"
+#include "solver/euler.h"
+#include "transport_network.h"
+
+using std::map;
+using std::string;
+
+typedef map<string, map<string, leda::node>> t_nodemap;
+
+const double CHANGING_TIME = 5.0;
+const double SWITCHING_TIME = 5.0;
+
+/** Gives the benchmarks access to the individual passes of the builder. */
+class GraphBuilderPasses {
+ public:
+  explicit GraphBuilderPasses(const TransportNetwork& network)
+      : builder(network.getStations(), network.getLines(), CHANGING_TIME,
+                SWITCHING_TIME, GraphBuilder::Unbuilt()) {}
+
+  void createNodesAndTravelArcs() {
+    builder.createNodesAndTravelArcs(way_nodemap, back_nodemap);
+  }
+  void addStationProblemSwitchingArcs() {
+    builder.addStationProblemSwitchingArcs(way_nodemap, back_nodemap);
+  }
+  void addAllConnectionArcs() {
+    builder.addAllConnectionArcs(way_nodemap, back_nodemap);
+  }
+  void preprocessGraph() { builder.preprocessGraph(STATION); }
+
+  static void getTourOutput(const GraphBuilder& builder,
+                            const std::list<leda::edge>& tour) {
+    std::vector<string> column[4];
+    builder.getTourOutput(tour, true, column);
+    benchmark::DoNotOptimize(column);
+  }
+
+  GraphBuilder builder;
+  t_nodemap way_nodemap;
+  t_nodemap back_nodemap;
+};
+
+namespace {
+
+/** Returns the generated network with the given number of stations. */
+const TransportNetwork& getNetwork(int stations) {
+  static map<int, std::unique_ptr<TransportNetwork>> networks;
+
+  std::unique_ptr<TransportNetwork>& network = networks[stations];
+  if (!network) {
+    GeneratorConfig config;
+    config.layout = MULTI_CITY_LAYOUT;
+    config.stations = stations;
+    config.lines = std::max(8, stations / 50);
+    config.terminal_loops = 0.2;
+
+    network.reset(new TransportNetwork());
+    NetworkGenerator(config).generate(network.get());
+  }
+
+  return *network;
+}
+
+/** Returns the name of a file containing the generated network. */
+string getNetworkFile(int stations) {
+  static map<int, string> files;
+
+  string& file = files[stations];
+  if (file.empty()) {
+    std::ostringstream name;
+    name << "microbench-" << stations << ".xml";
+    file = name.str();
+
+    const TransportNetwork& network = getNetwork(stations);
+    writeTransportFile(network.getStations(), network.getLines(), file);
+  }
+
+  return file;
+}
+
+/**
+ * Returns a deterministic random walk that uses about twice as many arcs as
+ * the graph contains. It has the same structure as a tour of the solver.
+ */
+std::list<leda::edge> randomWalk(const leda::graph& g) {
+  std::mt19937 random(1);
+  std::list<leda::edge> walk;
+
+  leda::node current = g.first_node();
+  for (int i = 0; i < 2 * g.number_of_edges(); i++) {
+    if (g.outdeg(current) == 0) break;
+
+    const int k = random() % g.outdeg(current);
+    int j = 0;
+    leda::edge e;
+    forall_out_edges(e, current) {
+      if (j++ == k) break;
+    }
+
+    walk.push_back(e);
+    current = target(e);
+  }
+
+  return walk;
+}
+
+void BM_XMLReaderParse(benchmark::State& state) {
+  const string file = getNetworkFile(state.range(0));
+
+  while (state.KeepRunning()) {
+    XMLReader reader;
+    reader.readTransportFile(file);
+    benchmark::DoNotOptimize(reader.getStations());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CreateNodesAndTravelArcs(benchmark::State& state) {
+  const TransportNetwork& network = getNetwork(state.range(0));
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    {
+      GraphBuilderPasses passes(network);
+      state.ResumeTiming();
+      passes.createNodesAndTravelArcs();
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_AddStationProblemSwitchingArcs(benchmark::State& state) {
+  const TransportNetwork& network = getNetwork(state.range(0));
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    {
+      GraphBuilderPasses passes(network);
+      passes.createNodesAndTravelArcs();
+      state.ResumeTiming();
+      passes.addStationProblemSwitchingArcs();
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_AddAllConnectionArcs(benchmark::State& state) {
+  const TransportNetwork& network = getNetwork(state.range(0));
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    {
+      GraphBuilderPasses passes(network);
+      passes.createNodesAndTravelArcs();
+      passes.addStationProblemSwitchingArcs();
+      state.ResumeTiming();
+      passes.addAllConnectionArcs();
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_PreprocessGraph(benchmark::State& state) {
+  const TransportNetwork& network = getNetwork(state.range(0));
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    {
+      GraphBuilderPasses passes(network);
+      passes.createNodesAndTravelArcs();
+      passes.addStationProblemSwitchingArcs();
+      passes.addAllConnectionArcs();
+      state.ResumeTiming();
+      passes.preprocessGraph();
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_EulerTour(benchmark::State& state) {
+  const TransportNetwork& network = getNetwork(state.range(0));
+  GraphBuilder builder(network.getStations(), network.getLines(),
+                       CHANGING_TIME, SWITCHING_TIME, STATION);
+
+  // adding the reverse of every arc makes the connected graph Eulerian
+  const leda::graph& g = builder.getGraph();
+  leda::graph euler_graph;
+  leda::node_array<leda::node> copy(g);
+  leda::node n;
+  forall_nodes(n, g) { copy[n] = euler_graph.new_node(); }
+  leda::edge e;
+  forall_edges(e, g) {
+    euler_graph.new_edge(copy[source(e)], copy[target(e)]);
+    euler_graph.new_edge(copy[target(e)], copy[source(e)]);
+  }
+
+  while (state.KeepRunning()) {
+    Euler euler(euler_graph);
+    benchmark::DoNotOptimize(euler.getEulerTour());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_GetTourOutput(benchmark::State& state) {
+  const TransportNetwork& network = getNetwork(state.range(0));
+  GraphBuilder builder(network.getStations(), network.getLines(),
+                       CHANGING_TIME, SWITCHING_TIME, STATION);
+  const std::list<leda::edge> tour = randomWalk(builder.getGraph());
+
+  while (state.KeepRunning()) {
+    GraphBuilderPasses::getTourOutput(builder, tour);
+  }
+  state.SetComplexityN(state.range(0));
+}
+}  // namespace
+
+BENCHMARK(BM_XMLReaderParse)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK(BM_CreateNodesAndTravelArcs)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK(BM_AddStationProblemSwitchingArcs)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK(BM_AddAllConnectionArcs)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK(BM_PreprocessGraph)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+// the Euler tour is computed recursively, keep the depth within stack limits
+BENCHMARK(BM_EulerTour)
+    ->RangeMultiplier(10)
+    ->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK(BM_GetTourOutput)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+
+BENCHMARK_MAIN();
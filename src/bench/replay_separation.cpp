@@ -0,0 +1,159 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Replays separations recorded by ubahn_bench --record-separation and times
+ * the SubtourSeparator on them. No CPLEX license is required, which makes it
+ * possible to profile the separation in isolation.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/graph.h"
+#include "base/timer.h"
+#include "solver/separation_recorder.h"
+#include "solver/subtour_separator.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [--repetitions N] recording ..." << endl;
+}
+
+bool equalCuts(const vector<RecordedCut>& a, const vector<RecordedCut>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].out_arcs != b[i].out_arcs || a[i].in_arcs != b[i].in_arcs) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int countArcs(const vector<RecordedCut>& cuts) {
+  int arcs = 0;
+  for (const RecordedCut& cut : cuts) {
+    arcs += cut.out_arcs.size() + cut.in_arcs.size();
+  }
+  return arcs;
+}
+
+/**
+ * Replays all solutions of the recording and returns the number of
+ * solutions for which the cuts differ from the recorded ones.
+ */
+int replay(const string& file, int repetitions) {
+  SeparationRecording recording;
+  readSeparationRecording(file, &recording);
+
+  vector<leda::list<edge>> solutions;
+  for (const SeparationRecording::Solution& solution : recording.solutions) {
+    leda::list<edge> selected;
+    for (int arc : solution.arcs) {
+      selected.push_back(recording.arcs[arc]);
+    }
+    solutions.push_back(selected);
+  }
+
+  SubtourSeparator separator(recording.graph, recording.station_ids,
+                             recording.n_stations);
+
+  int mismatches = 0;
+  vector<double> times;
+  for (int r = 0; r < repetitions; r++) {
+    Timer timer;
+    for (size_t i = 0; i < solutions.size(); i++) {
+      const vector<SubtourCut> cuts = separator.separate(solutions[i]);
+
+      // only the first repetition is checked against the recording
+      if (r > 0) continue;
+
+      const vector<RecordedCut> found =
+          getRecordedCuts(cuts, recording.arc_index);
+      const vector<RecordedCut>& expected = recording.solutions[i].cuts;
+      if (!equalCuts(found, expected)) {
+        cerr << file << ": solution " << i << " gives " << found.size()
+             << " cuts with " << countArcs(found) << " arcs, recorded were "
+             << expected.size() << " cuts with " << countArcs(expected)
+             << " arcs";
+        if (found.size() == expected.size()) {
+          cerr << " (cuts differ in their arcs)";
+        }
+        cerr << endl;
+        mismatches++;
+      }
+    }
+    times.push_back(
+        timer.Elapsed<std::chrono::duration<double, std::milli>>().count());
+  }
+
+  std::sort(times.begin(), times.end());
+  cout << file << ": " << recording.graph.number_of_nodes() << " nodes, "
+       << recording.graph.number_of_edges() << " arcs, "
+       << solutions.size() << " separations, median " << times[times.size() / 2]
+       << " ms, min " << times.front() << " ms" << endl;
+
+  return mismatches;
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  int repetitions = 5;
+  vector<string> files;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--repetitions" && i + 1 < argc) {
+        repetitions = boost::lexical_cast<int>(args[++i]);
+      } else if (arg.compare(0, 2, "--") == 0) {
+        throw std::runtime_error("Unknown option " + arg);
+      } else {
+        files.push_back(arg);
+      }
+    }
+    if (files.empty() || repetitions < 1) {
+      throw std::runtime_error("Missing recording");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  int mismatches = 0;
+  for (const string& file : files) {
+    try {
+      mismatches += replay(file, repetitions);
+    } catch (const std::runtime_error& e) {
+      cerr << "Error while replaying " << file << ": " << e.what() << endl;
+      return 1;
+    }
+  }
+
+  return mismatches > 0 ? 2 : 0;
+}
@@ -0,0 +1,1001 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/timer.h"
+#include "bench/bench_report.h"
+#include "generator/network_generator.h"
+#include "graph_builder.h"
+#include "io/xml_reader.h"
+#include "io/xml_writer.h"
+#include "solver/branch_and_bound.h"
+#include "solver/branching.h"
+#include "solver/cut_pool.h"
+#include "solver/lagrangian_bound.h"
+#include "solver/station_solver.h"
+#include "ubahn_api.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char* DEFAULT_INSTANCES[] = {"instances/simple.xml",
+                                   "instances/bvg.xml"};
+
+struct BenchConfig {
+  BenchConfig()
+      : warmup(1),
+        repetitions(5),
+        change_cost(5.0),
+        switch_cost(5.0),
+        preprocessing(true),
+        cut_policy(DEAGGREGATED_CUTS),
+        max_cuts(0),
+        compare_cuts(false),
+        seed_cuts(NO_SEED_CUTS),
+        compare_seed_cuts(false),
+        cut_registry(true),
+        cut_purge(0),
+        heuristic_frequency(0),
+        branch_priorities(false),
+        line_branching(false),
+        compare_branching(false),
+        cross_validate(false),
+        exact_threads(0),
+        exact_time_limit(0.0),
+        threshold(0.1),
+        min_time_ms(5.0),
+        seeds(0),
+        shuffle(false),
+        reuse_cuts(false),
+        startup(false),
+        seed(1) {}
+
+  vector<string> instances;
+  int warmup;
+  int repetitions;
+
+  double change_cost;
+  double switch_cost;
+  bool preprocessing;
+
+  CutPolicy cut_policy;
+  int max_cuts;  ///< per callback, 0 for no limit
+  /// compare the solve times of all cut policies
+  bool compare_cuts;
+  SeedCuts seed_cuts;
+  /// compare the solves without and with seed cuts
+  bool compare_seed_cuts;
+  bool cut_registry;
+  int cut_purge;  ///< inactive callbacks before a cut is purged, 0 never
+  int heuristic_frequency;  ///< heuristic callbacks per repair, 0 never
+
+  bool branch_priorities;
+  BranchWeights branch_weights;
+  bool line_branching;
+  /// compare the solves with and without each branching rule
+  bool compare_branching;
+
+  /// compare the optimum of the branch and bound with that of CPLEX
+  bool cross_validate;
+  int exact_threads;        ///< 0 for the number of cores
+  double exact_time_limit;  ///< in milliseconds, 0 for no limit
+
+  /// prefix of the files the LP size of each callback is written to
+  string lp_trace_prefix;
+
+  string csv_file;
+  string json_file;
+  string baseline_file;
+  double threshold;
+  double min_time_ms;
+
+  /// prefix of the files the separations are recorded to
+  string record_prefix;
+
+  /// number of CPLEX seeds in the variability mode, 0 disables the mode
+  int seeds;
+  /// whether the nodes and arcs are randomly permuted for each seed
+  bool shuffle;
+
+  /// whether the timed runs start with the cuts found by the warmup runs
+  bool reuse_cuts;
+
+  /// compare the time to the result of the sequential and pipelined startup
+  bool startup;
+
+  /// seed for the generated instances
+  uint32_t seed;
+};
+
+/** The measurements of a single run of the full pipeline. */
+struct RunResult {
+  double parse_ms;
+  double build_ms;
+  double model_ms;
+  double solve_ms;
+  double total_ms;
+
+  int graph_nodes;
+  int graph_arcs;
+  SolverStatistics statistics;
+  double objective;
+};
+
+double elapsedMs(const Timer& timer) {
+  return timer.Elapsed<std::chrono::duration<double, std::milli>>().count();
+}
+
+/** Options of a single run that are not part of the benchmark config. */
+struct RunOptions {
+  RunOptions() : seed(0), initial_cuts(nullptr), found_cuts(nullptr) {}
+
+  /// a positive seed is used for CPLEX and, if enabled, to shuffle the graph
+  int seed;
+  /// if not empty, the separations are recorded into that file
+  string record_file;
+  /// if not empty, the LP size at each callback is written into that file
+  string lp_trace_file;
+  /// cuts of earlier runs that are added to the model
+  const CutPool* initial_cuts;
+  /// if set, all cuts of the run are added to this pool
+  CutPool* found_cuts;
+};
+
+/** Runs parsing, building and solving for the given instance. */
+RunResult runPipeline(const string& file, const BenchConfig& config,
+                      const RunOptions& options = RunOptions()) {
+  const int run_seed = options.seed;
+  RunResult result;
+  Timer total_timer;
+
+  Timer phase_timer;
+  XMLReader reader;
+  reader.readTransportFile(file);
+  result.parse_ms = elapsedMs(phase_timer);
+
+  phase_timer.Reset();
+  phase_timer.Start();
+  GraphBuilder builder(reader.getStations(), reader.getLines(),
+                       config.change_cost, config.switch_cost, STATION,
+                       config.preprocessing);
+  result.build_ms = elapsedMs(phase_timer);
+  result.graph_nodes = builder.getGraph().number_of_nodes();
+  result.graph_arcs = builder.getGraph().number_of_edges();
+
+  if (run_seed > 0 && config.shuffle) {
+    builder.shuffle(run_seed);
+  }
+
+  phase_timer.Reset();
+  phase_timer.Start();
+  StationSolver solver(builder.getGraph(), builder.getDist(),
+                       builder.getStationNodes(), builder.getConnections());
+  solver.setVerbose(false);
+  solver.setCutPolicy(config.cut_policy);
+  solver.setMaxCutsPerCallback(config.max_cuts);
+  solver.setCutRegistry(config.cut_registry);
+  solver.setCutPurge(config.cut_purge);
+  solver.setSeedCuts(config.seed_cuts);
+  solver.setHeuristicFrequency(config.heuristic_frequency);
+  if (config.branch_priorities) {
+    solver.setBranchPriorities(
+        getBranchPriorities(builder, config.branch_weights));
+  }
+  if (config.line_branching) {
+    solver.setBranchGroups(getStationLineGroups(builder));
+  }
+  if (run_seed > 0) {
+    solver.setRandomSeed(run_seed);
+  }
+  result.model_ms = elapsedMs(phase_timer);
+
+  if (!options.record_file.empty()) {
+    solver.setSeparationRecorder(options.record_file);
+  }
+  if (options.initial_cuts || options.found_cuts) {
+    solver.setKeepCuts(true);
+  }
+  if (options.initial_cuts) {
+    solver.addKeptCuts(options.initial_cuts->toGraph(builder));
+  }
+
+  phase_timer.Reset();
+  phase_timer.Start();
+  solver.solve();
+  result.solve_ms = elapsedMs(phase_timer);
+
+  if (options.found_cuts) {
+    options.found_cuts->addFromGraph(builder, solver.getKeptCuts());
+  }
+  if (!options.lp_trace_file.empty()) {
+    std::ofstream out(options.lp_trace_file);
+    out << "callback,seconds,rows" << endl;
+    for (const LpSample& sample : solver.getLpTrace()) {
+      out << sample.callback_calls << "," << sample.seconds << ","
+          << sample.rows << endl;
+    }
+  }
+
+  result.total_ms = elapsedMs(total_timer);
+  result.statistics = solver.getStatistics();
+  result.objective = solver.getSolutionValue();
+
+  return result;
+}
+
+BenchRecord benchmarkInstance(const string& file, const BenchConfig& config) {
+  // with cut reuse the warmup runs fill the pool for the timed runs
+  CutPool cut_pool;
+  RunOptions warmup_options;
+  RunOptions timed_options;
+  if (config.reuse_cuts) {
+    warmup_options.found_cuts = &cut_pool;
+    timed_options.initial_cuts = &cut_pool;
+  }
+  // the trace of the last timed run is kept
+  if (!config.lp_trace_prefix.empty()) {
+    const size_t slash = file.find_last_of('/');
+    const string name = slash == string::npos ? file : file.substr(slash + 1);
+    timed_options.lp_trace_file = config.lp_trace_prefix + name + ".csv";
+  }
+
+  for (int i = 0; i < config.warmup; i++) {
+    runPipeline(file, config, warmup_options);
+  }
+
+  vector<double> parse_ms, build_ms, model_ms, solve_ms, total_ms;
+  RunResult last;
+  for (int i = 0; i < config.repetitions; i++) {
+    last = runPipeline(file, config, timed_options);
+
+    parse_ms.push_back(last.parse_ms);
+    build_ms.push_back(last.build_ms);
+    model_ms.push_back(last.model_ms);
+    solve_ms.push_back(last.solve_ms);
+    total_ms.push_back(last.total_ms);
+  }
+
+  // the recording is done in an extra run, so that it does not affect timings
+  if (!config.record_prefix.empty()) {
+    const size_t slash = file.find_last_of('/');
+    const string name = slash == string::npos ? file : file.substr(slash + 1);
+    RunOptions options;
+    options.record_file = config.record_prefix + name + ".sep";
+    runPipeline(file, config, options);
+  }
+
+  BenchRecord record;
+  record.instance = file;
+  record.repetitions = config.repetitions;
+  record.parse_ms = median(parse_ms);
+  record.build_ms = median(build_ms);
+  record.model_ms = median(model_ms);
+  record.solve_ms = median(solve_ms);
+  record.total_ms = median(total_ms);
+  record.graph_nodes = last.graph_nodes;
+  record.graph_arcs = last.graph_arcs;
+  record.variables = last.statistics.variables;
+  record.rows = last.statistics.rows;
+  record.lazy_cuts = last.statistics.lazy_cuts;
+  record.callback_calls = last.statistics.callback_calls;
+  record.bb_nodes = last.statistics.nodes;
+  record.objective = last.objective;
+  record.duplicate_cuts = last.statistics.duplicate_cuts;
+  record.max_lp_rows = last.statistics.max_lp_rows;
+  record.heuristic_calls = last.statistics.heuristic_calls;
+  record.improved_tours = last.statistics.improved_tours;
+
+  return record;
+}
+
+/** Solves the instance once for every seed and collects the spread. */
+VariabilityRecord measureVariability(const string& file,
+                                     const BenchConfig& config) {
+  for (int i = 0; i < config.warmup; i++) {
+    runPipeline(file, config);
+  }
+
+  vector<double> solve_ms, total_ms, bb_nodes, lazy_cuts;
+  VariabilityRecord record;
+  record.instance = file;
+  record.runs = config.seeds;
+  for (int seed = 1; seed <= config.seeds; seed++) {
+    RunOptions options;
+    options.seed = seed;
+    const RunResult run = runPipeline(file, config, options);
+
+    solve_ms.push_back(run.solve_ms);
+    total_ms.push_back(run.total_ms);
+    bb_nodes.push_back(run.statistics.nodes);
+    lazy_cuts.push_back(run.statistics.lazy_cuts);
+
+    if (seed == 1 || run.objective < record.min_objective) {
+      record.min_objective = run.objective;
+    }
+    if (seed == 1 || run.objective > record.max_objective) {
+      record.max_objective = run.objective;
+    }
+  }
+
+  record.solve_ms = spread(solve_ms);
+  record.total_ms = spread(total_ms);
+  record.bb_nodes = spread(bb_nodes);
+  record.lazy_cuts = spread(lazy_cuts);
+
+  return record;
+}
+
+/**
+ * Runs the variability mode for all instances. Returns 2 if the objective
+ * depends on the seed, 1 on errors and 0 otherwise.
+ */
+int runVariability(const BenchConfig& config) {
+  vector<VariabilityRecord> records;
+  int inconsistent = 0;
+  for (const string& file : config.instances) {
+    cout << "Measuring variability of " << file << " over " << config.seeds
+         << " seeds" << (config.shuffle ? " with shuffling" : "") << "..."
+         << endl;
+    try {
+      records.push_back(measureVariability(file, config));
+    } catch (const std::runtime_error& e) {
+      cerr << "Error while benchmarking " << file << ": " << e.what() << endl;
+      return 1;
+    }
+
+    const VariabilityRecord& r = records.back();
+    cout << " solve median " << r.solve_ms.median << " ms, IQR "
+         << r.solve_ms.iqr() << " ms, worst " << r.solve_ms.max << " ms"
+         << endl
+         << " nodes median " << r.bb_nodes.median << ", IQR "
+         << r.bb_nodes.iqr() << ", worst " << r.bb_nodes.max << endl;
+    if (std::fabs(r.max_objective - r.min_objective) > 1e-6) {
+      cerr << " objective differs between seeds: " << r.min_objective
+           << " to " << r.max_objective << endl;
+      inconsistent++;
+    }
+  }
+
+  if (!config.csv_file.empty()) {
+    std::ofstream out(config.csv_file);
+    writeVariabilityCsv(records, out);
+  }
+  if (!config.json_file.empty()) {
+    std::ofstream out(config.json_file);
+    writeVariabilityJson(records, out);
+  }
+
+  return inconsistent > 0 ? 2 : 0;
+}
+
+/**
+ * Compares the time to the result when CPLEX is started after building the
+ * graph and when it is started in parallel to reading and building. The runs
+ * of both variants alternate, so that both see the same system state.
+ */
+int runStartup(const BenchConfig& config) {
+  SolveOptions sequential;
+  sequential.change_cost = config.change_cost;
+  sequential.switch_cost = config.switch_cost;
+  sequential.preprocess = config.preprocessing;
+  sequential.pipelined = false;
+
+  SolveOptions pipelined = sequential;
+  pipelined.pipelined = true;
+
+  for (const string& file : config.instances) {
+    cout << "Measuring the startup of " << file << "..." << endl;
+    vector<double> sequential_ms, pipelined_ms;
+    try {
+      for (int i = 0; i < config.warmup; i++) {
+        solveNetworkFile(file, sequential);
+        solveNetworkFile(file, pipelined);
+      }
+      for (int i = 0; i < config.repetitions; i++) {
+        const SolveResult a = solveNetworkFile(file, sequential);
+        const SolveResult b = solveNetworkFile(file, pipelined);
+        if (std::fabs(a.objective - b.objective) > 1e-6) {
+          throw std::runtime_error("The objectives differ");
+        }
+        sequential_ms.push_back(a.total_ms);
+        pipelined_ms.push_back(b.total_ms);
+      }
+    } catch (const std::runtime_error& e) {
+      cerr << "Error while benchmarking " << file << ": " << e.what() << endl;
+      return 1;
+    }
+
+    const double before = median(sequential_ms);
+    const double after = median(pipelined_ms);
+    cout << " time to result: sequential " << before << " ms, pipelined "
+         << after << " ms, saved " << before - after << " ms" << endl;
+  }
+
+  return 0;
+}
+
+/**
+ * Returns the class of the instance: its file name without directory and
+ * extension and, for generated instances, without the seed.
+ */
+string getInstanceClass(const string& file) {
+  const size_t slash = file.find_last_of('/');
+  string name = slash == string::npos ? file : file.substr(slash + 1);
+  name = name.substr(0, name.rfind(".xml"));
+
+  if (name.compare(0, 10, "generated-") == 0) {
+    name = name.substr(0, name.rfind('-'));
+  }
+  return name;
+}
+
+/** A named modification of the benchmark config. */
+struct Variant {
+  string name;
+  BenchConfig config;
+};
+
+/** Returns the relative change from base to value as a signed percentage. */
+string formatChange(double value, double base) {
+  if (base == 0) return "n/a";
+
+  std::ostringstream change;
+  change << std::showpos << 100.0 * (value - base) / base << "%";
+  return change.str();
+}
+
+/**
+ * Solves every instance with each variant and reports the fastest variant by
+ * the median solve time, for every instance and every instance class. The
+ * search statistics are compared against the first variant.
+ */
+int compareVariants(const vector<Variant>& variants, const string& what) {
+  // total of the median solve times per class and variant
+  std::map<string, vector<double>> class_ms;
+  for (const string& file : variants[0].config.instances) {
+    cout << "Comparing the " << what << " on " << file << "..." << endl;
+
+    vector<double>& total_ms = class_ms[getInstanceClass(file)];
+    total_ms.resize(variants.size(), 0.0);
+
+    size_t fastest = 0;
+    vector<double> variant_ms;
+    RunResult first;
+    for (size_t v = 0; v < variants.size(); v++) {
+      const BenchConfig& config = variants[v].config;
+
+      vector<double> solve_ms;
+      RunResult last;
+      try {
+        for (int i = 0; i < config.warmup; i++) {
+          runPipeline(file, config);
+        }
+        for (int i = 0; i < config.repetitions; i++) {
+          last = runPipeline(file, config);
+          solve_ms.push_back(last.solve_ms);
+        }
+      } catch (const std::runtime_error& e) {
+        cerr << "Error while benchmarking " << file << ": " << e.what()
+             << endl;
+        return 1;
+      }
+      if (v == 0) first = last;
+
+      variant_ms.push_back(median(solve_ms));
+      total_ms[v] += variant_ms[v];
+      cout << " " << variants[v].name << ": solve " << variant_ms[v]
+           << " ms, " << last.statistics.lazy_cuts << " lazy cuts in "
+           << last.statistics.callback_calls << " callbacks, "
+           << last.statistics.nodes << " nodes";
+      if (v > 0) {
+        cout << " (callbacks "
+             << formatChange(last.statistics.callback_calls,
+                             first.statistics.callback_calls)
+             << ", nodes "
+             << formatChange(last.statistics.nodes, first.statistics.nodes)
+             << ")";
+      }
+      cout << endl;
+
+      if (variant_ms[v] < variant_ms[fastest]) fastest = v;
+    }
+    cout << " fastest: " << variants[fastest].name << endl;
+  }
+
+  cout << endl << "Fastest " << what << " per instance class:" << endl;
+  for (const auto& instance_class : class_ms) {
+    const vector<double>& total_ms = instance_class.second;
+    const size_t fastest =
+        std::min_element(total_ms.begin(), total_ms.end()) - total_ms.begin();
+    cout << " " << instance_class.first << ": " << variants[fastest].name
+         << " (" << total_ms[fastest] << " ms)" << endl;
+  }
+
+  return 0;
+}
+
+int runCutPolicies(const BenchConfig& config) {
+  vector<Variant> variants;
+  for (CutPolicy policy :
+       {DEAGGREGATED_CUTS, AGGREGATED_CUTS, ADAPTIVE_CUTS}) {
+    Variant variant{getCutPolicyName(policy), config};
+    variant.config.cut_policy = policy;
+    variants.push_back(variant);
+  }
+
+  return compareVariants(variants, "cut policies");
+}
+
+int runBranching(const BenchConfig& config) {
+  vector<Variant> variants;
+  const char* names[] = {"default", "priorities", "lines", "both"};
+  for (int i = 0; i < 4; i++) {
+    Variant variant{names[i], config};
+    variant.config.branch_priorities = i == 1 || i == 3;
+    variant.config.line_branching = i >= 2;
+    variants.push_back(variant);
+  }
+
+  return compareVariants(variants, "branching rules");
+}
+
+int runSeedCuts(const BenchConfig& config) {
+  vector<Variant> variants;
+  const char* names[] = {"none", "lazy", "rows"};
+  for (const char* name : names) {
+    Variant variant{name, config};
+    variant.config.seed_cuts = parseSeedCuts(name);
+    variants.push_back(variant);
+  }
+
+  return compareVariants(variants, "seed cuts");
+}
+
+/**
+ * Solves every instance with CPLEX and with the branch and bound and fails,
+ * unless the branch and bound proves the same optimum with a valid tour and
+ * the Lagrangian bound does not exceed it.
+ */
+int runCrossValidation(const BenchConfig& config) {
+  int failures = 0;
+  for (const string& file : config.instances) {
+    cout << "Cross-validating " << file << "..." << endl;
+    try {
+      XMLReader reader;
+      reader.readTransportFile(file);
+      GraphBuilder builder(reader.getStations(), reader.getLines(),
+                           config.change_cost, config.switch_cost, STATION,
+                           config.preprocessing);
+
+      Timer timer;
+      StationSolver solver(builder.getGraph(), builder.getDist(),
+                           builder.getStationNodes(),
+                           builder.getConnections());
+      solver.setVerbose(false);
+      solver.solve();
+      const double cplex_ms = elapsedMs(timer);
+      const double expected = solver.getSolutionValue();
+
+      leda::node_array<int> station_ids;
+      const int n_stations = builder.getStationIds(&station_ids);
+      LagrangianBound bound(builder.getGraph(), station_ids, n_stations,
+                            builder.getDist());
+      const BoundResult relaxation = bound.compute();
+
+      BranchAndBound exact(builder.getGraph(), station_ids, n_stations,
+                           builder.getDist());
+      exact.setThreads(config.exact_threads);
+      exact.setTimeLimit(config.exact_time_limit);
+      exact.solve();
+
+      const SolverStatistics& statistics = exact.getStatistics();
+      cout << " CPLEX " << expected << " in " << cplex_ms
+           << " ms, Lagrangian bound " << relaxation.lower_bound << " in "
+           << relaxation.ms << " ms";
+      bool agree = relaxation.lower_bound <= expected + 1e-6;
+      if (!agree) cout << ", ABOVE THE OPTIMUM";
+
+      cout << ", branch and bound ";
+      if (exact.isOptimal()) {
+        double tour_cost = 0.0;
+        for (edge e : exact.getSolutionTour()) {
+          tour_cost += builder.getDist()[e];
+        }
+
+        cout << exact.getSolutionValue() << " in " << exact.getTime() * 1000.0
+             << " ms";
+        if (std::fabs(exact.getSolutionValue() - expected) > 1e-6 ||
+            std::fabs(tour_cost - expected) > 1e-6) {
+          cout << ", MISMATCH (tour " << tour_cost << ")";
+          agree = false;
+        }
+      } else {
+        cout << "stopped at the lower bound " << exact.getLowerBound();
+        agree = false;
+      }
+      if (!agree) failures++;
+      cout << " (" << statistics.nodes << " nodes, " << statistics.stolen_nodes
+           << " stolen)" << endl;
+    } catch (const std::runtime_error& e) {
+      cerr << "Error while cross-validating " << file << ": " << e.what()
+           << endl;
+      return 1;
+    }
+  }
+
+  cout << config.instances.size() - failures << " of "
+       << config.instances.size() << " instances agree" << endl;
+  return failures > 0 ? 1 : 0;
+}
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options] [instance ...]" << endl
+       << "Options:" << endl
+       << "  --warmup N          untimed runs per instance (default 1)" << endl
+       << "  --repetitions N     timed runs per instance (default 5)" << endl
+       << "  --list FILE         read instance paths from FILE, one per line"
+       << endl
+       << "  --generate SPEC     generate an instance, SPEC is "
+          "LAYOUT:STATIONS:LINES"
+       << endl
+       << "  --seed S            seed for the generated instances (default 1)"
+       << endl
+       << "  --change-cost X     cost for changing the line (default 5)"
+       << endl
+       << "  --switch-cost X     cost for switching the direction (default 5)"
+       << endl
+       << "  --no-preprocessing  disable the graph preprocessing" << endl
+       << "  --cut-policy P      aggregated, deaggregated (default) or "
+          "adaptive"
+       << endl
+       << "  --max-cuts N        limit the cuts per callback (default: no "
+          "limit)"
+       << endl
+       << "  --compare-cuts      compare the solve times of all cut policies"
+       << endl
+       << "  --seed-cuts MODE    none (default), lazy or rows" << endl
+       << "  --compare-seed-cuts compare the solves without and with seed "
+          "cuts"
+       << endl
+       << "  --no-cut-registry   add cuts again when they are separated again"
+       << endl
+       << "  --cut-purge N       purge cuts inactive for N callbacks" << endl
+       << "  --branch-priorities branch on changes and switches first" << endl
+       << "  --branch-weights W  priorities as RIDE,CHANGE,SWITCH,DEGREE "
+          "(default 0,10,10,1)"
+       << endl
+       << "  --line-branching    branch on visiting a station via a line"
+       << endl
+       << "  --compare-branching compare the solves with each branching rule"
+       << endl
+       << "  --cross-validate    compare the branch and bound with CPLEX"
+       << endl
+       << "  --exact-threads N   threads of the branch and bound (default: "
+          "number of cores)"
+       << endl
+       << "  --exact-time-limit MS" << endl
+       << "                      stop the branch and bound after MS "
+          "milliseconds"
+       << endl
+       << "  --heuristic N       repair the LP solution into a tour every N "
+          "heuristic callbacks"
+       << endl
+       << "  --lp-trace PREFIX   write the LP size of each callback into "
+          "PREFIX<instance>.csv"
+       << endl
+       << "  --csv FILE          write the results as CSV" << endl
+       << "  --json FILE         write the results as JSON" << endl
+       << "  --baseline FILE     compare against a CSV of an earlier run"
+       << endl
+       << "  --threshold PCT     allowed regression in percent (default 10)"
+       << endl
+       << "  --min-time MS       ignore timings below MS (default 5)" << endl
+       << "  --seeds N           variability mode, solve with N CPLEX seeds"
+       << endl
+       << "  --shuffle           also permute nodes and arcs for each seed"
+       << endl
+       << "  --reuse-cuts        start the timed runs with the cuts found by "
+          "the warmup"
+       << endl
+       << "  --startup           compare the sequential and the pipelined "
+          "startup"
+       << endl
+       << "  --record-separation PREFIX" << endl
+       << "                      record the separations of an extra run into "
+          "PREFIX<instance>.sep"
+       << endl;
+}
+
+void readInstanceList(const string& file, vector<string>* instances) {
+  std::ifstream in(file);
+  if (!in) {
+    throw std::runtime_error("Cannot open instance list " + file);
+  }
+
+  string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line[0] != '#') {
+      instances->push_back(line);
+    }
+  }
+}
+
+/**
+ * Generates a network according to spec (layout:stations:lines) and writes it
+ * into the working directory. Returns the name of the written file.
+ */
+string generateInstance(const string& spec, uint32_t seed) {
+  const size_t first = spec.find(':');
+  const size_t second = spec.find(':', first + 1);
+  if (first == string::npos || second == string::npos) {
+    throw std::runtime_error("Invalid instance specification " + spec);
+  }
+
+  GeneratorConfig generator_config;
+  generator_config.layout = parseLayout(spec.substr(0, first));
+  generator_config.stations =
+      boost::lexical_cast<int>(spec.substr(first + 1, second - first - 1));
+  generator_config.lines = boost::lexical_cast<int>(spec.substr(second + 1));
+  generator_config.seed = seed;
+
+  TransportNetwork network;
+  NetworkGenerator generator(generator_config);
+  generator.generate(&network);
+
+  std::ostringstream file;
+  file << "generated-" << spec.substr(0, first) << "-"
+       << generator_config.stations << "-" << generator_config.lines << "-"
+       << seed << ".xml";
+  writeTransportFile(network.getStations(), network.getLines(), file.str());
+
+  return file.str();
+}
+
+BenchConfig parseArguments(int argc, char* args[]) {
+  BenchConfig config;
+  vector<string> generate;
+
+  for (int i = 1; i < argc; i++) {
+    const string arg = args[i];
+    const bool has_value = i + 1 < argc;
+
+    if (arg == "--no-preprocessing") {
+      config.preprocessing = false;
+    } else if (arg == "--shuffle") {
+      config.shuffle = true;
+    } else if (arg == "--reuse-cuts") {
+      config.reuse_cuts = true;
+    } else if (arg == "--startup") {
+      config.startup = true;
+    } else if (arg == "--compare-cuts") {
+      config.compare_cuts = true;
+    } else if (arg == "--compare-seed-cuts") {
+      config.compare_seed_cuts = true;
+    } else if (arg == "--cross-validate") {
+      config.cross_validate = true;
+    } else if (arg == "--no-cut-registry") {
+      config.cut_registry = false;
+    } else if (arg.compare(0, 2, "--") != 0) {
+      config.instances.push_back(arg);
+    } else if (!has_value) {
+      throw std::runtime_error("Missing value for option " + arg);
+    } else if (arg == "--warmup") {
+      config.warmup = boost::lexical_cast<int>(args[++i]);
+    } else if (arg == "--repetitions") {
+      config.repetitions = boost::lexical_cast<int>(args[++i]);
+    } else if (arg == "--list") {
+      readInstanceList(args[++i], &config.instances);
+    } else if (arg == "--generate") {
+      generate.push_back(args[++i]);
+    } else if (arg == "--seed") {
+      config.seed = boost::lexical_cast<uint32_t>(args[++i]);
+    } else if (arg == "--change-cost") {
+      config.change_cost = boost::lexical_cast<double>(args[++i]);
+    } else if (arg == "--switch-cost") {
+      config.switch_cost = boost::lexical_cast<double>(args[++i]);
+    } else if (arg == "--cut-policy") {
+      config.cut_policy = parseCutPolicy(args[++i]);
+    } else if (arg == "--max-cuts") {
+      config.max_cuts = boost::lexical_cast<int>(args[++i]);
+    } else if (arg == "--seed-cuts") {
+      config.seed_cuts = parseSeedCuts(args[++i]);
+    } else if (arg == "--cut-purge") {
+      config.cut_purge = boost::lexical_cast<int>(args[++i]);
+    } else if (arg == "--branch-priorities") {
+      config.branch_priorities = true;
+    } else if (arg == "--branch-weights") {
+      config.branch_weights = parseBranchWeights(args[++i]);
+      config.branch_priorities = true;
+    } else if (arg == "--line-branching") {
+      config.line_branching = true;
+    } else if (arg == "--compare-branching") {
+      config.compare_branching = true;
+    } else if (arg == "--exact-threads") {
+      config.exact_threads = boost::lexical_cast<int>(args[++i]);
+    } else if (arg == "--exact-time-limit") {
+      config.exact_time_limit = boost::lexical_cast<double>(args[++i]);
+    } else if (arg == "--heuristic") {
+      config.heuristic_frequency = boost::lexical_cast<int>(args[++i]);
+    } else if (arg == "--lp-trace") {
+      config.lp_trace_prefix = args[++i];
+    } else if (arg == "--csv") {
+      config.csv_file = args[++i];
+    } else if (arg == "--json") {
+      config.json_file = args[++i];
+    } else if (arg == "--baseline") {
+      config.baseline_file = args[++i];
+    } else if (arg == "--threshold") {
+      config.threshold = boost::lexical_cast<double>(args[++i]) / 100.0;
+    } else if (arg == "--min-time") {
+      config.min_time_ms = boost::lexical_cast<double>(args[++i]);
+    } else if (arg == "--seeds") {
+      config.seeds = boost::lexical_cast<int>(args[++i]);
+    } else if (arg == "--record-separation") {
+      config.record_prefix = args[++i];
+    } else {
+      throw std::runtime_error("Unknown option " + arg);
+    }
+  }
+
+  // generate after parsing, so that the seed is independent of the order
+  for (const string& spec : generate) {
+    config.instances.push_back(generateInstance(spec, config.seed));
+  }
+
+  if (config.instances.empty()) {
+    config.instances.assign(std::begin(DEFAULT_INSTANCES),
+                            std::end(DEFAULT_INSTANCES));
+  }
+  if (config.repetitions < 1) {
+    throw std::runtime_error("At least one repetition is required");
+  }
+  if (config.reuse_cuts && config.warmup < 1) {
+    throw std::runtime_error("--reuse-cuts requires at least one warmup run");
+  }
+  if (config.shuffle && config.seeds < 1) {
+    throw std::runtime_error("--shuffle requires --seeds");
+  }
+  if (config.seeds > 0 && !config.baseline_file.empty()) {
+    throw std::runtime_error("--baseline is not supported with --seeds");
+  }
+  if (config.startup && (config.seeds > 0 || !config.baseline_file.empty())) {
+    throw std::runtime_error("--startup is a separate mode");
+  }
+  if (config.compare_cuts && (config.seeds > 0 || config.startup ||
+                              !config.baseline_file.empty())) {
+    throw std::runtime_error("--compare-cuts is a separate mode");
+  }
+  if (config.compare_seed_cuts &&
+      (config.seeds > 0 || config.startup || config.compare_cuts ||
+       !config.baseline_file.empty())) {
+    throw std::runtime_error("--compare-seed-cuts is a separate mode");
+  }
+  if (config.compare_branching &&
+      (config.seeds > 0 || config.startup || config.compare_cuts ||
+       config.compare_seed_cuts || !config.baseline_file.empty())) {
+    throw std::runtime_error("--compare-branching is a separate mode");
+  }
+  if (config.cross_validate &&
+      (config.seeds > 0 || config.startup || config.compare_cuts ||
+       config.compare_seed_cuts || config.compare_branching ||
+       !config.baseline_file.empty())) {
+    throw std::runtime_error("--cross-validate is a separate mode");
+  }
+
+  return config;
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  BenchConfig config;
+  try {
+    config = parseArguments(argc, args);
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  if (config.seeds > 0) {
+    return runVariability(config);
+  }
+  if (config.startup) {
+    return runStartup(config);
+  }
+  if (config.compare_cuts) {
+    return runCutPolicies(config);
+  }
+  if (config.compare_seed_cuts) {
+    return runSeedCuts(config);
+  }
+  if (config.compare_branching) {
+    return runBranching(config);
+  }
+  if (config.cross_validate) {
+    return runCrossValidation(config);
+  }
+
+  vector<BenchRecord> records;
+  for (const string& file : config.instances) {
+    cout << "Benchmarking " << file << "..." << endl;
+    try {
+      records.push_back(benchmarkInstance(file, config));
+    } catch (const std::runtime_error& e) {
+      cerr << "Error while benchmarking " << file << ": " << e.what() << endl;
+      return 1;
+    }
+
+    const BenchRecord& r = records.back();
+    cout << " total " << r.total_ms << " ms (parse " << r.parse_ms
+         << ", build " << r.build_ms << ", model " << r.model_ms << ", solve "
+         << r.solve_ms << "), " << r.variables << " variables, " << r.rows
+         << " rows, " << r.lazy_cuts << " lazy cuts in " << r.callback_calls
+         << " callbacks (" << r.duplicate_cuts << " duplicates skipped, LP "
+         << "up to " << r.max_lp_rows << " rows), " << r.bb_nodes
+         << " nodes, objective " << r.objective;
+    if (r.heuristic_calls > 0) {
+      cout << ", " << r.improved_tours << " of " << r.heuristic_calls
+           << " repairs improved the incumbent";
+    }
+    cout << endl;
+  }
+
+  if (!config.csv_file.empty()) {
+    std::ofstream out(config.csv_file);
+    writeCsv(records, out);
+  }
+  if (!config.json_file.empty()) {
+    std::ofstream out(config.json_file);
+    writeJson(records, out);
+  }
+
+  if (!config.baseline_file.empty()) {
+    std::ifstream in(config.baseline_file);
+    if (!in) {
+      cerr << "Cannot open baseline file " << config.baseline_file << endl;
+      return 1;
+    }
+
+    try {
+      const vector<BenchRecord> baseline = readCsv(in);
+      if (compareWithBaseline(records, baseline, config.threshold,
+                              config.min_time_ms) > 0) {
+        return 2;
+      }
+    } catch (const std::runtime_error& e) {
+      cerr << "Error: " << e.what() << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,244 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "daemon/protocol.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using std::string;
+
+namespace {
+
+/** Reads exactly n bytes, returns the number of bytes read before EOF. */
+size_t readFully(int fd, char* buffer, size_t n) {
+  size_t done = 0;
+  while (done < n) {
+    const ssize_t count = read(fd, buffer + done, n - done);
+    if (count == 0) break;
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error(string("Cannot read message: ") +
+                               strerror(errno));
+    }
+    done += count;
+  }
+
+  return done;
+}
+
+void writeFully(int fd, const char* buffer, size_t n) {
+  size_t done = 0;
+  while (done < n) {
+    // a vanished client must not kill the daemon with SIGPIPE
+    const ssize_t count = send(fd, buffer + done, n - done, MSG_NOSIGNAL);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error(string("Cannot write message: ") +
+                               strerror(errno));
+    }
+    done += count;
+  }
+}
+
+sockaddr_un getAddress(const string& path) {
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + path);
+  }
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  return address;
+}
+}  // namespace
+
+bool readMessage(int fd, std::string* message) {
+  uint32_t length;
+  const size_t header = readFully(fd, reinterpret_cast<char*>(&length), 4);
+  if (header == 0) return false;
+  if (header < 4) throw std::runtime_error("Truncated message header");
+
+  length = ntohl(length);
+  if (length > MAX_MESSAGE_SIZE) {
+    std::ostringstream errBuf;
+    errBuf << "Message of " << length << " bytes exceeds the limit";
+    throw std::runtime_error(errBuf.str());
+  }
+
+  message->resize(length);
+  if (readFully(fd, &(*message)[0], length) < length) {
+    throw std::runtime_error("Truncated message");
+  }
+
+  return true;
+}
+
+void writeMessage(int fd, const std::string& message) {
+  if (message.size() > MAX_MESSAGE_SIZE) {
+    throw std::runtime_error("Message exceeds the size limit");
+  }
+
+  const uint32_t length = htonl(message.size());
+  writeFully(fd, reinterpret_cast<const char*>(&length), 4);
+  writeFully(fd, message.data(), message.size());
+}
+
+int listenUnixSocket(const std::string& path, int backlog) {
+  const sockaddr_un address = getAddress(path);
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw std::runtime_error(string("Cannot create socket: ") +
+                             strerror(errno));
+  }
+
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(fd, backlog) != 0) {
+    const string error = strerror(errno);
+    close(fd);
+    throw std::runtime_error("Cannot listen on " + path + ": " + error);
+  }
+
+  return fd;
+}
+
+int connectUnixSocket(const std::string& path) {
+  const sockaddr_un address = getAddress(path);
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw std::runtime_error(string("Cannot create socket: ") +
+                             strerror(errno));
+  }
+
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    const string error = strerror(errno);
+    close(fd);
+    throw std::runtime_error("Cannot connect to " + path + ": " + error);
+  }
+
+  return fd;
+}
+
+int listenTcpSocket(const std::string& host, int* port, int backlog) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+
+  addrinfo* addresses;
+  const string service = std::to_string(*port);
+  const int status =
+      getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses);
+  if (status != 0) {
+    throw std::runtime_error("Cannot resolve " + host + ": " +
+                             gai_strerror(status));
+  }
+
+  int fd = -1;
+  string error = "no address";
+  for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) {
+      error = strerror(errno);
+      continue;
+    }
+
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, a->ai_addr, a->ai_addrlen) != 0 || listen(fd, backlog) != 0) {
+      error = strerror(errno);
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+
+  sockaddr_storage address;
+  socklen_t length = sizeof(address);
+  if (fd >= 0 &&
+      getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+    error = strerror(errno);
+    close(fd);
+    fd = -1;
+  }
+  if (fd < 0) {
+    std::ostringstream errBuf;
+    errBuf << "Cannot listen on " << host << ":" << *port << ": " << error;
+    throw std::runtime_error(errBuf.str());
+  }
+
+  if (address.ss_family == AF_INET6) {
+    *port = ntohs(reinterpret_cast<const sockaddr_in6*>(&address)->sin6_port);
+  } else {
+    *port = ntohs(reinterpret_cast<const sockaddr_in*>(&address)->sin_port);
+  }
+
+  return fd;
+}
+
+int connectTcpSocket(const std::string& host, int port) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* addresses;
+  const string service = std::to_string(port);
+  const int status =
+      getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses);
+  if (status != 0) {
+    throw std::runtime_error("Cannot resolve " + host + ": " +
+                             gai_strerror(status));
+  }
+
+  int fd = -1;
+  for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+
+  if (fd < 0) {
+    std::ostringstream errBuf;
+    errBuf << "Cannot connect to " << host << ":" << port;
+    throw std::runtime_error(errBuf.str());
+  }
+
+  // requests and responses are small, do not wait to fill packets
+  const int no_delay = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+  return fd;
+}
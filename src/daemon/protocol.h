@@ -0,0 +1,60 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_DAEMON_PROTOCOL_H_
+#define UBAHN_DAEMON_PROTOCOL_H_
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Every message between the daemon and its clients is a 4 byte length in
+ * network byte order followed by that many bytes of payload. A connection
+ * can carry any number of request/response pairs.
+ */
+
+/// larger messages are rejected to protect against corrupt length fields
+const uint32_t MAX_MESSAGE_SIZE = 64 * 1024 * 1024;
+
+/**
+ * Reads one message. Returns false if the connection was closed before the
+ * message started, throws an exception on all other errors.
+ */
+bool readMessage(int fd, std::string* message);
+
+/** Writes one message, throws an exception if that fails. */
+void writeMessage(int fd, const std::string& message);
+
+/**
+ * Creates a Unix domain socket listening at the given path. An existing file
+ * at that path is removed first. Throws an exception if that fails.
+ */
+int listenUnixSocket(const std::string& path, int backlog);
+
+/** Connects to the Unix domain socket, throws an exception on failure. */
+int connectUnixSocket(const std::string& path);
+
+/**
+ * Creates a TCP socket listening on the address of the host, "0.0.0.0" or
+ * "::" for all interfaces. If the port is 0, a free port is chosen and
+ * stored. Throws an exception on failure.
+ */
+int listenTcpSocket(const std::string& host, int* port, int backlog);
+
+/** Connects to the TCP port of the host, throws an exception on failure. */
+int connectTcpSocket(const std::string& host, int port);
+
+#endif  // UBAHN_DAEMON_PROTOCOL_H_
@@ -0,0 +1,378 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "daemon/sharding.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "daemon/protocol.h"
+#include "io/xml_reader.h"
+#include "io/xml_writer.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+typedef std::chrono::steady_clock t_clock;
+
+/// how often waiting threads look for stragglers and new workers
+const int POLL_MS = 100;
+
+/// scenarios are never duplicated before they ran this long
+const double MIN_SPECULATION_MS = 1000.0;
+
+/** Removes tabs and line breaks, which separate the fields of messages. */
+string toField(string text) {
+  std::replace(text.begin(), text.end(), '\t', ' ');
+  std::replace(text.begin(), text.end(), '\n', ' ');
+  return text;
+}
+
+string encodeResult(int index, const ScenarioResult& r) {
+  std::ostringstream message;
+  message << std::setprecision(17) << "result\t" << index << '\t'
+          << r.solved << '\t' << r.objective << '\t' << r.solve_ms << '\t'
+          << r.statistics.nodes << '\t' << r.statistics.lazy_cuts << '\t'
+          << r.statistics.callback_calls << '\t' << r.statistics.pooled_cuts
+          << '\t' << toField(r.error) << '\n'
+          << r.tour;
+  return message.str();
+}
+
+/** Decodes a result message, throws an exception if it is invalid. */
+int decodeResult(const string& message, ScenarioResult* r) {
+  const size_t end = message.find('\n');
+  std::istringstream header(message.substr(0, end));
+
+  vector<string> fields;
+  string field;
+  while (std::getline(header, field, '\t')) {
+    fields.push_back(field);
+  }
+  if (fields.size() < 9 || fields[0] != "result") {
+    throw std::runtime_error("Invalid result message");
+  }
+
+  try {
+    r->solved = fields[2] == "1";
+    r->objective = boost::lexical_cast<double>(fields[3]);
+    r->solve_ms = boost::lexical_cast<double>(fields[4]);
+    r->statistics.nodes = boost::lexical_cast<long>(fields[5]);
+    r->statistics.lazy_cuts = boost::lexical_cast<int>(fields[6]);
+    r->statistics.callback_calls = boost::lexical_cast<int>(fields[7]);
+    r->statistics.pooled_cuts = boost::lexical_cast<int>(fields[8]);
+    r->error = fields.size() > 9 ? fields[9] : "";
+    r->tour = end == string::npos ? "" : message.substr(end + 1);
+
+    return boost::lexical_cast<int>(fields[1]);
+  } catch (const boost::bad_lexical_cast&) {
+    throw std::runtime_error("Invalid number in result message");
+  }
+}
+
+double elapsedMs(t_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(t_clock::now() - start)
+      .count();
+}
+
+string createSnapshot(const t_stationmap& stations, const t_linemap& lines) {
+  std::ostringstream xml;
+  writeTransportFile(stations, lines, xml);
+  return xml.str();
+}
+}  // namespace
+
+void runShardWorker(const string& host, int port) {
+  const int fd = connectTcpSocket(host, port);
+
+  XMLReader reader;
+  std::unique_ptr<ScenarioSession> session;
+  vector<CostScenario> scenarios;
+
+  try {
+    string message;
+    while (readMessage(fd, &message)) {
+      const size_t tab = message.find('\t');
+      const string command = message.substr(0, tab);
+
+      if (command == "stop") {
+        break;
+      } else if (command == "network" && !session) {
+        const size_t end = message.find('\n');
+        try {
+          reader.readTransportBuffer(message.substr(end + 1));
+          session.reset(new ScenarioSession(
+              reader.getStations(), reader.getLines(),
+              message.compare(tab + 1, end - tab - 1, "1") == 0));
+          writeMessage(fd, "ready");
+        } catch (const std::runtime_error& e) {
+          writeMessage(fd, "error\t" + toField(e.what()));
+        }
+      } else if (command == "scenario" && session) {
+        const size_t second = message.find('\t', tab + 1);
+        const int index = boost::lexical_cast<int>(
+            message.substr(tab + 1, second - tab - 1));
+
+        std::istringstream line(message.substr(second + 1));
+        scenarios = readScenarios(line);
+        if (scenarios.size() != 1) {
+          throw std::runtime_error("Invalid scenario message");
+        }
+        writeMessage(fd, encodeResult(index, session->solve(scenarios[0])));
+      } else {
+        throw std::runtime_error("Unexpected message " + command);
+      }
+    }
+  } catch (const std::exception&) {
+    close(fd);
+    throw;
+  }
+
+  close(fd);
+}
+
+ShardCoordinator::ShardCoordinator(const t_stationmap& stations,
+                                   const t_linemap& lines, bool preprocess)
+    : _network(createSnapshot(stations, lines)),
+      _preprocess(preprocess),
+      _listen_fd(-1),
+      _speculation(3.0),
+      _workers_expected([] { return true; }),
+      _scenarios(nullptr),
+      _remaining(0) {}
+
+ShardCoordinator::~ShardCoordinator() {
+  if (_listen_fd >= 0) close(_listen_fd);
+}
+
+int ShardCoordinator::listen(const string& host, int port) {
+  _listen_fd = listenTcpSocket(host, &port, SOMAXCONN);
+  return port;
+}
+
+vector<ScenarioResult> ShardCoordinator::run(
+    const vector<CostScenario>& scenarios) {
+  if (_listen_fd < 0) {
+    throw std::runtime_error("The coordinator is not listening");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _scenarios = &scenarios;
+    _states.assign(scenarios.size(), ScenarioState());
+    _results.assign(scenarios.size(), ScenarioResult());
+    _durations.clear();
+    _remaining = scenarios.size();
+
+    // the first scenario is dispatched first
+    _pending.clear();
+    for (size_t i = scenarios.size(); i-- > 0;) {
+      _pending.push_back(i);
+    }
+  }
+
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_remaining == 0) break;
+
+      if (_assignments.empty() && !_workers_expected()) {
+        for (size_t i = 0; i < _states.size(); i++) {
+          if (!_states[i].done) {
+            _results[i].name = scenarios[i].name;
+            _results[i].error = "No workers left";
+          }
+        }
+        _remaining = 0;
+        break;
+      }
+    }
+
+    pollfd listen_poll;
+    listen_poll.fd = _listen_fd;
+    listen_poll.events = POLLIN;
+    if (poll(&listen_poll, 1, POLL_MS) <= 0) continue;
+
+    const int fd = accept(_listen_fd, nullptr, nullptr);
+    if (fd < 0) continue;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _assignments[fd] = -1;
+    _threads.emplace_back(&ShardCoordinator::serveWorker, this, fd);
+  }
+
+  // idle workers are stopped, the slower copies of duplicated scenarios are
+  // cut off instead of waiting for them
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& assignment : _assignments) {
+      if (assignment.second >= 0) {
+        shutdown(assignment.first, SHUT_RDWR);
+      }
+    }
+  }
+  _changed.notify_all();
+  for (std::thread& thread : _threads) {
+    thread.join();
+  }
+  _threads.clear();
+
+  for (size_t i = 0; i < scenarios.size(); i++) {
+    _results[i].name = scenarios[i].name;
+  }
+  return _results;
+}
+
+void ShardCoordinator::serveWorker(int fd) {
+  int index = -1;
+  t_clock::time_point started;
+
+  try {
+    writeMessage(fd, string("network\t") + (_preprocess ? "1" : "0") + "\n" +
+                         _network);
+    string response;
+    if (!readMessage(fd, &response) || response != "ready") {
+      throw std::runtime_error("Worker rejected the network: " + response);
+    }
+
+    while ((index = nextAssignment(fd)) >= 0) {
+      started = t_clock::now();
+      writeMessage(fd, "scenario\t" + std::to_string(index) + "\t" +
+                           formatScenario((*_scenarios)[index]));
+
+      if (!readMessage(fd, &response)) {
+        throw std::runtime_error("Worker disconnected");
+      }
+
+      ScenarioResult result;
+      if (decodeResult(response, &result) != index) {
+        throw std::runtime_error("Worker answered the wrong scenario");
+      }
+      finishAssignment(fd, index, result, elapsedMs(started));
+      index = -1;
+    }
+
+    writeMessage(fd, "stop");
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Lost a worker: " << e.what() << std::endl;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  close(fd);
+  _assignments.erase(fd);
+  if (index >= 0) {
+    // the scenario is given to the next worker, unless it kills them all
+    ScenarioState& state = _states[index];
+    state.running--;
+    if (!state.done && state.running == 0) {
+      if (++state.failures < MAX_ATTEMPTS) {
+        _pending.push_back(index);
+      } else {
+        state.done = true;
+        _results[index].error = "Workers died while solving the scenario";
+        _remaining--;
+      }
+    }
+  }
+  _changed.notify_all();
+}
+
+int ShardCoordinator::nextAssignment(int fd) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_remaining > 0) {
+    while (!_pending.empty()) {
+      const int index = _pending.back();
+      _pending.pop_back();
+
+      ScenarioState& state = _states[index];
+      if (state.done) continue;
+      state.running++;
+      state.started = t_clock::now();
+      _assignments[fd] = index;
+      return index;
+    }
+
+    const int straggler = findStraggler();
+    if (straggler >= 0) {
+      _states[straggler].running++;
+      _assignments[fd] = straggler;
+      return straggler;
+    }
+
+    _changed.wait_for(lock, std::chrono::milliseconds(POLL_MS));
+  }
+
+  return -1;
+}
+
+int ShardCoordinator::findStraggler() const {
+  if (_speculation <= 0 || _durations.empty()) return -1;
+
+  vector<double> durations = _durations;
+  std::nth_element(durations.begin(),
+                   durations.begin() + durations.size() / 2, durations.end());
+  const double limit = std::max(
+      MIN_SPECULATION_MS, _speculation * durations[durations.size() / 2]);
+
+  // only scenarios that are not duplicated yet are considered
+  int straggler = -1;
+  double longest = limit;
+  for (size_t i = 0; i < _states.size(); i++) {
+    const ScenarioState& state = _states[i];
+    if (state.done || state.running != 1) continue;
+
+    const double elapsed = elapsedMs(state.started);
+    if (elapsed > longest) {
+      longest = elapsed;
+      straggler = i;
+    }
+  }
+
+  return straggler;
+}
+
+void ShardCoordinator::finishAssignment(int fd, int index,
+                                        const ScenarioResult& result,
+                                        double elapsed_ms) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _assignments[fd] = -1;
+  ScenarioState& state = _states[index];
+  state.running--;
+  _durations.push_back(elapsed_ms);
+
+  // the slower copy of a duplicated scenario is ignored
+  if (!state.done) {
+    state.done = true;
+    _results[index] = result;
+    _remaining--;
+    _changed.notify_all();
+  }
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_DAEMON_SHARDING_H_
+#define UBAHN_DAEMON_SHARDING_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "solver/scenario_runner.h"
+#include "transport_defs.h"
+
+/*
+ * Distributes cost scenarios over worker processes, which may run on other
+ * machines. The coordinator listens on a TCP port and sends each connecting
+ * worker a snapshot of the network in XML, then one scenario at a time. The
+ * messages use the length prefixed framing of daemon/protocol.h:
+ *   coordinator: "network\tPREPROCESS\nXML", "scenario\tINDEX\tLINE", "stop"
+ *   worker:      "ready", "error\tMESSAGE", "result\tINDEX\t...\nTOUR"
+ */
+
+/**
+ * Connects to the coordinator and solves the scenarios it sends until it is
+ * told to stop. Throws an exception if the connection fails.
+ */
+void runShardWorker(const std::string& host, int port);
+
+class ShardCoordinator {
+ public:
+  /// scenarios whose workers died this often are reported as failed
+  static const int MAX_ATTEMPTS = 3;
+
+  ShardCoordinator(const t_stationmap& stations, const t_linemap& lines,
+                   bool preprocess = true);
+  ~ShardCoordinator();
+
+  // disallow copy and assign
+  ShardCoordinator(const ShardCoordinator&) = delete;
+  void operator=(ShardCoordinator) = delete;
+
+  /**
+   * Listens on the port (0 for any free port) of the host address and returns
+   * the port. The coordinator accepts anyone who connects, so it should only
+   * listen on other interfaces than loopback in a trusted network.
+   */
+  int listen(const std::string& host, int port);
+
+  /**
+   * A scenario that runs longer than factor times the median time of the
+   * finished ones is given to an idle worker as well, the first result wins.
+   * Set to 0 to disable. The default is 3.
+   */
+  void setSpeculation(double factor) { _speculation = factor; }
+
+  /**
+   * Sets a function that is called while no worker is connected. If it
+   * returns false, no worker will come and all open scenarios fail.
+   */
+  void setWorkersExpected(std::function<bool()> expected) {
+    _workers_expected = expected;
+  }
+
+  /**
+   * Solves all scenarios on the workers that connect to the port and returns
+   * the results in the order of the scenarios.
+   */
+  std::vector<ScenarioResult> run(const std::vector<CostScenario>& scenarios);
+
+ private:
+  struct ScenarioState {
+    ScenarioState() : done(false), running(0), failures(0) {}
+
+    bool done;
+    int running;   ///< number of workers currently solving it
+    int failures;  ///< number of workers that died while solving it
+    std::chrono::steady_clock::time_point started;
+  };
+
+  void serveWorker(int fd);
+  /** Waits for the next scenario to solve, returns -1 when all are done. */
+  int nextAssignment(int fd);
+  /** Returns a long running scenario that should be duplicated, or -1. */
+  int findStraggler() const;
+  void finishAssignment(int fd, int index, const ScenarioResult& result,
+                        double elapsed_ms);
+
+  const std::string _network;  ///< the snapshot sent to every worker
+  const bool _preprocess;
+  int _listen_fd;
+  double _speculation;
+  std::function<bool()> _workers_expected;
+
+  std::vector<std::thread> _threads;
+
+  /// guards all members below
+  std::mutex _mutex;
+  std::condition_variable _changed;
+  const std::vector<CostScenario>* _scenarios;
+  std::vector<ScenarioState> _states;
+  std::vector<ScenarioResult> _results;
+  std::vector<int> _pending;  ///< the scenarios to dispatch, last one first
+  std::vector<double> _durations;
+  size_t _remaining;
+
+  /// the scenario each connected worker is solving, -1 if it is idle
+  std::map<int, int> _assignments;
+};
+
+#endif  // UBAHN_DAEMON_SHARDING_H_
@@ -0,0 +1,386 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "daemon/solver_daemon.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/timer.h"
+#include "base/utils.h"
+#include "daemon/protocol.h"
+#include "solver/closure_runner.h"
+
+using std::string;
+using std::unique_ptr;
+
+namespace {
+
+const char BUSY_RESPONSE[] = "{\"status\": \"busy\"}";
+
+const size_t DEFAULT_MAX_NETWORKS = 8;
+
+string errorResponse(const string& error) {
+  return "{\"status\": \"error\", \"error\": " + quoteJson(error) + "}";
+}
+
+/** Identifies the sessions of a network that can be shared by requests. */
+string getSessionKey(const DaemonRequest& request) {
+  // all digits, requests differing in any cost need sessions of their own
+  std::ostringstream key;
+  key << std::setprecision(17) << request.change_cost << '\t'
+      << request.switch_cost << '\t' << request.preprocess;
+  return key.str();
+}
+}  // namespace
+
+DaemonRequest parseRequest(const string& payload) {
+  std::istringstream fields(payload);
+  DaemonRequest request;
+  std::getline(fields, request.command, '\t');
+
+  if (request.command != "ping" && request.command != "stats" &&
+      request.command != "solve" && request.command != "whatif") {
+    throw std::runtime_error("Unknown command " + request.command);
+  }
+
+  string field;
+  while (std::getline(fields, field, '\t')) {
+    if (field.empty()) continue;
+    if (request.command == "whatif" &&
+        parseClosureField(field, &request.closure)) {
+      continue;
+    }
+
+    const size_t eq = field.find('=');
+    const string key = field.substr(0, eq);
+    const string value = eq == string::npos ? "" : field.substr(eq + 1);
+    try {
+      if (key == "network" && !value.empty()) {
+        request.network = value;
+      } else if (key == "change") {
+        request.change_cost = boost::lexical_cast<double>(value);
+      } else if (key == "switch") {
+        request.switch_cost = boost::lexical_cast<double>(value);
+      } else if (key == "preprocess" && (value == "on" || value == "off")) {
+        request.preprocess = value == "on";
+      } else {
+        throw std::runtime_error("");
+      }
+    } catch (const std::exception&) {
+      throw std::runtime_error("Invalid field " + field);
+    }
+  }
+
+  if ((request.command == "solve" || request.command == "whatif") &&
+      request.network.empty()) {
+    throw std::runtime_error("Missing network");
+  }
+
+  return request;
+}
+
+SolverDaemon::SolverDaemon(int workers, size_t queue_size,
+                           int max_connections)
+    : _queue(queue_size),
+      _max_connections(max_connections),
+      _requests(0),
+      _rejected(0),
+      _max_networks(DEFAULT_MAX_NETWORKS),
+      _network_uses(0) {
+  for (int i = 0; i < workers; i++) {
+    _workers.emplace_back(&SolverDaemon::runWorker, this);
+  }
+}
+
+SolverDaemon::~SolverDaemon() {
+  // the connection threads are detached, wait until all of them are done
+  {
+    std::unique_lock<std::mutex> lock(_connections_mutex);
+    for (int fd : _connections) {
+      shutdown(fd, SHUT_RDWR);
+    }
+    _connections_closed.wait(lock, [this] { return _connections.empty(); });
+  }
+
+  _queue.close();
+  for (std::thread& worker : _workers) {
+    worker.join();
+  }
+}
+
+void SolverDaemon::preload(const DaemonRequest& request) {
+  std::shared_ptr<CachedNetwork> network = getNetwork(request.network);
+  bool warm;
+  releaseSession(request, network, acquireSession(request, network, &warm));
+}
+
+void SolverDaemon::serve(const string& socket_path) {
+  const int listen_fd = listenUnixSocket(socket_path, _max_connections);
+
+  while (true) {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+
+      const string error = strerror(errno);
+      close(listen_fd);
+      throw std::runtime_error("Cannot accept connections: " + error);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_connections_mutex);
+      if (_connections.size() < _max_connections) {
+        _connections.insert(fd);
+        std::thread(&SolverDaemon::handleConnection, this, fd).detach();
+        continue;
+      }
+    }
+
+    try {
+      writeMessage(fd, BUSY_RESPONSE);
+    } catch (const std::runtime_error&) {
+      // the client is gone already
+    }
+    close(fd);
+  }
+}
+
+void SolverDaemon::handleConnection(int fd) {
+  try {
+    string payload;
+    while (readMessage(fd, &payload)) {
+      _requests++;
+
+      string response;
+      try {
+        std::shared_ptr<Task> task = std::make_shared<Task>();
+        task->request = parseRequest(payload);
+
+        std::future<string> result = task->response.get_future();
+        if (_queue.tryPush(task)) {
+          response = result.get();
+        } else {
+          _rejected++;
+          response = BUSY_RESPONSE;
+        }
+      } catch (const std::runtime_error& e) {
+        response = errorResponse(e.what());
+      }
+
+      writeMessage(fd, response);
+    }
+  } catch (const std::runtime_error&) {
+    // broken connections only affect their own client
+  }
+
+  std::unique_lock<std::mutex> lock(_connections_mutex);
+  _connections.erase(fd);
+  close(fd);
+  std::notify_all_at_thread_exit(_connections_closed, std::move(lock));
+}
+
+void SolverDaemon::runWorker() {
+  std::shared_ptr<Task> task;
+  while (_queue.pop(&task)) {
+    try {
+      task->response.set_value(process(task->request));
+    } catch (const std::exception& e) {
+      task->response.set_value(errorResponse(e.what()));
+    }
+  }
+}
+
+string SolverDaemon::process(const DaemonRequest& request) {
+  if (request.command == "ping") {
+    return "{\"status\": \"ok\"}";
+  }
+
+  if (request.command == "stats") {
+    int sessions = 0;
+    std::lock_guard<std::mutex> lock(_networks_mutex);
+    for (const auto& network : _networks) {
+      std::lock_guard<std::mutex> network_lock(network.second->mutex);
+      for (const auto& idle : network.second->idle) {
+        sessions += idle.second.size();
+      }
+    }
+
+    std::ostringstream response;
+    response << "{\"status\": \"ok\", \"networks\": " << _networks.size()
+             << ", \"idle_sessions\": " << sessions
+             << ", \"queued\": " << _queue.size()
+             << ", \"requests\": " << _requests
+             << ", \"rejected\": " << _rejected << "}";
+    return response.str();
+  }
+
+  return solve(request);
+}
+
+string SolverDaemon::solve(const DaemonRequest& request) {
+  Timer timer;
+  std::shared_ptr<CachedNetwork> network = getNetwork(request.network);
+  bool warm;
+  unique_ptr<SolverSession> session = acquireSession(request, network, &warm);
+  const double setup_ms =
+      timer.Elapsed<std::chrono::duration<double, std::milli>>().count();
+
+  std::ostringstream response;
+  try {
+    // a solve request lifts the closure of an earlier what-if request
+    session->setClosure(request.closure);
+
+    timer.Reset();
+    timer.Start();
+    session->solve();
+    const double solve_ms =
+        timer.Elapsed<std::chrono::duration<double, std::milli>>().count();
+
+    std::ostringstream tour;
+    session->getBuilder().printTour(session->getSolutionTour(), true, tour);
+
+    const SolverStatistics& statistics = session->getStatistics();
+    response << "{\"status\": \"ok\", \"objective\": "
+             << session->getSolutionValue()
+             << ", \"warm\": " << (warm ? "true" : "false")
+             << ", \"setup_ms\": " << setup_ms
+             << ", \"solve_ms\": " << solve_ms
+             << ", \"bb_nodes\": " << statistics.nodes
+             << ", \"lazy_cuts\": " << statistics.lazy_cuts
+             << ", \"pooled_cuts\": " << statistics.pooled_cuts
+             << ", \"tour\": " << quoteJson(tour.str()) << "}";
+  } catch (const std::runtime_error&) {
+    releaseSession(request, network, std::move(session));
+    throw;
+  }
+
+  releaseSession(request, network, std::move(session));
+  return response.str();
+}
+
+std::shared_ptr<SolverDaemon::CachedNetwork> SolverDaemon::getNetwork(
+    const string& file) {
+  struct stat info;
+  if (stat(file.c_str(), &info) != 0) {
+    throw std::runtime_error("Cannot read network file " + file);
+  }
+  const int64_t mtime_ns =
+      info.st_mtim.tv_sec * INT64_C(1000000000) + info.st_mtim.tv_nsec;
+
+  std::shared_ptr<CachedNetwork> network;
+  {
+    std::lock_guard<std::mutex> lock(_networks_mutex);
+    std::shared_ptr<CachedNetwork>& entry = _networks[file];
+
+    // requests still using a replaced network keep it until they are done
+    if (!entry || entry->mtime_ns != mtime_ns || entry->size != info.st_size) {
+      entry = std::make_shared<CachedNetwork>();
+      entry->mtime_ns = mtime_ns;
+      entry->size = info.st_size;
+    }
+    entry->last_use = ++_network_uses;
+    network = entry;
+
+    evictNetworks();
+  }
+
+  // concurrent requests for the same network wait for the first reader
+  string error;
+  {
+    std::lock_guard<std::mutex> lock(network->mutex);
+    if (network->reader) return network;
+
+    unique_ptr<XMLReader> reader(new XMLReader());
+    try {
+      reader->readTransportFile(file);
+      network->reader = std::move(reader);
+      return network;
+    } catch (const std::runtime_error& e) {
+      error = e.what();
+    }
+  }
+
+  // invalid files are not kept, they may be fixed for the next request; the
+  // network is unlocked first, as "stats" locks the networks the other way
+  {
+    std::lock_guard<std::mutex> lock(_networks_mutex);
+    auto pos = _networks.find(file);
+    if (pos != _networks.end() && pos->second == network) {
+      _networks.erase(pos);
+    }
+  }
+  throw std::runtime_error(error);
+}
+
+/** Drops the least recently used networks, _networks_mutex must be held. */
+void SolverDaemon::evictNetworks() {
+  while (_networks.size() > _max_networks) {
+    auto oldest = _networks.begin();
+    for (auto it = _networks.begin(); it != _networks.end(); ++it) {
+      if (it->second->last_use < oldest->second->last_use) {
+        oldest = it;
+      }
+    }
+    _networks.erase(oldest);
+  }
+}
+
+unique_ptr<SolverSession> SolverDaemon::acquireSession(
+    const DaemonRequest& request, const std::shared_ptr<CachedNetwork>& network,
+    bool* warm) {
+  {
+    std::lock_guard<std::mutex> lock(network->mutex);
+    auto& idle = network->idle[getSessionKey(request)];
+    if (!idle.empty()) {
+      unique_ptr<SolverSession> session = std::move(idle.back());
+      idle.pop_back();
+      *warm = true;
+      return session;
+    }
+  }
+
+  // the reader is never replaced, so sessions can be built without the lock
+  *warm = false;
+  unique_ptr<SolverSession> session(new SolverSession(
+      network->reader->getStations(), network->reader->getLines(),
+      request.change_cost, request.switch_cost, request.preprocess));
+  session->setVerbose(false);
+
+  return session;
+}
+
+/**
+ * Returns the session to the network it was built for, which may no longer
+ * be cached if the file changed or the network was evicted meanwhile.
+ */
+void SolverDaemon::releaseSession(
+    const DaemonRequest& request, const std::shared_ptr<CachedNetwork>& network,
+    unique_ptr<SolverSession> session) {
+  std::lock_guard<std::mutex> lock(network->mutex);
+  network->idle[getSessionKey(request)].push_back(std::move(session));
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_DAEMON_SOLVER_DAEMON_H_
+#define UBAHN_DAEMON_SOLVER_DAEMON_H_
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/bounded_queue.h"
+#include "io/xml_reader.h"
+#include "solver/solver_session.h"
+
+/**
+ * A request to the daemon. The payload consists of tab separated fields, the
+ * command followed by key=value options:
+ *   ping
+ *   stats
+ *   solve   network=FILE [change=COST] [switch=COST] [preprocess=on|off]
+ *   whatif  network=FILE [...] [station=NAME ...] [segment=LINE|FROM|TO ...]
+ */
+struct DaemonRequest {
+  DaemonRequest() : change_cost(5.0), switch_cost(5.0), preprocess(true) {}
+
+  std::string command;
+  std::string network;
+  double change_cost;
+  double switch_cost;
+  bool preprocess;
+  Closure closure;  ///< only used by whatif
+};
+
+/** Parses the payload of a request, throws an exception if it is invalid. */
+DaemonRequest parseRequest(const std::string& payload);
+
+/**
+ * Answers solve and what-if requests over a Unix domain socket. Parsed
+ * networks and solver sessions stay in memory between requests, so repeated
+ * requests only pay for the solve itself, warm-started from the previous
+ * tour and with the subtour cuts found so far. A network is read again when
+ * the modification time or size of its file changed.
+ *
+ * Each connection is served by its own thread, which puts the requests into
+ * a bounded queue processed by a fixed number of workers. When the queue is
+ * full, the request is answered with status "busy" right away.
+ */
+class SolverDaemon {
+ public:
+  SolverDaemon(int workers, size_t queue_size, int max_connections);
+  ~SolverDaemon();
+
+  // disallow copy and assign
+  SolverDaemon(const SolverDaemon&) = delete;
+  void operator=(SolverDaemon) = delete;
+
+  /**
+   * Limits the number of networks kept in memory, the least recently used
+   * one and its sessions are dropped first. The default is 8.
+   */
+  void setMaxNetworks(size_t networks) { _max_networks = networks; }
+
+  /** Reads the network and builds a session, throws if that fails. */
+  void preload(const DaemonRequest& request);
+
+  /** Accepts connections on the socket, only returns by an exception. */
+  void serve(const std::string& socket_path);
+
+ private:
+  struct Task {
+    DaemonRequest request;
+    std::promise<std::string> response;
+  };
+
+  /// a parsed network together with its idle sessions for each cost setting
+  struct CachedNetwork {
+    CachedNetwork() : mtime_ns(0), size(0), last_use(0) {}
+
+    /// the state of the file when it was read, a changed file is read again
+    int64_t mtime_ns;
+    int64_t size;
+    long last_use;  ///< guarded by _networks_mutex
+
+    std::mutex mutex;
+    std::unique_ptr<XMLReader> reader;
+    std::map<std::string, std::vector<std::unique_ptr<SolverSession>>> idle;
+  };
+
+  void handleConnection(int fd);
+  void runWorker();
+  std::string process(const DaemonRequest& request);
+  std::string solve(const DaemonRequest& request);
+
+  std::shared_ptr<CachedNetwork> getNetwork(const std::string& file);
+  void evictNetworks();
+  std::unique_ptr<SolverSession> acquireSession(
+      const DaemonRequest& request,
+      const std::shared_ptr<CachedNetwork>& network, bool* warm);
+  void releaseSession(const DaemonRequest& request,
+                      const std::shared_ptr<CachedNetwork>& network,
+                      std::unique_ptr<SolverSession> session);
+
+  BoundedQueue<std::shared_ptr<Task>> _queue;
+  std::vector<std::thread> _workers;
+
+  /// the open connections are shut down when the daemon is destroyed
+  const int _max_connections;
+  std::mutex _connections_mutex;
+  std::condition_variable _connections_closed;
+  std::set<int> _connections;
+
+  std::atomic<long> _requests;
+  std::atomic<long> _rejected;
+
+  std::mutex _networks_mutex;
+  std::map<std::string, std::shared_ptr<CachedNetwork>> _networks;
+  size_t _max_networks;
+  long _network_uses;
+};
+
+#endif  // UBAHN_DAEMON_SOLVER_DAEMON_H_
@@ -0,0 +1,684 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "generator/network_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+/** Distance between two parallel lines of a grid. */
+const double GRID_SPACING = 2.0;
+/** Part of a ring, that is not served by the ring line. */
+const double RING_GAP = 0.1;
+
+/**
+ * Random numbers that only depend on the seed. The distributions of the
+ * standard library are implementation defined, so they are not used.
+ */
+class Random {
+ public:
+  explicit Random(uint32_t seed) : _engine(seed) {}
+
+  /** Returns a uniform number in [0, 1). */
+  double uniform() {
+    const uint64_t a = _engine() >> 5;
+    const uint64_t b = _engine() >> 6;
+    return (a * 67108864.0 + b) / 9007199254740992.0;
+  }
+
+  double uniform(double min, double max) {
+    return min + (max - min) * uniform();
+  }
+
+  /** Returns a uniform integer in [0, n). */
+  size_t index(size_t n) {
+    return std::min(static_cast<size_t>(uniform() * n), n - 1);
+  }
+
+  bool chance(double probability) { return uniform() < probability; }
+
+  double normal(double mean, double deviation) {
+    // Box-Muller transform
+    const double u = 1.0 - uniform();
+    const double v = uniform();
+    return mean + deviation * std::sqrt(-2.0 * std::log(u)) *
+                      std::cos(2.0 * PI * v);
+  }
+
+  double exponential(double mean) { return -mean * std::log(1.0 - uniform()); }
+
+  template <typename T>
+  void shuffle(vector<T>* values) {
+    for (size_t i = values->size(); i > 1; i--) {
+      std::swap((*values)[i - 1], (*values)[index(i)]);
+    }
+  }
+
+ private:
+  std::mt19937 _engine;
+};
+
+struct Point {
+  Point() : x(0.0), y(0.0) {}
+  Point(double x, double y) : x(x), y(y) {}
+
+  double x;
+  double y;
+};
+
+double distance(const Point& p, const Point& q) {
+  return std::hypot(p.x - q.x, p.y - q.y);
+}
+
+Point interpolate(const Point& p, const Point& q, double t) {
+  return Point(p.x + t * (q.x - p.x), p.y + t * (q.y - p.y));
+}
+
+/** A point on a line, the key gives the order of the points along the line. */
+struct Anchor {
+  Anchor(double key, Point pos, int station)
+      : key(key), pos(pos), station(station) {}
+
+  double key;
+  Point pos;
+  int station;
+};
+
+struct SkeletonLine {
+  string name;
+  int city;
+  bool intercity;
+  vector<Anchor> anchors;
+  vector<int> stops;  ///< the final sequence of stations
+};
+
+/** A point where several lines could share a transfer station. */
+struct Crossing {
+  Point pos;
+  vector<std::pair<int, double>> members;  ///< line and key on that line
+};
+
+class UnionFind {
+ public:
+  explicit UnionFind(size_t n) : _parent(n) {
+    std::iota(_parent.begin(), _parent.end(), 0);
+  }
+
+  size_t find(size_t i) {
+    while (_parent[i] != i) {
+      _parent[i] = _parent[_parent[i]];
+      i = _parent[i];
+    }
+    return i;
+  }
+
+  bool join(size_t i, size_t j) {
+    i = find(i);
+    j = find(j);
+    if (i == j) return false;
+
+    _parent[i] = j;
+    return true;
+  }
+
+ private:
+  vector<size_t> _parent;
+};
+
+/** Does the actual work for the NetworkGenerator. */
+class SkeletonBuilder {
+ public:
+  explicit SkeletonBuilder(const GeneratorConfig& config)
+      : _config(config), _random(config.seed) {}
+
+  void build(TransportNetwork* network);
+
+ private:
+  int newStation(int city, const Point& pos);
+  int newLine(int city, bool intercity);
+
+  void addGridCity(int city, int n_lines, const Point& center);
+  void addRadialCity(int city, int n_lines, const Point& center);
+  void realizeCrossings(const vector<Crossing>& crossings);
+  void addIntercityLines(int n_cities);
+  void addIntermediateStations();
+  void addTerminalLoops();
+  void checkConnectivity() const;
+
+  unsigned int sampleTravelTime(int from, int to);
+  string stationName(int station) const;
+
+  const GeneratorConfig& _config;
+  Random _random;
+
+  vector<Point> _station_pos;
+  vector<int> _station_city;
+  vector<SkeletonLine> _lines;
+
+  /// the station with the most lines in each city
+  vector<int> _hubs;
+  vector<int> _hub_degree;
+  /// the station that must stay exclusive to a single line
+  int _unique_station;
+};
+
+int SkeletonBuilder::newStation(int city, const Point& pos) {
+  _station_pos.push_back(pos);
+  _station_city.push_back(city);
+  return _station_pos.size() - 1;
+}
+
+int SkeletonBuilder::newLine(int city, bool intercity) {
+  std::ostringstream name;
+  if (intercity) {
+    name << "X" << city + 1;
+  } else if (_config.layout == MULTI_CITY_LAYOUT) {
+    name << "C" << city + 1 << "-L" << _lines.size() + 1;
+  } else {
+    name << "L" << _lines.size() + 1;
+  }
+
+  SkeletonLine line;
+  line.name = name.str();
+  line.city = city;
+  line.intercity = intercity;
+  _lines.push_back(line);
+
+  return _lines.size() - 1;
+}
+
+/** Horizontal and vertical lines, every pair of them crosses. */
+void SkeletonBuilder::addGridCity(int city, int n_lines, const Point& center) {
+  const int n_horizontal = (n_lines + 1) / 2;
+  const int n_vertical = n_lines - n_horizontal;
+
+  const double width = std::max(n_vertical - 1, 0) * GRID_SPACING;
+  const double height = std::max(n_horizontal - 1, 0) * GRID_SPACING;
+  const Point origin(center.x - width / 2, center.y - height / 2);
+
+  vector<int> horizontal, vertical;
+  for (int i = 0; i < n_horizontal; i++) {
+    const int l = newLine(city, false);
+    horizontal.push_back(l);
+
+    // the lines end at a random distance after the last crossing
+    const double y = origin.y + i * GRID_SPACING;
+    const double x0 = origin.x - _random.uniform(0.5, 2.0) * GRID_SPACING;
+    const double x1 =
+        origin.x + width + _random.uniform(0.5, 2.0) * GRID_SPACING;
+    for (const Point& pos : {Point(x0, y), Point(x1, y)}) {
+      _lines[l].anchors.emplace_back(pos.x, pos, newStation(city, pos));
+    }
+  }
+  for (int j = 0; j < n_vertical; j++) {
+    const int l = newLine(city, false);
+    vertical.push_back(l);
+
+    const double x = origin.x + j * GRID_SPACING;
+    const double y0 = origin.y - _random.uniform(0.5, 2.0) * GRID_SPACING;
+    const double y1 =
+        origin.y + height + _random.uniform(0.5, 2.0) * GRID_SPACING;
+    for (const Point& pos : {Point(x, y0), Point(x, y1)}) {
+      _lines[l].anchors.emplace_back(pos.y, pos, newStation(city, pos));
+    }
+  }
+
+  vector<Crossing> crossings;
+  for (int i = 0; i < n_horizontal; i++) {
+    for (int j = 0; j < n_vertical; j++) {
+      Crossing c;
+      c.pos = Point(origin.x + j * GRID_SPACING, origin.y + i * GRID_SPACING);
+      c.members.emplace_back(horizontal[i], c.pos.x);
+      c.members.emplace_back(vertical[j], c.pos.y);
+      crossings.push_back(c);
+    }
+  }
+
+  realizeCrossings(crossings);
+}
+
+/**
+ * Radial lines through a common center and open rings around it. A quarter of
+ * the lines are rings, each crossing every radial line twice.
+ */
+void SkeletonBuilder::addRadialCity(int city, int n_lines,
+                                    const Point& center) {
+  const int n_rings = n_lines >= 3 ? std::max(1, n_lines / 4) : 0;
+  const int n_radials = n_lines - n_rings;
+  const double radius = GRID_SPACING * (n_rings + 1);
+
+  vector<int> radials;
+  vector<double> angles;
+  for (int r = 0; r < n_radials; r++) {
+    const int l = newLine(city, false);
+    radials.push_back(l);
+
+    const double angle = PI * (r + _random.uniform(-0.2, 0.2)) / n_radials;
+    angles.push_back(angle);
+
+    // the key of a radial line is the signed distance to the center
+    for (int side = -1; side <= 1; side += 2) {
+      const double s = side * radius * _random.uniform(1.1, 1.5);
+      const Point pos(center.x + s * std::cos(angle),
+                      center.y + s * std::sin(angle));
+      _lines[l].anchors.emplace_back(s, pos, newStation(city, pos));
+    }
+  }
+
+  vector<Crossing> crossings;
+  if (n_radials > 1) {
+    Crossing c;
+    c.pos = center;
+    for (int l : radials) {
+      c.members.emplace_back(l, 0.0);
+    }
+    crossings.push_back(c);
+  }
+
+  for (int k = 0; k < n_rings; k++) {
+    const int l = newLine(city, false);
+
+    // the key of a ring is the angle relative to its first terminal
+    const double rho = radius * (k + 1) / (n_rings + 1);
+    const double start = _random.uniform(0.0, 2 * PI);
+    const double span = 2 * PI * (1.0 - RING_GAP);
+    for (double key : {0.0, span}) {
+      const Point pos(center.x + rho * std::cos(start + key),
+                      center.y + rho * std::sin(start + key));
+      _lines[l].anchors.emplace_back(key, pos, newStation(city, pos));
+    }
+
+    for (int r = 0; r < n_radials; r++) {
+      for (int side = -1; side <= 1; side += 2) {
+        const double angle = side < 0 ? angles[r] + PI : angles[r];
+        const double key = std::fmod(angle - start + 4 * PI, 2 * PI);
+        if (key <= 0.0 || key >= span) {
+          continue;
+        }
+
+        Crossing c;
+        c.pos = Point(center.x + rho * std::cos(angle),
+                      center.y + rho * std::sin(angle));
+        c.members.emplace_back(radials[r], side * rho);
+        c.members.emplace_back(l, key);
+        crossings.push_back(c);
+      }
+    }
+  }
+
+  realizeCrossings(crossings);
+}
+
+/**
+ * Turns crossings into transfer stations. First a spanning set of crossings is
+ * chosen, so that all lines are connected, then further crossings are added
+ * until the requested density is reached.
+ */
+void SkeletonBuilder::realizeCrossings(const vector<Crossing>& crossings) {
+  vector<size_t> order(crossings.size());
+  std::iota(order.begin(), order.end(), 0);
+  _random.shuffle(&order);
+
+  UnionFind lines(_lines.size());
+  vector<bool> realized(crossings.size(), false);
+  int n_realized = 0;
+
+  for (size_t i : order) {
+    const Crossing& c = crossings[i];
+    for (size_t m = 1; m < c.members.size(); m++) {
+      if (lines.join(c.members[0].first, c.members[m].first)) {
+        realized[i] = true;
+      }
+    }
+    if (realized[i]) {
+      n_realized++;
+    }
+  }
+
+  const double wanted = _config.transfer_density * crossings.size();
+  const int remaining = crossings.size() - n_realized;
+  const double probability =
+      remaining > 0 ? std::max(0.0, wanted - n_realized) / remaining : 0.0;
+  for (size_t i : order) {
+    if (!realized[i] && _random.chance(probability)) {
+      realized[i] = true;
+    }
+  }
+
+  for (size_t i = 0; i < crossings.size(); i++) {
+    if (!realized[i]) continue;
+
+    const Crossing& c = crossings[i];
+    const int city = _lines[c.members[0].first].city;
+    const int station = newStation(city, c.pos);
+    for (const auto& member : c.members) {
+      _lines[member.first].anchors.emplace_back(member.second, c.pos, station);
+    }
+
+    if (static_cast<int>(c.members.size()) > _hub_degree[city]) {
+      _hubs[city] = station;
+      _hub_degree[city] = c.members.size();
+    }
+  }
+}
+
+/** Connects the hubs of consecutive cities by a line. */
+void SkeletonBuilder::addIntercityLines(int n_cities) {
+  for (int city = 0; city < n_cities; city++) {
+    // a city without any transfer station gets a hub on its first line
+    if (_hubs[city] < 0) {
+      for (SkeletonLine& line : _lines) {
+        if (line.city == city && !line.intercity) {
+          const Anchor& a = line.anchors.front();
+          const Anchor& b = line.anchors.back();
+          const Point pos = interpolate(a.pos, b.pos, 0.5);
+
+          _hubs[city] = newStation(city, pos);
+          line.anchors.emplace_back((a.key + b.key) / 2, pos, _hubs[city]);
+          break;
+        }
+      }
+    }
+  }
+
+  for (int city = 0; city + 1 < n_cities; city++) {
+    const int l = newLine(city, true);
+    const int from = _hubs[city];
+    const int to = _hubs[city + 1];
+
+    _lines[l].anchors.emplace_back(0.0, _station_pos[from], from);
+    _lines[l].anchors.emplace_back(
+        distance(_station_pos[from], _station_pos[to]), _station_pos[to], to);
+  }
+}
+
+/**
+ * Distributes the remaining stations on the segments between the anchors,
+ * proportional to the segment length.
+ */
+void SkeletonBuilder::addIntermediateStations() {
+  struct Segment {
+    int line;
+    size_t anchor;
+    double length;
+    int stations;
+  };
+
+  vector<Segment> segments;
+  double total_length = 0.0;
+  for (size_t l = 0; l < _lines.size(); l++) {
+    vector<Anchor>& anchors = _lines[l].anchors;
+    std::sort(anchors.begin(), anchors.end(),
+              [](const Anchor& a, const Anchor& b) { return a.key < b.key; });
+
+    for (size_t i = 0; i + 1 < anchors.size(); i++) {
+      const double length = distance(anchors[i].pos, anchors[i + 1].pos);
+      segments.push_back(Segment{static_cast<int>(l), i, length, 0});
+      total_length += length;
+    }
+  }
+
+  // the skeleton cannot be thinned out without changing the layout
+  const int required = static_cast<int>(_station_pos.size());
+  if (_config.stations < required) {
+    std::ostringstream errBuf;
+    errBuf << "Invalid configuration: The layout of " << _config.lines
+           << " lines requires at least " << required << " stations, but only "
+           << _config.stations << " were requested";
+    throw std::runtime_error(errBuf.str());
+  }
+  const int budget = _config.stations - required;
+
+  // largest remainder method
+  int assigned = 0;
+  vector<std::pair<double, size_t>> remainders;
+  for (size_t i = 0; i < segments.size(); i++) {
+    const double share =
+        total_length > 0.0 ? budget * segments[i].length / total_length : 0.0;
+    segments[i].stations = static_cast<int>(std::floor(share));
+    assigned += segments[i].stations;
+    remainders.emplace_back(share - segments[i].stations, i);
+  }
+  std::sort(remainders.begin(), remainders.end(),
+            [](const std::pair<double, size_t>& a,
+               const std::pair<double, size_t>& b) {
+              return a.first > b.first ||
+                     (a.first == b.first && a.second < b.second);
+            });
+  for (size_t i = 0; assigned < budget && !remainders.empty(); i++) {
+    segments[remainders[i % remainders.size()].second].stations++;
+    assigned++;
+  }
+
+  vector<vector<int>> stops(_lines.size());
+  for (size_t l = 0; l < _lines.size(); l++) {
+    stops[l].push_back(_lines[l].anchors.front().station);
+  }
+  for (const Segment& s : segments) {
+    SkeletonLine& line = _lines[s.line];
+    const Anchor& a = line.anchors[s.anchor];
+    const Anchor& b = line.anchors[s.anchor + 1];
+
+    for (int i = 1; i <= s.stations; i++) {
+      const Point pos = interpolate(a.pos, b.pos, i / (s.stations + 1.0));
+      stops[s.line].push_back(newStation(_station_city[a.station], pos));
+    }
+    stops[s.line].push_back(b.station);
+  }
+
+  for (size_t l = 0; l < _lines.size(); l++) {
+    _lines[l].stops = stops[l];
+  }
+}
+
+/** Lets line terminals continue to the closest station of a different line. */
+void SkeletonBuilder::addTerminalLoops() {
+  if (_config.terminal_loops <= 0.0) {
+    return;
+  }
+
+  for (size_t l = 0; l < _lines.size(); l++) {
+    SkeletonLine& line = _lines[l];
+    if (line.intercity) continue;
+
+    for (int end = 0; end < 2; end++) {
+      if (!_random.chance(_config.terminal_loops)) continue;
+
+      const int terminal = end == 0 ? line.stops.front() : line.stops.back();
+      if (terminal == _unique_station) continue;
+
+      const std::set<int> own(line.stops.begin(), line.stops.end());
+      int closest = -1;
+      double closest_distance = std::numeric_limits<double>::max();
+      for (size_t s = 0; s < _station_pos.size(); s++) {
+        if (own.count(s) > 0 || static_cast<int>(s) == _unique_station ||
+            _station_city[s] != line.city) {
+          continue;
+        }
+
+        const double d = distance(_station_pos[terminal], _station_pos[s]);
+        if (d < closest_distance) {
+          closest = s;
+          closest_distance = d;
+        }
+      }
+
+      if (closest >= 0) {
+        if (end == 0) {
+          line.stops.insert(line.stops.begin(), closest);
+        } else {
+          line.stops.push_back(closest);
+        }
+      }
+    }
+  }
+}
+
+/** Checks that every station can be reached from the first station. */
+void SkeletonBuilder::checkConnectivity() const {
+  UnionFind stations(_station_pos.size());
+  vector<bool> served(_station_pos.size(), false);
+  for (const SkeletonLine& line : _lines) {
+    for (size_t i = 0; i < line.stops.size(); i++) {
+      served[line.stops[i]] = true;
+      if (i > 0) stations.join(line.stops[i - 1], line.stops[i]);
+    }
+  }
+
+  for (size_t s = 0; s < _station_pos.size(); s++) {
+    if (!served[s] || stations.find(s) != stations.find(0)) {
+      std::ostringstream errBuf;
+      errBuf << "Generated network is not connected: No connection between "
+                "stations "
+             << stationName(0) << " and " << stationName(s);
+      throw std::runtime_error(errBuf.str());
+    }
+  }
+}
+
+unsigned int SkeletonBuilder::sampleTravelTime(int from, int to) {
+  double time = 0.0;
+  switch (_config.times) {
+    case UNIFORM_TIMES:
+      time = std::floor(_random.uniform(_config.time_a, _config.time_b + 1.0));
+      break;
+    case NORMAL_TIMES:
+      time = std::round(_random.normal(_config.time_a, _config.time_b));
+      break;
+    case EXPONENTIAL_TIMES:
+      time = std::round(_random.exponential(_config.time_a));
+      break;
+    case DISTANCE_TIMES:
+      time = std::round(
+          _config.time_a * distance(_station_pos[from], _station_pos[to]));
+      break;
+  }
+
+  // every ride takes at least one minute
+  return std::max(1.0, time);
+}
+
+string SkeletonBuilder::stationName(int station) const {
+  std::ostringstream name;
+  if (_config.layout == MULTI_CITY_LAYOUT) {
+    name << "C" << _station_city[station] + 1 << "-";
+  }
+  name << "S" << station + 1;
+  return name.str();
+}
+
+void SkeletonBuilder::build(TransportNetwork* network) {
+  const int n_cities =
+      _config.layout == MULTI_CITY_LAYOUT ? _config.cities : 1;
+  const int n_city_lines = _config.lines - (n_cities - 1);
+  if (n_city_lines < n_cities) {
+    throw std::runtime_error(
+        "Invalid configuration: Every city needs at least one line and "
+        "consecutive cities are connected by an additional line");
+  }
+
+  _hubs.assign(n_cities, -1);
+  _hub_degree.assign(n_cities, 1);
+
+  for (int city = 0; city < n_cities; city++) {
+    const int n_lines =
+        n_city_lines / n_cities + (city < n_city_lines % n_cities ? 1 : 0);
+
+    // cities are placed next to each other with some space in between
+    const double extent = GRID_SPACING * (n_lines + 4);
+    const Point center(city * 2.5 * extent,
+                       _random.uniform(-0.5, 0.5) * extent);
+
+    const bool grid = _config.layout == GRID_LAYOUT ||
+                      (_config.layout == MULTI_CITY_LAYOUT && city % 2 == 1);
+    if (grid) {
+      addGridCity(city, n_lines, center);
+    } else {
+      addRadialCity(city, n_lines, center);
+    }
+  }
+
+  addIntercityLines(n_cities);
+  addIntermediateStations();
+
+  // the first terminal of the first line is never used by any other line
+  _unique_station = _lines.front().stops.front();
+  addTerminalLoops();
+
+  checkConnectivity();
+
+  for (size_t s = 0; s < _station_pos.size(); s++) {
+    network->addStation(stationName(s));
+  }
+  for (SkeletonLine& line : _lines) {
+    Line* l = network->addLine(line.name);
+
+    unsigned int time = 0;
+    for (size_t i = 0; i < line.stops.size(); i++) {
+      if (i > 0) {
+        time += sampleTravelTime(line.stops[i - 1], line.stops[i]);
+      }
+      network->addStop(l, stationName(line.stops[i]), time);
+    }
+  }
+}
+}  // namespace
+
+NetworkGenerator::NetworkGenerator(const GeneratorConfig& config)
+    : _config(config) {
+  if (_config.stations < 2 || _config.lines < 1 || _config.cities < 1) {
+    throw std::runtime_error(
+        "Invalid configuration: At least two stations, one line and one city "
+        "are required");
+  }
+  if (_config.transfer_density < 0.0 || _config.transfer_density > 1.0 ||
+      _config.terminal_loops < 0.0 || _config.terminal_loops > 1.0) {
+    throw std::runtime_error(
+        "Invalid configuration: Densities and probabilities must be in [0, 1]");
+  }
+}
+
+void NetworkGenerator::generate(TransportNetwork* network) {
+  if (!network->getStations().empty() || !network->getLines().empty()) {
+    throw std::runtime_error("The network must be empty");
+  }
+
+  SkeletonBuilder builder(_config);
+  builder.build(network);
+}
+
+NetworkLayout parseLayout(const string& name) {
+  if (name == "grid") return GRID_LAYOUT;
+  if (name == "radial") return RADIAL_LAYOUT;
+  if (name == "multi") return MULTI_CITY_LAYOUT;
+
+  throw std::runtime_error("Unknown layout " + name);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_GENERATOR_NETWORK_GENERATOR_H_
+#define UBAHN_GENERATOR_NETWORK_GENERATOR_H_
+
+#include <cstdint>
+#include <string>
+
+#include "transport_network.h"
+
+enum NetworkLayout { GRID_LAYOUT, RADIAL_LAYOUT, MULTI_CITY_LAYOUT };
+
+enum TravelTimeDistribution {
+  UNIFORM_TIMES,      ///< uniform integer in [time_a, time_b]
+  NORMAL_TIMES,       ///< normal with mean time_a and deviation time_b
+  EXPONENTIAL_TIMES,  ///< exponential with mean time_a
+  DISTANCE_TIMES      ///< time_a minutes per unit of distance
+};
+
+struct GeneratorConfig {
+  GeneratorConfig()
+      : layout(GRID_LAYOUT),
+        stations(100),
+        lines(10),
+        cities(3),
+        transfer_density(0.5),
+        terminal_loops(0.0),
+        times(UNIFORM_TIMES),
+        time_a(1.0),
+        time_b(3.0),
+        seed(1) {}
+
+  NetworkLayout layout;
+
+  /// number of stations, generating fails if the skeleton requires more
+  int stations;
+  int lines;
+  /// number of cities of the MULTI_CITY_LAYOUT
+  int cities;
+
+  /// fraction of the crossings of two lines that become transfer stations
+  double transfer_density;
+  /// probability that a line terminal continues to a station of another line
+  double terminal_loops;
+
+  TravelTimeDistribution times;
+  double time_a;
+  double time_b;
+
+  uint32_t seed;
+};
+
+/**
+ * Generates synthetic transportation networks for scaling tests.
+ * The same configuration always results in the same network, independent of
+ * the platform, as the random numbers are derived from the seed only.
+ * The generated networks are connected and contain at least one station that
+ * is only served by a single line, as required by the StationSolver.
+ */
+class NetworkGenerator {
+ public:
+  explicit NetworkGenerator(const GeneratorConfig& config);
+
+  // disallow copy and assign
+  NetworkGenerator(const NetworkGenerator&) = delete;
+  void operator=(NetworkGenerator) = delete;
+
+  /** Adds the network to the given, empty network. Throws on invalid input */
+  void generate(TransportNetwork* network);
+
+ private:
+  const GeneratorConfig _config;
+};
+
+/** Parses a layout name (grid, radial or multi), throws if it is unknown. */
+NetworkLayout parseLayout(const std::string& name);
+
+#endif  // UBAHN_GENERATOR_NETWORK_GENERATOR_H_
@@ -19,6 +19,7 @@
 #include <iostream>
 #include <list>
 #include <map>
+#include <random>
 #include <set>
 #include <sstream>
 #include <string>
@@ -147,6 +148,12 @@ vector<std::list<node>> computeDegree2Chains(
 GraphBuilder::GraphBuilder(const t_stationmap& stations, const t_linemap& lines,
                            double change_cost, double switch_cost,
                            ProblemType type, bool preprocess)
+    : GraphBuilder(stations, lines, change_cost, switch_cost, Unbuilt()) {
+  build(type, preprocess);
+}
+
+GraphBuilder::GraphBuilder(const t_stationmap& stations, const t_linemap& lines,
+                           double change_cost, double switch_cost, Unbuilt)
     : _stations(stations),
       _lines(lines),
       _nodes_removed(false),
@@ -155,7 +162,13 @@ GraphBuilder::GraphBuilder(const t_stationmap& stations, const t_linemap& lines,
       _dist(_g, _change_cost),
       _connection_arcs(_g, true),
       _arc_names(_g, CHANGE_NAME),
-      _node_names(_g, "") {
+      _arc_types(_g, CHANGE_ARC),
+      _node_names(_g, ""),
+      _node_lines(_g, ""),
+      _node_reverse(_g, false),
+      _node_positions(_g, -1) {}
+
+void GraphBuilder::build(ProblemType type, bool preprocess) {
   // create one node for every node and every line in both directions
   map<string, map<string, node>> way_nodemap, back_nodemap;
   createNodesAndTravelArcs(way_nodemap, back_nodemap);
@@ -247,6 +260,8 @@ void GraphBuilder::createNodesAndTravelArcs(
       const node currentNode = _g.new_node();
       way_nodemap[lineName][station] = currentNode;
       _node_names[currentNode] = station;
+      _node_lines[currentNode] = lineName;
+      _node_positions[currentNode] = station_index;
 
       _station_nodes[station].insert(currentNode);
 
@@ -255,6 +270,7 @@ void GraphBuilder::createNodesAndTravelArcs(
         edge e = _g.new_edge(lastNode, currentNode);
         _arc_names[e] = lineName;
         _connection_arcs[e] = false;
+        _arc_types[e] = RIDE_ARC;
 
         const int travel_time = it->second->times[station_index] -
                                 it->second->times[station_index - 1];
@@ -280,6 +296,9 @@ void GraphBuilder::createNodesAndTravelArcs(
       node currentNode = _g.new_node();
       back_nodemap[lineName][station] = currentNode;
       _node_names[currentNode] = station;
+      _node_lines[currentNode] = lineName;
+      _node_reverse[currentNode] = true;
+      _node_positions[currentNode] = station_index;
 
       _station_nodes[station].insert(currentNode);
 
@@ -288,6 +307,7 @@ void GraphBuilder::createNodesAndTravelArcs(
         edge e = _g.new_edge(lastNode, currentNode);
         _arc_names[e] = lineName;
         _connection_arcs[e] = false;
+        _arc_types[e] = RIDE_ARC;
 
         const int travel_time = it->second->times[station_index + 1] -
                                 it->second->times[station_index];
@@ -311,11 +331,13 @@ void GraphBuilder::addAllSwitchingArcs(
       edge way_edge = _g.new_edge(way_nodemap[lineName][station_name],
                                   back_nodemap[lineName][station_name]);
       _dist[way_edge] = _switch_cost;
+      _arc_types[way_edge] = SWITCH_ARC;
       _connection_arcs[way_edge] = true;
 
       edge back_edge = _g.new_edge(back_nodemap[lineName][station_name],
                                    way_nodemap[lineName][station_name]);
       _dist[back_edge] = _switch_cost;
+      _arc_types[back_edge] = SWITCH_ARC;
       _connection_arcs[back_edge] = true;
     }
   }
@@ -335,11 +357,13 @@ void GraphBuilder::addSwitchingArcsAtTerminals(
           edge e = _g.new_edge(back_nodemap[lineName][*it2],
                                way_nodemap[lineName][*it2]);
           _dist[e] = _switch_cost;
+          _arc_types[e] = SWITCH_ARC;
           _connection_arcs[e] = true;
         } else {
           edge e = _g.new_edge(way_nodemap[lineName][*it2],
                                back_nodemap[lineName][*it2]);
           _dist[e] = _switch_cost;
+          _arc_types[e] = SWITCH_ARC;
           _connection_arcs[e] = true;
         }
       }
@@ -368,11 +392,13 @@ void GraphBuilder::addStationProblemSwitchingArcs(
           const edge e = _g.new_edge(back_nodemap[lineName][*it2],
                                      way_nodemap[lineName][*it2]);
           _dist[e] = _switch_cost;
+          _arc_types[e] = SWITCH_ARC;
           _connection_arcs[e] = true;
         } else {
           const edge e = _g.new_edge(way_nodemap[lineName][*it2],
                                      back_nodemap[lineName][*it2]);
           _dist[e] = _switch_cost;
+          _arc_types[e] = SWITCH_ARC;
           _connection_arcs[e] = true;
         }
 
@@ -395,6 +421,7 @@ void GraphBuilder::addStationProblemSwitchingArcs(
                                    back_nodemap[lineName][*it2]);
 
         _dist[e] = _switch_cost;
+        _arc_types[e] = SWITCH_ARC;
         _connection_arcs[e] = true;
       }
       if (isConnectingStation(it2 - 1, _stations)) {
@@ -402,6 +429,7 @@ void GraphBuilder::addStationProblemSwitchingArcs(
                                    way_nodemap[lineName][*it2]);
 
         _dist[e] = _switch_cost;
+        _arc_types[e] = SWITCH_ARC;
         _connection_arcs[e] = true;
       }
     }
@@ -455,20 +483,29 @@ void GraphBuilder::preprocessGraph(ProblemType type) {
   vector<std::list<node>> chains = computeDegree2Chains(_g, _connection_arcs);
 
   vector<node> redundant_nodes;
+  map<string, vector<RemovedStop>> chain_stops;
   for (const std::list<node>& list : chains) {
-    // for the station problem we must assure that all stations must be visited
-    if (type == STATION) {
-      // the chain can only be removed, if either the node left of the chain or
-      // the node right of the cahin must always be visited
-      const node pred_node = source(_g.in_edges(list.front()).front());
-      const node succ_node = target(_g.out_edges(list.back()).front());
+    const node pred_node = source(_g.in_edges(list.front()).front());
+    const node succ_node = target(_g.out_edges(list.back()).front());
 
-      if (_g.indeg(pred_node) > 1 && _g.indeg(succ_node) > 1) {
-        continue;
-      }
+    // a node with a single entering arc can only be reached via the chain
+    RemovedStop stop;
+    if (_g.indeg(pred_node) <= 1) {
+      stop.anchors.push_back(_node_names[pred_node]);
+    }
+    if (_g.indeg(succ_node) <= 1) {
+      stop.anchors.push_back(_node_names[succ_node]);
+    }
+
+    // for the station problem we must assure that all stations must be visited
+    // the chain can only be removed, if either the node left of the chain or
+    // the node right of the cahin must always be visited
+    if (type == STATION && stop.anchors.empty()) {
+      continue;
     }
 
     // remove the chain very inefficiently node by node
+    vector<string> chain_stations;
     for (node n : list) {
       assert(_g.indeg(n) == 1 && _g.outdeg(n) == 1);
 
@@ -480,10 +517,18 @@ void GraphBuilder::preprocessGraph(ProblemType type) {
       const edge new_edge = _g.new_edge(source(in_edge), target(out_edge));
       _dist[new_edge] = _dist[in_edge] + _dist[out_edge];
       _connection_arcs[new_edge] = false;
+      _arc_types[new_edge] = RIDE_ARC;
       _arc_names[new_edge] = _arc_names[in_edge];
 
+      chain_stations.push_back(_node_names[n]);
       redundant_nodes.push_back(n);
       _g.del_node(n);
+      stop.arc = new_edge;
+    }
+
+    // the last new arc spans the whole chain
+    for (const string& station : chain_stations) {
+      chain_stops[station].push_back(stop);
     }
   }
 
@@ -494,6 +539,7 @@ void GraphBuilder::preprocessGraph(ProblemType type) {
     }
 
     if (map_it->second.empty()) {
+      _removed_stations[map_it->first] = chain_stops[map_it->first];
       _station_nodes.erase(map_it++);
     } else {
       ++map_it;
@@ -501,6 +547,23 @@ void GraphBuilder::preprocessGraph(ProblemType type) {
   }
 }
 
+void GraphBuilder::shuffle(uint32_t seed) {
+  // the keys are taken from the engine directly, as the std distributions
+  // differ between standard libraries and the same seed must give the same
+  // order everywhere
+  std::mt19937 random(seed);
+
+  node_array<double> node_keys(_g);
+  node n;
+  forall_nodes(n, _g) { node_keys[n] = random(); }
+  _g.sort_nodes(node_keys);
+
+  edge_array<double> edge_keys(_g);
+  edge e;
+  forall_edges(e, _g) { edge_keys[e] = random(); }
+  _g.sort_edges(edge_keys);
+}
+
 void GraphBuilder::printStatistics(std::ostream& O) const {
   node_array<int> compnum(_g, 0);
   const int nComponents = COMPONENTS(_g, compnum);
@@ -537,33 +600,34 @@ class MaxStringLength {
   size_t _max_length;
 };
 
-void GraphBuilder::getTourOutput(const std::list<edge>& tour, bool compact,
-                                 vector<string>* column) const {
+namespace {
+
+/** Fills the four output columns with the legs of a tour. */
+void getLegOutput(const vector<TourLeg>& legs, bool compact,
+                  vector<string>* column) {
   column[0].push_back("Start");
   column[1].push_back("Line");
   column[2].push_back("Destination");
   column[3].push_back("Time (m)");
   double time = 0;
 
-  for (std::list<edge>::const_iterator it = tour.begin(); it != tour.end();
-       ++it) {
-    assert(column[2].size() == 1 ||
-           column[2].back().compare(_node_names[source(*it)]) == 0);
+  for (const TourLeg& leg : legs) {
+    assert(column[2].size() == 1 || column[2].back().compare(leg.from) == 0);
 
-    time += _dist[*it];
+    time += leg.time;
 
     if (compact && column[1].size() > 1 &&
-        column[1].back().compare(_arc_names[*it]) == 0 &&
-        column[2].back().compare(_node_names[source(*it)]) == 0) {
+        column[1].back().compare(leg.line) == 0 &&
+        column[2].back().compare(leg.from) == 0) {
       column[2].pop_back();
-      column[2].push_back(_node_names[target(*it)]);
+      column[2].push_back(leg.to);
 
       column[3].pop_back();
       column[3].push_back(boost::lexical_cast<string>(round(time)));
     } else {
-      column[0].push_back(_node_names[source(*it)]);
-      column[2].push_back(_node_names[target(*it)]);
-      column[1].push_back(_arc_names[*it]);
+      column[0].push_back(leg.from);
+      column[2].push_back(leg.to);
+      column[1].push_back(leg.line);
       column[3].push_back(boost::lexical_cast<string>(round(time)));
     }
   }
@@ -586,6 +650,68 @@ void GraphBuilder::getTourOutput(const std::list<edge>& tour, bool compact,
   }
 }
 
+/** Prints the output columns as an aligned table. */
+void printColumns(const vector<string>* column, ostream& O) {
+  uint length[4];
+  for (int i = 0; i < 4; i++) {
+    MaxStringLength strLength =
+        std::for_each(column[i].begin(), column[i].end(), MaxStringLength());
+    length[i] = strLength.getMaxLength();
+  }
+
+  for (uint i = 0; i < column[0].size(); i++) {
+    O << " ";
+    for (int j = 0; j < 4; j++) {
+      O << column[j][i] << std::setw(length[j] - column[j][i].size() + 2)
+        << "\t";
+    }
+    O << endl;
+  }
+}
+}  // namespace
+
+vector<TourLeg> GraphBuilder::getTourLegs(const std::list<edge>& tour) const {
+  vector<TourLeg> legs;
+  for (edge e : tour) {
+    TourLeg leg;
+    leg.from = _node_names[source(e)];
+    leg.line = _arc_names[e];
+    leg.to = _node_names[target(e)];
+    leg.time = _dist[e];
+    legs.push_back(leg);
+  }
+
+  return legs;
+}
+
+void GraphBuilder::getTourOutput(const std::list<edge>& tour, bool compact,
+                                 vector<string>* column) const {
+  getLegOutput(getTourLegs(tour), compact, column);
+}
+
+int GraphBuilder::getStationIds(node_array<int>* station_ids) const {
+  station_ids->init(_g, -1);
+
+  int n_stations = 0;
+  for (const auto& station : _station_nodes) {
+    for (node n : station.second) (*station_ids)[n] = n_stations;
+    n_stations++;
+  }
+  return n_stations;
+}
+
+void GraphBuilder::printTourLegs(const vector<TourLeg>& legs, ostream& O) {
+  const int changes =
+      std::count_if(legs.begin(), legs.end(), [](const TourLeg& leg) {
+        return leg.line.compare(CHANGE_NAME) == 0;
+      });
+  O << "The following tour contains " << changes << " changes" << endl;
+
+  vector<string> column[4];
+  getLegOutput(legs, true, column);
+  printColumns(column, O);
+}
+
 void GraphBuilder::saveTexTour(const std::list<edge>& tour, string start,
                                bool compact, ostream& O) const {
   std::list<edge>::const_iterator startPos = tour.end();
@@ -788,19 +914,5 @@ void GraphBuilder::printTour(const std::list<edge>& tour, bool compact,
   O << "The following tour contains " << tourGetChanges(tour) << " changes"
     << endl;
 
-  uint length[4];
-  for (int i = 0; i < 4; i++) {
-    MaxStringLength strLength =
-        std::for_each(column[i].begin(), column[i].end(), MaxStringLength());
-    length[i] = strLength.getMaxLength();
-  }
-
-  for (uint i = 0; i < column[0].size(); i++) {
-    O << " ";
-    for (int j = 0; j < 4; j++) {
-      O << column[j][i] << std::setw(length[j] - column[j][i].size() + 2)
-        << "\t";
-    }
-    O << endl;
-  }
+  printColumns(column, O);
 }
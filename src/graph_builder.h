@@ -17,6 +17,7 @@
 #ifndef UBAHN_GRAPH_BUILDER_H_
 #define UBAHN_GRAPH_BUILDER_H_
 
+#include <cstdint>
 #include <list>
 #include <map>
 #include <set>
@@ -26,6 +27,25 @@
 #include "base/graph.h"
 #include "transport_defs.h"
 
+/** The kind of movement an arc of the problem graph represents. */
+enum ArcType {
+  RIDE_ARC,    ///< riding a line between consecutive stations
+  CHANGE_ARC,  ///< changing to a different line within a station
+  SWITCH_ARC   ///< switching the direction of the same line
+};
+
+/**
+ * Where a tour passes a station whose nodes were all removed by the
+ * preprocessing. Riding the arc visits the station, and a tour that visits
+ * one of the anchor stations has to ride the arc.
+ */
+struct RemovedStop {
+  RemovedStop() : arc(nullptr) {}
+
+  leda::edge arc;
+  std::vector<std::string> anchors;
+};
+
 class GraphBuilder {
  public:
   GraphBuilder(const t_stationmap& stations, const t_linemap& lines,
@@ -38,6 +58,12 @@ class GraphBuilder {
 
   void printStatistics(std::ostream& O = std::cout) const;
 
+  /**
+   * Randomly permutes the order of the nodes and arcs in the graph. The
+   * problem is unchanged, but solvers see the variables in a different order.
+   */
+  void shuffle(uint32_t seed);
+
   void saveTexTour(const std::list<leda::edge>& tour, std::string start,
                    bool compact = true, std::ostream& O = std::cout) const;
   void saveTexTour(const std::list<leda::edge>& tour, bool compact = true,
@@ -49,14 +75,56 @@ class GraphBuilder {
   void printTour(const std::list<leda::edge>& tour, bool compact = true,
                  std::ostream& O = std::cout) const;
 
-  const leda::graph& getGraph() { return _g; }
-  const leda::edge_map<double>& getDist() { return _dist; }
-  const std::map<std::string, std::set<leda::node>>& getStationNodes() {
+  /** Returns the tour as a sequence of station and line names. */
+  std::vector<TourLeg> getTourLegs(const std::list<leda::edge>& tour) const;
+  /** Prints a tour given as legs in the compact format of printTour. */
+  static void printTourLegs(const std::vector<TourLeg>& legs,
+                            std::ostream& O = std::cout);
+
+  const leda::graph& getGraph() const { return _g; }
+  const t_stationmap& getStations() const { return _stations; }
+  const t_linemap& getLines() const { return _lines; }
+  const leda::edge_map<double>& getDist() const { return _dist; }
+  const std::map<std::string, std::set<leda::node>>& getStationNodes() const {
     return _station_nodes;
   }
-  const leda::edge_map<bool>& getConnections() { return _connection_arcs; }
+  /** Returns the stops of the stations removed by the preprocessing. */
+  const std::map<std::string, std::vector<RemovedStop>>& getRemovedStations()
+      const {
+    return _removed_stations;
+  }
+  /**
+   * Numbers the stations in the order of their names, as StationSolver does,
+   * and returns the number of stations.
+   */
+  int getStationIds(leda::node_array<int>* station_ids) const;
+  const leda::edge_map<bool>& getConnections() const {
+    return _connection_arcs;
+  }
+
+  /** Returns the line of each arc or CHANGE_NAME if it is not a ride. */
+  const leda::edge_map<std::string>& getArcNames() const { return _arc_names; }
+  const leda::edge_map<ArcType>& getArcTypes() const { return _arc_types; }
+  /** Returns the station, line and direction of the node. */
+  NodeKey getNodeKey(leda::node n) const {
+    return NodeKey(_node_names[n], _node_lines[n], _node_reverse[n]);
+  }
+  /** Returns the index of the station of the node within its line. */
+  int getNodePosition(leda::node n) const { return _node_positions[n]; }
+  /** Returns the station of each node. */
+  const leda::node_map<std::string>& getNodeNames() const {
+    return _node_names;
+  }
 
  private:
+  /** Tag for constructing a builder without running any of the passes. */
+  struct Unbuilt {};
+
+  GraphBuilder(const t_stationmap& stations, const t_linemap& lines,
+               double change_cost, double switch_cost, Unbuilt);
+
+  void build(ProblemType type, bool preprocess);
+
   void createNodesAndTravelArcs(
       std::map<std::string, std::map<std::string, leda::node>>& way_nodemap,
       std::map<std::string, std::map<std::string, leda::node>>& back_nodemap);
@@ -105,10 +173,18 @@ class GraphBuilder {
   leda::edge_map<double> _dist;
 
   std::map<std::string, std::set<leda::node>> _station_nodes;
+  std::map<std::string, std::vector<RemovedStop>> _removed_stations;
   leda::edge_map<bool> _connection_arcs;
 
   leda::edge_map<std::string> _arc_names;
+  leda::edge_map<ArcType> _arc_types;
   leda::node_map<std::string> _node_names;
+  leda::node_map<std::string> _node_lines;
+  leda::node_map<bool> _node_reverse;
+  leda::node_map<int> _node_positions;
+
+  // the microbenchmarks run the individual passes
+  friend class GraphBuilderPasses;
 };
 
 #endif  // UBAHN_GRAPH_BUILDER_H_
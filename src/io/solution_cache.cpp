@@ -0,0 +1,348 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/solution_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char HEADER[] = "ubahn-solution\t2";
+const char ENTRY_SUFFIX[] = ".sol";
+const char TEMP_SUFFIX[] = ".tmp";
+
+/// temporary files older than this are left overs of crashed writers
+const time_t STALE_TEMP_SECONDS = 3600;
+
+/** 64 bit FNV-1a hash with the given offset basis. */
+uint64_t fnv1a(const string& data, uint64_t basis) {
+  uint64_t hash = basis;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool hasSuffix(const string& name, const string& suffix) {
+  return name.size() >= suffix.size() &&
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/** Holds an exclusive lock on a file until it is destroyed. */
+class FileLock {
+ public:
+  explicit FileLock(const string& file)
+      : _fd(open(file.c_str(), O_RDWR | O_CREAT, 0644)) {
+    if (_fd < 0 || flock(_fd, LOCK_EX) != 0) {
+      if (_fd >= 0) close(_fd);
+      throw std::runtime_error("Cannot lock " + file);
+    }
+  }
+
+  ~FileLock() {
+    flock(_fd, LOCK_UN);
+    close(_fd);
+  }
+
+  // disallow copy and assign
+  FileLock(const FileLock&) = delete;
+  void operator=(FileLock) = delete;
+
+ private:
+  const int _fd;
+};
+
+struct EntryInfo {
+  string file;
+  double mtime;
+  uint64_t size;
+};
+
+/**
+ * Escapes the tabs, line breaks and backslashes of a name, so that it can be
+ * written as a field of a tab separated line.
+ */
+string escapeField(const string& field) {
+  string escaped;
+  for (char c : field) {
+    switch (c) {
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+/** Reverts escapeField, returns false if the field is not escaped properly. */
+bool unescapeField(const string& field, string* result) {
+  result->clear();
+  for (size_t i = 0; i < field.size(); i++) {
+    if (field[i] != '\\') {
+      *result += field[i];
+      continue;
+    }
+    if (++i == field.size()) return false;
+    switch (field[i]) {
+      case '\\':
+        *result += '\\';
+        break;
+      case 't':
+        *result += '\t';
+        break;
+      case 'n':
+        *result += '\n';
+        break;
+      case 'r':
+        *result += '\r';
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+/** Splits a line at tabs. */
+vector<string> splitFields(const string& line) {
+  vector<string> fields;
+  std::istringstream in(line);
+  string field;
+  while (std::getline(in, field, '\t')) {
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+bool readSolution(std::istream& in, const string& key,
+                  CachedSolution* solution) {
+  string line;
+  if (!std::getline(in, line) || line != HEADER) return false;
+  if (!std::getline(in, line) || line != "key\t" + key) return false;
+
+  string keyword;
+  int n_legs;
+  SolverStatistics& s = solution->statistics;
+  if (!(in >> keyword >> solution->objective) || keyword != "objective" ||
+      !(in >> keyword >> solution->solving_time) || keyword != "time" ||
+      !(in >> keyword >> s.variables >> s.rows >> s.lazy_cuts >>
+        s.callback_calls >> s.nodes >> s.pooled_cuts) ||
+      keyword != "statistics" || !(in >> keyword >> n_legs) ||
+      keyword != "legs" || n_legs < 0) {
+    return false;
+  }
+  std::getline(in, line);
+
+  solution->tour.clear();
+  for (int i = 0; i < n_legs; i++) {
+    if (!std::getline(in, line)) return false;
+
+    const vector<string> fields = splitFields(line);
+    if (fields.size() != 4) return false;
+
+    TourLeg leg;
+    if (!unescapeField(fields[0], &leg.from) ||
+        !unescapeField(fields[1], &leg.line) ||
+        !unescapeField(fields[2], &leg.to)) {
+      return false;
+    }
+    std::istringstream time(fields[3]);
+    if (!(time >> leg.time)) return false;
+    solution->tour.push_back(leg);
+  }
+
+  // the end marker proves that the entry is complete
+  return std::getline(in, line) && line == "end";
+}
+}  // namespace
+
+string computeCacheKey(const t_stationmap& stations, const t_linemap& lines,
+                       double change_cost, double switch_cost,
+                       ProblemType type, bool preprocess) {
+  // fields are separated by '\0', which cannot be part of a name
+  std::ostringstream canonical;
+  canonical << std::setprecision(17) << "ubahn" << '\0' << change_cost << '\0'
+            << switch_cost << '\0' << type << '\0' << preprocess << '\0';
+
+  // both maps are ordered by name, so the order of the input does not matter
+  for (const auto& station : stations) {
+    canonical << "S" << '\0' << station.first << '\0';
+    for (const string& line : station.second->lines) {
+      canonical << line << '\0';
+    }
+  }
+  for (const auto& line : lines) {
+    canonical << "L" << '\0' << line.first << '\0';
+    for (size_t i = 0; i < line.second->stations.size(); i++) {
+      canonical << line.second->stations[i] << '\0'
+                << line.second->times[i] << '\0';
+    }
+  }
+
+  // two independent hashes make accidental collisions practically impossible
+  const string data = canonical.str();
+  std::ostringstream key;
+  key << std::hex << std::setfill('0') << std::setw(16)
+      << fnv1a(data, 14695981039346656037ULL) << std::setw(16)
+      << fnv1a(data, 1099511628211ULL * 31);
+  return key.str();
+}
+
+SolutionCache::SolutionCache(const string& directory, uint64_t max_bytes,
+                             size_t max_entries)
+    : _directory(directory), _max_bytes(max_bytes), _max_entries(max_entries) {
+  if (mkdir(_directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw std::runtime_error("Cannot create cache directory " + _directory);
+  }
+}
+
+string SolutionCache::getEntryFile(const string& key) const {
+  return _directory + "/" + key + ENTRY_SUFFIX;
+}
+
+bool SolutionCache::lookup(const string& key, CachedSolution* solution) const {
+  const string file = getEntryFile(key);
+
+  std::ifstream in(file);
+  if (!in || !readSolution(in, key, solution)) {
+    return false;
+  }
+
+  // the modification time is the last access for the LRU eviction
+  utimensat(AT_FDCWD, file.c_str(), nullptr, 0);
+  return true;
+}
+
+void SolutionCache::store(const string& key, const CachedSolution& solution) {
+  std::ostringstream temp_file;
+  temp_file << getEntryFile(key) << "." << getpid() << "." << this
+            << TEMP_SUFFIX;
+
+  {
+    std::ofstream out(temp_file.str());
+    if (!out) {
+      throw std::runtime_error("Cannot write cache entry " + temp_file.str());
+    }
+
+    const SolverStatistics& s = solution.statistics;
+    out << HEADER << endl
+        << "key\t" << key << endl
+        << std::setprecision(17) << "objective\t" << solution.objective
+        << endl
+        << "time\t" << solution.solving_time << endl
+        << "statistics\t" << s.variables << " " << s.rows << " "
+        << s.lazy_cuts << " " << s.callback_calls << " " << s.nodes << " "
+        << s.pooled_cuts << endl
+        << "legs\t" << solution.tour.size() << endl;
+    for (const TourLeg& leg : solution.tour) {
+      out << escapeField(leg.from) << "\t" << escapeField(leg.line) << "\t"
+          << escapeField(leg.to) << "\t" << leg.time << endl;
+    }
+    out << "end" << endl;
+
+    if (!out) {
+      std::remove(temp_file.str().c_str());
+      throw std::runtime_error("Cannot write cache entry " + temp_file.str());
+    }
+  }
+
+  // renaming is atomic, concurrent readers see either no or the full entry
+  if (std::rename(temp_file.str().c_str(), getEntryFile(key).c_str()) != 0) {
+    std::remove(temp_file.str().c_str());
+    throw std::runtime_error("Cannot store cache entry " + key);
+  }
+
+  evict();
+}
+
+/** Removes the least recently used entries until the limits are met. */
+void SolutionCache::evict() {
+  // only one process at a time scans and cleans the directory
+  FileLock lock(_directory + "/.lock");
+
+  DIR* dir = opendir(_directory.c_str());
+  if (!dir) {
+    throw std::runtime_error("Cannot read cache directory " + _directory);
+  }
+
+  const time_t now = time(nullptr);
+  vector<EntryInfo> entries;
+  uint64_t total_bytes = 0;
+  while (dirent* entry = readdir(dir)) {
+    const string name = entry->d_name;
+    const string file = _directory + "/" + name;
+
+    struct stat info;
+    if (stat(file.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+
+    if (hasSuffix(name, TEMP_SUFFIX)) {
+      if (now - info.st_mtime > STALE_TEMP_SECONDS) {
+        std::remove(file.c_str());
+      }
+    } else if (hasSuffix(name, ENTRY_SUFFIX)) {
+      const double mtime = info.st_mtim.tv_sec + 1e-9 * info.st_mtim.tv_nsec;
+      entries.push_back({file, mtime, uint64_t(info.st_size)});
+      total_bytes += info.st_size;
+    }
+  }
+  closedir(dir);
+
+  std::sort(entries.begin(), entries.end(),
+            [](const EntryInfo& a, const EntryInfo& b) {
+              return a.mtime < b.mtime;
+            });
+
+  size_t n_entries = entries.size();
+  for (const EntryInfo& entry : entries) {
+    const bool too_large = _max_bytes > 0 && total_bytes > _max_bytes;
+    const bool too_many = _max_entries > 0 && n_entries > _max_entries;
+    if (!too_large && !too_many) break;
+
+    if (std::remove(entry.file.c_str()) == 0) {
+      total_bytes -= entry.size;
+      n_entries--;
+    }
+  }
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_IO_SOLUTION_CACHE_H_
+#define UBAHN_IO_SOLUTION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "solver/solver_statistics.h"
+#include "transport_defs.h"
+
+/** An optimal solution as it is stored in the cache. */
+struct CachedSolution {
+  CachedSolution() : objective(0.0), solving_time(0.0) {}
+
+  double objective;
+  double solving_time;  ///< the time the original solve took
+  SolverStatistics statistics;
+  std::vector<TourLeg> tour;
+};
+
+/**
+ * Returns the cache key of a problem. It is a hash of a canonical
+ * representation of the network and all parameters that influence the
+ * solution, so it does not depend on the formatting of the input file.
+ */
+std::string computeCacheKey(const t_stationmap& stations,
+                            const t_linemap& lines, double change_cost,
+                            double switch_cost, ProblemType type,
+                            bool preprocess);
+
+/**
+ * An on-disk cache of optimal solutions with one file per key. Entries are
+ * written to a temporary file and renamed, so that readers never see partial
+ * entries and several processes can share one directory. When the limits are
+ * exceeded, the least recently used entries are removed.
+ */
+class SolutionCache {
+ public:
+  /**
+   * Opens the cache, the directory is created if it does not exist.
+   * @param max_bytes maximal total size of all entries, 0 for no limit
+   * @param max_entries maximal number of entries, 0 for no limit
+   */
+  SolutionCache(const std::string& directory, uint64_t max_bytes,
+                size_t max_entries = 0);
+
+  // disallow copy and assign
+  SolutionCache(const SolutionCache&) = delete;
+  void operator=(SolutionCache) = delete;
+
+  /**
+   * Returns whether the cache contains the key and reads the solution.
+   * Unreadable entries are treated as misses.
+   */
+  bool lookup(const std::string& key, CachedSolution* solution) const;
+
+  /** Stores the solution, throws an exception if it cannot be written. */
+  void store(const std::string& key, const CachedSolution& solution);
+
+ private:
+  std::string getEntryFile(const std::string& key) const;
+  void evict();
+
+  const std::string _directory;
+  const uint64_t _max_bytes;
+  const size_t _max_entries;
+};
+
+#endif  // UBAHN_IO_SOLUTION_CACHE_H_
@@ -16,8 +16,10 @@
 
 #include <sys/stat.h>
 
+#include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
@@ -25,6 +27,7 @@
 
 #include "boost/lexical_cast.hpp"
 #include "xercesc/dom/DOM.hpp"
+#include "xercesc/framework/MemBufInputSource.hpp"
 #include "xercesc/parsers/XercesDOMParser.hpp"
 #include "xercesc/sax/HandlerBase.hpp"
 #include "xercesc/util/PlatformUtils.hpp"
@@ -42,8 +45,15 @@ using std::runtime_error;
 
 XERCES_CPP_NAMESPACE_USE
 
+namespace {
+
+/// Initialize and Terminate of Xerces are not thread safe
+std::mutex xerces_init_mutex;
+}  // namespace
+
 XMLReader::XMLReader() {
   try {
+    std::lock_guard<std::mutex> lock(xerces_init_mutex);
     XMLPlatformUtils::Initialize();
   } catch (const XMLException& toCatch) {
     char* message = XMLString::transcode(toCatch.getMessage());
@@ -87,6 +97,7 @@ XMLReader::~XMLReader() {
 
   // Terminate Xerces
   try {
+    std::lock_guard<std::mutex> lock(xerces_init_mutex);
     XMLPlatformUtils::Terminate();  // Terminate after release of memory
   } catch (xercesc::XMLException& e) {
     char* message = xercesc::XMLString::transcode(e.getMessage());
@@ -216,6 +227,20 @@ void XMLReader::readTransportFile(const std::string& xmlFile) {
   int iretStat = stat(xmlFile.c_str(), &fileStatus);
   if (iretStat != 0) throw(runtime_error("Cannot open file"));
 
+  readDocument(
+      [&](XercesDOMParser* parser) { parser->parse(xmlFile.c_str()); });
+}
+
+void XMLReader::readTransportBuffer(const std::string& xml) {
+  readDocument([&](XercesDOMParser* parser) {
+    MemBufInputSource source(reinterpret_cast<const XMLByte*>(xml.data()),
+                             xml.size(), "memory");
+    parser->parse(source);
+  });
+}
+
+void XMLReader::readDocument(
+    const std::function<void(XercesDOMParser*)>& parse) {
   _parser->setValidationScheme(XercesDOMParser::Val_Always);
   _parser->setDoNamespaces(true);  // optional
 
@@ -223,7 +248,7 @@ void XMLReader::readTransportFile(const std::string& xmlFile) {
   _parser->setErrorHandler(errHandler);
 
   try {
-    _parser->parse(xmlFile.c_str());
+    parse(_parser);
   } catch (const XMLException& toCatch) {
     char* message = XMLString::transcode(toCatch.getMessage());
     ostringstream errBuf;
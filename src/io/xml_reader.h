@@ -17,6 +17,7 @@
 #ifndef UBAHN_IO_XML_READER_H_
 #define UBAHN_IO_XML_READER_H_
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <stdexcept>
@@ -38,6 +39,9 @@ class XMLReader {
   /** Parses the given XML file. throws an exception if something went wrong */
   void readTransportFile(const std::string&);
 
+  /** Parses a network given as an XML document in memory. */
+  void readTransportBuffer(const std::string& xml);
+
   /** Prints some basic information about the read transportation network */
   void printStatistic(std::ostream& O = std::cout) const;
 
@@ -45,6 +49,10 @@ class XMLReader {
   const t_linemap& getLines() const { return _lines; }
 
  private:
+  /** Parses with the given function and extracts the network. */
+  void readDocument(
+      const std::function<void(XERCES_CPP_NAMESPACE::XercesDOMParser*)>&
+          parse);
   void extractStations(XERCES_CPP_NAMESPACE::DOMElement* eStations);
   void setLineStations(XERCES_CPP_NAMESPACE::DOMElement* eLine, Line* l);
   void extractLines(XERCES_CPP_NAMESPACE::DOMElement* eStations);
@@ -0,0 +1,92 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "io/xml_writer.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using std::endl;
+using std::ostream;
+using std::string;
+
+namespace {
+
+string escapeAttribute(const string& value) {
+  string escaped;
+  for (char c : value) {
+    switch (c) {
+      case '&':
+        escaped += "&amp;";
+        break;
+      case '<':
+        escaped += "&lt;";
+        break;
+      case '>':
+        escaped += "&gt;";
+        break;
+      case '"':
+        escaped += "&quot;";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+}  // namespace
+
+void writeTransportFile(const t_stationmap& stations, const t_linemap& lines,
+                        ostream& O) {
+  O << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << endl << endl;
+  O << "<transport xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+       "xsi:schemaLocation=\"transport.xsd\">"
+    << endl
+    << endl;
+
+  O << "  <stations>" << endl;
+  for (auto it = stations.begin(); it != stations.end(); ++it) {
+    O << "    <station name=\"" << escapeAttribute(it->second->name) << "\"/>"
+      << endl;
+  }
+  O << "  </stations>" << endl << endl;
+
+  O << "  <lines>" << endl;
+  for (auto it = lines.begin(); it != lines.end(); ++it) {
+    const Line* line = it->second;
+
+    O << "    <line name=\"" << escapeAttribute(line->name) << "\">" << endl;
+    O << "      <stations>" << endl;
+    for (size_t i = 0; i < line->stations.size(); i++) {
+      O << "        <station name=\"" << escapeAttribute(line->stations[i])
+        << "\" time=\"" << line->times[i] << "\"/>" << endl;
+    }
+    O << "      </stations>" << endl;
+    O << "    </line>" << endl << endl;
+  }
+  O << "  </lines>" << endl << endl;
+
+  O << "</transport>" << endl;
+}
+
+void writeTransportFile(const t_stationmap& stations, const t_linemap& lines,
+                        const string& xmlFile) {
+  std::ofstream out(xmlFile);
+  if (!out) {
+    throw std::runtime_error("Cannot create file " + xmlFile);
+  }
+
+  writeTransportFile(stations, lines, out);
+}
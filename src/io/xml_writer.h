@@ -0,0 +1,36 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_IO_XML_WRITER_H_
+#define UBAHN_IO_XML_WRITER_H_
+
+#include <iostream>
+#include <string>
+
+#include "transport_defs.h"
+
+/**
+ * Writes the network in the XML format described by transport.xsd, so that
+ * it can be read again by the XMLReader.
+ */
+void writeTransportFile(const t_stationmap& stations, const t_linemap& lines,
+                        std::ostream& O);
+
+/** Writes the network to the given file, throws if it cannot be created. */
+void writeTransportFile(const t_stationmap& stations, const t_linemap& lines,
+                        const std::string& xmlFile);
+
+#endif  // UBAHN_IO_XML_WRITER_H_
@@ -0,0 +1,191 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/batch_runner.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/utils.h"
+#include "ubahn_api.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+/** Sets the option of the job given as key=value, throws if invalid. */
+void setOption(const string& key, const string& value, BatchJob* job) {
+  if (key == "name") {
+    job->name = value;
+  } else if (key == "change") {
+    job->change_cost = boost::lexical_cast<double>(value);
+  } else if (key == "switch") {
+    job->switch_cost = boost::lexical_cast<double>(value);
+  } else if (key == "type" && (value == "station" || value == "segment")) {
+    job->type = value == "station" ? STATION : SEGMENT;
+  } else if (key == "preprocess" && (value == "on" || value == "off")) {
+    job->preprocess = value == "on";
+  } else if (key == "time_limit") {
+    job->time_limit = boost::lexical_cast<double>(value);
+  } else if (key == "threads") {
+    job->threads = boost::lexical_cast<int>(value);
+  } else {
+    throw std::runtime_error("Invalid option " + key + "=" + value);
+  }
+}
+}  // namespace
+
+vector<BatchJob> readBatchJobs(std::istream& in) {
+  vector<BatchJob> jobs;
+
+  string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    line_number++;
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream fields(line);
+    BatchJob job;
+    if (!(fields >> job.file)) continue;
+    job.name = job.file;
+
+    string field;
+    while (fields >> field) {
+      const size_t eq = field.find('=');
+      try {
+        if (eq == string::npos) {
+          throw std::runtime_error("Invalid option " + field);
+        }
+        setOption(field.substr(0, eq), field.substr(eq + 1), &job);
+      } catch (const std::exception& e) {
+        std::ostringstream errBuf;
+        errBuf << e.what() << " in line " << line_number;
+        throw std::runtime_error(errBuf.str());
+      }
+    }
+
+    jobs.push_back(job);
+  }
+
+  return jobs;
+}
+
+void BatchRunner::run(const vector<BatchJob>& jobs, ResultHandler handler) {
+  _next_job = 0;
+  _started_jobs = 0;
+  _free_cores = _cores;
+
+  // every running job occupies at least one core
+  const size_t n_workers =
+      std::min<size_t>(jobs.size(), std::max(1, _cores));
+
+  vector<std::thread> workers;
+  for (size_t i = 0; i < n_workers; i++) {
+    workers.emplace_back(&BatchRunner::runWorker, this, std::cref(jobs),
+                         std::cref(handler));
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+void BatchRunner::runWorker(const vector<BatchJob>& jobs,
+                            const ResultHandler& handler) {
+  while (true) {
+    size_t i;
+    int threads;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if (_next_job >= jobs.size()) return;
+      i = _next_job++;
+
+      threads = jobs[i].threads > 0 ? jobs[i].threads : _job_threads;
+      threads = std::max(1, std::min(threads, _cores));
+
+      // jobs start in order, so large jobs are not starved by smaller ones
+      _cores_freed.wait(lock, [&] {
+        return _started_jobs == i && _free_cores >= threads;
+      });
+      _started_jobs++;
+      _free_cores -= threads;
+    }
+    _cores_freed.notify_all();
+
+    BatchResult result;
+    result.job = i;
+    result.name = jobs[i].name;
+    result.threads = threads;
+    runJob(jobs[i], threads, &result);
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _free_cores += threads;
+    }
+    _cores_freed.notify_all();
+
+    std::lock_guard<std::mutex> lock(_handler_mutex);
+    handler(result);
+  }
+}
+
+void BatchRunner::runJob(const BatchJob& job, int threads,
+                         BatchResult* result) const {
+  SolveOptions options;
+  options.change_cost = job.change_cost;
+  options.switch_cost = job.switch_cost;
+  options.type = job.type;
+  options.preprocess = job.preprocess;
+  options.threads = threads;
+  options.time_limit = job.time_limit;
+
+  try {
+    const SolveResult solution = solveNetworkFile(job.file, options);
+
+    result->objective = solution.objective;
+    result->parse_ms = solution.parse_ms;
+    result->build_ms = solution.build_ms;
+    result->solve_ms = solution.solve_ms;
+    result->statistics = solution.statistics;
+    result->solved = true;
+  } catch (const std::exception& e) {
+    result->error = e.what();
+  }
+}
+
+void writeJsonLine(const BatchResult& r, std::ostream& O) {
+  O << "{\"job\": " << r.job << ", \"name\": " << quoteJson(r.name)
+    << ", \"threads\": " << r.threads
+    << ", \"solved\": " << (r.solved ? "true" : "false");
+  if (!r.solved) {
+    O << ", \"error\": " << quoteJson(r.error);
+  }
+  O << ", \"parse_ms\": " << r.parse_ms << ", \"build_ms\": " << r.build_ms
+    << ", \"solve_ms\": " << r.solve_ms;
+  if (r.solved) {
+    O << ", \"objective\": " << r.objective
+      << ", \"variables\": " << r.statistics.variables
+      << ", \"rows\": " << r.statistics.rows
+      << ", \"bb_nodes\": " << r.statistics.nodes
+      << ", \"lazy_cuts\": " << r.statistics.lazy_cuts
+      << ", \"callback_calls\": " << r.statistics.callback_calls;
+  }
+  O << "}" << std::endl;
+}
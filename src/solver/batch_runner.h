@@ -0,0 +1,126 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_BATCH_RUNNER_H_
+#define UBAHN_SOLVER_BATCH_RUNNER_H_
+
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "solver/solver_statistics.h"
+#include "transport_defs.h"
+
+/** One network file together with the configuration to solve it with. */
+struct BatchJob {
+  BatchJob()
+      : change_cost(5.0),
+        switch_cost(5.0),
+        type(STATION),
+        preprocess(true),
+        time_limit(0.0),
+        threads(0) {}
+
+  std::string name;
+  std::string file;
+  double change_cost;
+  double switch_cost;
+  ProblemType type;
+  bool preprocess;
+  double time_limit;  ///< in seconds, 0 for no limit
+  int threads;        ///< CPLEX threads, 0 for the default of the runner
+};
+
+struct BatchResult {
+  BatchResult()
+      : job(0),
+        threads(0),
+        solved(false),
+        objective(0.0),
+        parse_ms(0.0),
+        build_ms(0.0),
+        solve_ms(0.0) {}
+
+  size_t job;  ///< the index of the job in the manifest
+  std::string name;
+  int threads;
+  bool solved;
+  std::string error;  ///< the reason, if the job could not be solved
+
+  double objective;
+  double parse_ms;
+  double build_ms;
+  double solve_ms;  ///< including the creation of the model
+  SolverStatistics statistics;
+};
+
+/**
+ * Reads a job manifest, one job per line in the format
+ * "file [name=NAME] [change=COST] [switch=COST] [type=station|segment]
+ * [preprocess=on|off] [time_limit=SECONDS] [threads=N]".
+ * Empty lines and lines starting with # are ignored. Throws an exception on
+ * invalid input.
+ */
+std::vector<BatchJob> readBatchJobs(std::istream& in);
+
+/**
+ * Solves independent jobs on a pool of worker threads. Every job is read,
+ * built and solved from scratch within one worker. Jobs are started in the
+ * order of the manifest as soon as enough of the given cores are free for
+ * their CPLEX threads.
+ */
+class BatchRunner {
+ public:
+  typedef std::function<void(const BatchResult&)> ResultHandler;
+
+  BatchRunner(int cores, int job_threads)
+      : _cores(cores), _job_threads(job_threads) {}
+
+  // disallow copy and assign
+  BatchRunner(const BatchRunner&) = delete;
+  void operator=(BatchRunner) = delete;
+
+  /**
+   * Runs all jobs and calls the handler for every result as soon as its job
+   * is finished. The calls are serialized, but not in the order of the jobs.
+   */
+  void run(const std::vector<BatchJob>& jobs, ResultHandler handler);
+
+ private:
+  void runWorker(const std::vector<BatchJob>& jobs,
+                 const ResultHandler& handler);
+  void runJob(const BatchJob& job, int threads, BatchResult* result) const;
+
+  const int _cores;
+  const int _job_threads;
+
+  /// guards the scheduling state
+  std::mutex _mutex;
+  std::condition_variable _cores_freed;
+  size_t _next_job;
+  size_t _started_jobs;
+  int _free_cores;
+
+  std::mutex _handler_mutex;
+};
+
+/** Writes the result as a single line JSON object. */
+void writeJsonLine(const BatchResult& result, std::ostream& O);
+
+#endif  // UBAHN_SOLVER_BATCH_RUNNER_H_
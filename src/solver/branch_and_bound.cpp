@@ -0,0 +1,267 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/branch_and_bound.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "solver/euler.h"
+
+using leda::edge_array;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+typedef std::chrono::duration<double, std::milli> t_ms;
+
+const double INFINITE = std::numeric_limits<double>::infinity();
+
+/// the root gets more steps, its multipliers are the start of all others
+const int ROOT_ITERATIONS = 1000;
+const int NODE_ITERATIONS = 100;
+/// nodes whose bound is this close to the incumbent cannot improve it
+const double PRUNE_TOLERANCE = 1e-6;
+/// idle threads check the time limit at least this often
+const std::chrono::milliseconds IDLE_WAIT(10);
+}  // namespace
+
+BranchAndBound::BranchAndBound(const leda::graph& graph,
+                               const leda::node_array<int>& station_ids,
+                               int n_stations, const edge_array<double>& costs)
+    : _g(graph),
+      _station_ids(station_ids),
+      _n_stations(n_stations),
+      _costs(costs),
+      _required(n_stations, true),
+      _threads(0),
+      _time_limit_ms(0.0),
+      _open_nodes(0),
+      _queued_nodes(0),
+      _stopped(false),
+      _incumbent(INFINITE),
+      _optimal(false),
+      _lower_bound(-INFINITE),
+      _solution_value(0.0),
+      _solving_time(0.0) {}
+
+void BranchAndBound::solve() {
+  const int threads = _threads > 0
+                          ? _threads
+                          : std::max(1u, std::thread::hardware_concurrency());
+
+  _queues.clear();
+  for (int i = 0; i < threads; i++) {
+    _queues.emplace_back(new NodeQueue());
+  }
+  _open_nodes = 0;
+  _queued_nodes = 0;
+  _stopped = false;
+  _incumbent = INFINITE;
+  _incumbent_arcs.clear();
+  _statistics = SolverStatistics();
+
+  _timer.Reset();
+  _timer.Start();
+
+  unique_ptr<SearchNode> root(new SearchNode());
+  root->bound = -INFINITE;
+  push(0, std::move(root));
+
+  vector<std::thread> workers;
+  for (int i = 0; i < threads; i++) {
+    workers.emplace_back(&BranchAndBound::runWorker, this, i);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  // the nodes left after a timeout bound the optimum
+  _lower_bound = _incumbent;
+  for (const auto& queue : _queues) {
+    for (const auto& search_node : queue->heap) {
+      _lower_bound = std::min(_lower_bound, search_node->bound);
+    }
+  }
+  _optimal = _open_nodes == 0 && _incumbent < INFINITE;
+
+  _solution_tour.clear();
+  if (!_incumbent_arcs.empty()) {
+    _solution_tour = buildEulerTour(_g, _incumbent_arcs);
+    _solution_value = _incumbent;
+  }
+  _solving_time = _timer.Elapsed<std::chrono::duration<double>>().count();
+}
+
+void BranchAndBound::runWorker(int worker) {
+  LagrangianBound bound(_g, _station_ids, _n_stations, _costs);
+  for (int station = 0; station < _n_stations; station++) {
+    bound.setRequired(station, _required[station]);
+  }
+  bound.setSeparation(true);
+  bound.setGap(0.0);
+
+  unique_ptr<SearchNode> search_node;
+  while (takeNode(worker, &search_node)) {
+    process(worker, &bound, std::move(search_node));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_open_nodes == 0) _nodes_changed.notify_all();
+  }
+}
+
+/**
+ * Takes the node with the lowest bound of the own queue, or of the first
+ * other queue that is not empty. Waits while all nodes are being processed,
+ * and returns false once there are no nodes left or the time is up.
+ */
+bool BranchAndBound::takeNode(int worker, unique_ptr<SearchNode>* search_node) {
+  const int n_queues = _queues.size();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while (true) {
+        if (_time_limit_ms > 0 &&
+            _timer.Elapsed<t_ms>().count() > _time_limit_ms) {
+          _stopped = true;
+        }
+        if (_stopped || _open_nodes == 0) return false;
+        if (_queued_nodes > 0) break;
+
+        _nodes_changed.wait_for(lock, IDLE_WAIT);
+      }
+    }
+
+    for (int i = 0; i < n_queues; i++) {
+      NodeQueue& queue = *_queues[(worker + i) % n_queues];
+      {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.heap.empty()) continue;
+
+        std::pop_heap(queue.heap.begin(), queue.heap.end(),
+                      SearchNodeOrder());
+        *search_node = std::move(queue.heap.back());
+        queue.heap.pop_back();
+      }
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _queued_nodes--;
+      if (i > 0) _statistics.stolen_nodes++;
+      return true;
+    }
+  }
+}
+
+/**
+ * Bounds the node and splits it, unless it cannot contain a better tour. The
+ * arc to branch on is the most expensive free arc of the circulation giving
+ * the bound, its exclusion is the first child.
+ */
+void BranchAndBound::process(int worker, LagrangianBound* bound,
+                             unique_ptr<SearchNode> search_node) {
+  double cutoff;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statistics.nodes++;
+    cutoff = _incumbent - PRUNE_TOLERANCE;
+  }
+  if (search_node->bound >= cutoff) return;
+
+  bound->clearFixings();
+  for (const auto& fixing : search_node->fixings) {
+    bound->fixArc(fixing.first, fixing.second);
+  }
+  bound->setMultipliers(search_node->multipliers);
+  bound->setCuts(search_node->cuts);
+  bound->setCutoff(cutoff);
+  bound->setIterationLimit(search_node->fixings.empty() ? ROOT_ITERATIONS
+                                                        : NODE_ITERATIONS);
+  if (_time_limit_ms > 0) {
+    bound->setTimeLimit(
+        std::max(1.0, _time_limit_ms - _timer.Elapsed<t_ms>().count()));
+  }
+  const BoundResult result = bound->compute();
+
+  cutoff = offerTour(result) - PRUNE_TOLERANCE;
+  if (result.lower_bound >= cutoff) return;
+
+  edge branch = nullptr;
+  for (edge e : result.circulation) {
+    if (bound->getFixing(e) == FREE_ARC &&
+        (!branch || _costs[e] > _costs[branch])) {
+      branch = e;
+    }
+  }
+  // a circulation of fixed arcs still misses arcs that are free
+  if (!branch) {
+    edge e;
+    forall_edges(e, _g) {
+      if (bound->getFixing(e) == FREE_ARC) {
+        branch = e;
+        break;
+      }
+    }
+  }
+  // with all arcs fixed, the circulation was the only candidate
+  if (!branch) return;
+
+  // cuts without a multiplier are separated again if they are needed
+  vector<RelaxedCut> cuts;
+  for (const RelaxedCut& cut : result.cuts) {
+    if (cut.multiplier > 0.0) cuts.push_back(cut);
+  }
+
+  for (ArcFixing fixing : {EXCLUDED_ARC, FORCED_ARC}) {
+    unique_ptr<SearchNode> child(new SearchNode());
+    child->bound = result.lower_bound;
+    child->fixings = search_node->fixings;
+    child->fixings.push_back(std::make_pair(branch, fixing));
+    child->multipliers = result.multipliers;
+    child->cuts = cuts;
+    push(worker, std::move(child));
+  }
+}
+
+void BranchAndBound::push(int worker, unique_ptr<SearchNode> search_node) {
+  {
+    NodeQueue& queue = *_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.heap.push_back(std::move(search_node));
+    std::push_heap(queue.heap.begin(), queue.heap.end(), SearchNodeOrder());
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _open_nodes++;
+  _queued_nodes++;
+  _nodes_changed.notify_one();
+}
+
+/** Keeps the tour of the result, if it is the best one, and returns that. */
+double BranchAndBound::offerTour(const BoundResult& result) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (result.upper_bound < _incumbent) {
+    _incumbent = result.upper_bound;
+    _incumbent_arcs = result.tour;
+    _statistics.improved_tours++;
+  }
+  return _incumbent;
+}
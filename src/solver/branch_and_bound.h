@@ -0,0 +1,160 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_BRANCH_AND_BOUND_H_
+#define UBAHN_SOLVER_BRANCH_AND_BOUND_H_
+
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "base/graph.h"
+#include "base/timer.h"
+#include "solver/lagrangian_bound.h"
+#include "solver/solver_statistics.h"
+
+/**
+ * Solves the station problem exactly without CPLEX. Every search node is
+ * bounded by the Lagrangian relaxation of LagrangianBound with the subtours
+ * of its circulations relaxed as well, and split by excluding or forcing an
+ * arc of the circulation. Each thread processes the nodes with the lowest
+ * bound of its own queue first and takes those of another thread once its
+ * queue is empty. The tours found by the relaxation are shared by all
+ * threads.
+ */
+class BranchAndBound {
+ public:
+  /**
+   * @param graph problem graph
+   * @param station_ids maps each node to the id of its station
+   * @param n_stations number of stations
+   * @param costs the cost of every arc
+   */
+  BranchAndBound(const leda::graph& graph,
+                 const leda::node_array<int>& station_ids, int n_stations,
+                 const leda::edge_array<double>& costs);
+
+  // disallow copy and assign
+  BranchAndBound(const BranchAndBound&) = delete;
+  void operator=(BranchAndBound) = delete;
+
+  /** Sets whether the tour must visit the station. */
+  void setRequired(int station, bool required) {
+    _required[station] = required;
+  }
+
+  /** Sets the number of threads, 0 uses all cores, the default. */
+  void setThreads(int threads) { _threads = threads; }
+
+  /** Limits the time in milliseconds, 0 means no limit, the default. */
+  void setTimeLimit(double ms) { _time_limit_ms = ms; }
+
+  void solve();
+
+  /** Returns whether the search proved the tour to be optimal. */
+  bool isOptimal() const { return _optimal; }
+
+  /** Returns the best tour, throws an exception if none was found. */
+  const std::list<leda::edge>& getSolutionTour() const {
+    if (_solution_tour.empty()) {
+      throw std::runtime_error("No solution available");
+    }
+
+    return _solution_tour;
+  }
+
+  /** Returns the cost of the best tour, throws if none was found. */
+  const double& getSolutionValue() const {
+    if (_solution_tour.empty()) {
+      throw std::runtime_error("No solution available");
+    }
+
+    return _solution_value;
+  }
+
+  /** Returns the lowest bound of the nodes left when the search stopped. */
+  double getLowerBound() const { return _lower_bound; }
+
+  /** Returns the solving time in seconds. */
+  const double& getTime() const { return _solving_time; }
+
+  const SolverStatistics& getStatistics() const { return _statistics; }
+
+ private:
+  /** A node of the search tree. */
+  struct SearchNode {
+    double bound;  ///< the lower bound of the parent
+    std::vector<std::pair<leda::edge, ArcFixing>> fixings;
+    std::vector<double> multipliers;  ///< to start the relaxation from
+    std::vector<RelaxedCut> cuts;
+  };
+
+  /** Puts the nodes with the lowest bound, and then the deepest, first. */
+  struct SearchNodeOrder {
+    bool operator()(const std::unique_ptr<SearchNode>& a,
+                    const std::unique_ptr<SearchNode>& b) const {
+      if (a->bound != b->bound) return a->bound > b->bound;
+      return a->fixings.size() < b->fixings.size();
+    }
+  };
+
+  /** The open nodes of one thread, ordered by their bound. */
+  struct NodeQueue {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<SearchNode>> heap;
+  };
+
+  void runWorker(int worker);
+  bool takeNode(int worker, std::unique_ptr<SearchNode>* search_node);
+  void process(int worker, LagrangianBound* bound,
+               std::unique_ptr<SearchNode> search_node);
+  void push(int worker, std::unique_ptr<SearchNode> search_node);
+  double offerTour(const BoundResult& result);
+
+  const leda::graph& _g;
+  const leda::node_array<int>& _station_ids;
+  const int _n_stations;
+  const leda::edge_array<double>& _costs;
+
+  std::vector<bool> _required;
+  int _threads;
+  double _time_limit_ms;
+
+  std::vector<std::unique_ptr<NodeQueue>> _queues;
+  Timer _timer;
+
+  /// guards the incumbent, the statistics and the counters below
+  std::mutex _mutex;
+  std::condition_variable _nodes_changed;
+  long _open_nodes;    ///< queued nodes and nodes being processed
+  long _queued_nodes;  ///< nodes in any of the queues
+  bool _stopped;
+  double _incumbent;
+  std::vector<leda::edge> _incumbent_arcs;
+
+  bool _optimal;
+  double _lower_bound;
+  double _solution_value;
+  std::list<leda::edge> _solution_tour;
+  double _solving_time;
+  SolverStatistics _statistics;
+};
+
+#endif  // UBAHN_SOLVER_BRANCH_AND_BOUND_H_
@@ -0,0 +1,112 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/branching.h"
+
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+using leda::edge_array;
+using leda::node_map;
+using std::map;
+using std::string;
+using std::vector;
+
+BranchWeights parseBranchWeights(const string& weights) {
+  vector<int> values;
+  std::istringstream in(weights);
+  string value;
+  try {
+    while (std::getline(in, value, ',')) {
+      values.push_back(boost::lexical_cast<int>(value));
+    }
+  } catch (const boost::bad_lexical_cast&) {
+    values.clear();
+  }
+  if (values.size() != 4) {
+    throw std::runtime_error("Invalid branch weights " + weights +
+                             ", expected RIDE,CHANGE,SWITCH,DEGREE");
+  }
+
+  BranchWeights result;
+  result.ride = values[0];
+  result.change = values[1];
+  result.switching = values[2];
+  result.degree = values[3];
+  return result;
+}
+
+edge_array<double> getBranchPriorities(const GraphBuilder& builder,
+                                       const BranchWeights& weights) {
+  const graph& g = builder.getGraph();
+  const node_map<string>& stations = builder.getNodeNames();
+
+  // the number of arcs leaving each station
+  map<string, int> degrees;
+  edge e;
+  forall_edges(e, g) {
+    if (stations[source(e)] != stations[target(e)]) {
+      degrees[stations[source(e)]]++;
+    }
+  }
+
+  edge_array<double> priorities(g, 0.0);
+  forall_edges(e, g) {
+    switch (builder.getArcTypes()[e]) {
+      case RIDE_ARC:
+        priorities[e] = weights.ride;
+        break;
+      case CHANGE_ARC:
+        priorities[e] = weights.change;
+        break;
+      case SWITCH_ARC:
+        priorities[e] = weights.switching;
+        break;
+    }
+    priorities[e] += weights.degree * degrees[stations[source(e)]];
+  }
+
+  return priorities;
+}
+
+vector<vector<edge>> getStationLineGroups(const GraphBuilder& builder) {
+  const graph& g = builder.getGraph();
+  const node_map<string>& stations = builder.getNodeNames();
+
+  map<std::pair<string, string>, vector<edge>> groups;
+  edge e;
+  forall_edges(e, g) {
+    if (builder.getArcTypes()[e] != RIDE_ARC) continue;
+
+    const string& from = stations[source(e)];
+    const string& to = stations[target(e)];
+    if (from == to) continue;
+
+    const string& line = builder.getArcNames()[e];
+    groups[std::make_pair(from, line)].push_back(e);
+    groups[std::make_pair(to, line)].push_back(e);
+  }
+
+  vector<vector<edge>> result;
+  for (auto& group : groups) {
+    result.push_back(std::move(group.second));
+  }
+  return result;
+}
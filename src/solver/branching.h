@@ -0,0 +1,57 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_BRANCHING_H_
+#define UBAHN_SOLVER_BRANCHING_H_
+
+#include <string>
+#include <vector>
+
+#include "base/graph.h"
+#include "graph_builder.h"
+
+/**
+ * The branching priority of the arcs by their type, CPLEX branches on the
+ * arcs with the highest priority first. Changing lines and switching the
+ * direction decide the structure of a tour, while most rides follow from it.
+ */
+struct BranchWeights {
+  BranchWeights() : ride(0), change(10), switching(10), degree(1) {}
+
+  int ride;
+  int change;
+  int switching;
+  int degree;  ///< added for every arc leaving the station of the arc
+};
+
+/**
+ * Returns the weights given as RIDE,CHANGE,SWITCH,DEGREE. Throws an
+ * exception if they cannot be parsed.
+ */
+BranchWeights parseBranchWeights(const std::string& weights);
+
+/** Returns the branching priority of every arc of the graph. */
+leda::edge_array<double> getBranchPriorities(const GraphBuilder& builder,
+                                             const BranchWeights& weights);
+
+/**
+ * Returns the ride arcs entering or leaving each station on each line. A
+ * tour visits the station via the line if it uses one of them.
+ */
+std::vector<std::vector<leda::edge>> getStationLineGroups(
+    const GraphBuilder& builder);
+
+#endif  // UBAHN_SOLVER_BRANCHING_H_
@@ -0,0 +1,128 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/closure_runner.h"
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "base/parallel.h"
+
+using std::string;
+using std::vector;
+
+bool parseClosureField(const string& field, Closure* closure) {
+  if (field.compare(0, 8, "station=") == 0) {
+    closure->stations.insert(field.substr(8));
+    return true;
+  }
+
+  const size_t first = field.find('|');
+  const size_t second = field.find('|', first + 1);
+  if (field.compare(0, 8, "segment=") != 0 || first == string::npos ||
+      second == string::npos) {
+    return false;
+  }
+  closure->segments.emplace_back(field.substr(8, first - 8),
+                                 field.substr(first + 1, second - first - 1),
+                                 field.substr(second + 1));
+  return true;
+}
+
+vector<ClosureScenario> readClosures(std::istream& in) {
+  vector<ClosureScenario> scenarios;
+
+  string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    line_number++;
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream fields(line);
+    ClosureScenario scenario;
+    std::getline(fields, scenario.name, '\t');
+
+    string field;
+    while (std::getline(fields, field, '\t')) {
+      if (!field.empty() && !parseClosureField(field, &scenario.closure)) {
+        std::ostringstream errBuf;
+        errBuf << "Invalid closure \"" << field << "\" in line "
+               << line_number;
+        throw std::runtime_error(errBuf.str());
+      }
+    }
+
+    if (scenario.name.empty()) {
+      std::ostringstream errBuf;
+      errBuf << "Missing scenario name in line " << line_number;
+      throw std::runtime_error(errBuf.str());
+    }
+
+    scenarios.push_back(scenario);
+  }
+
+  return scenarios;
+}
+
+vector<ScenarioResult> ClosureRunner::run(
+    const vector<ClosureScenario>& scenarios, int threads) const {
+  vector<ScenarioResult> results(scenarios.size());
+
+  runInBlocks(scenarios.size(), threads, [&](size_t begin, size_t end) {
+    runBlock(scenarios, begin, end, &results);
+  });
+
+  return results;
+}
+
+void ClosureRunner::runBlock(const vector<ClosureScenario>& scenarios,
+                             size_t begin, size_t end,
+                             vector<ScenarioResult>* results) const {
+  if (begin >= end) return;
+
+  for (size_t i = begin; i < end; i++) {
+    (*results)[i].name = scenarios[i].name;
+  }
+
+  // every block needs the unrestricted optimum as reference
+  std::unique_ptr<SolverSession> session;
+  ScenarioResult base;
+  try {
+    session.reset(new SolverSession(_stations, _lines, _change_cost,
+                                    _switch_cost, _preprocess));
+    session->setVerbose(false);
+    solveSession(session.get(), &base);
+  } catch (const std::runtime_error& e) {
+    for (size_t i = begin; i < end; i++) {
+      (*results)[i].error = e.what();
+    }
+    return;
+  }
+
+  for (size_t i = begin; i < end; i++) {
+    ScenarioResult& result = (*results)[i];
+    result.has_base = true;
+    result.base_objective = base.objective;
+
+    try {
+      session->setClosure(scenarios[i].closure);
+      solveSession(session.get(), &result);
+    } catch (const std::runtime_error& e) {
+      result.error = e.what();
+    }
+  }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_CLOSURE_RUNNER_H_
+#define UBAHN_SOLVER_CLOSURE_RUNNER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "solver/scenario_runner.h"
+#include "solver/solver_session.h"
+#include "transport_defs.h"
+
+struct ClosureScenario {
+  std::string name;
+  Closure closure;
+};
+
+/**
+ * Adds a field "station=NAME" or "segment=LINE|FROM|TO" to the closure.
+ * Returns false if the field has a different format.
+ */
+bool parseClosureField(const std::string& field, Closure* closure);
+
+/**
+ * Reads closure scenarios, one per line. The tab separated fields are the
+ * name followed by any number of "station=NAME" and "segment=LINE|FROM|TO".
+ * Empty lines and lines starting with # are ignored. Throws an exception on
+ * invalid input.
+ */
+std::vector<ClosureScenario> readClosures(std::istream& in);
+
+/**
+ * Solves a list of closure scenarios on one network. Each thread builds the
+ * graph and the model once, solves the unrestricted problem and then a
+ * contiguous block of closures by changing only bounds, each warm-started
+ * from the previous tour.
+ */
+class ClosureRunner {
+ public:
+  ClosureRunner(const t_stationmap& stations, const t_linemap& lines,
+                double change_cost, double switch_cost, bool preprocess = true)
+      : _stations(stations),
+        _lines(lines),
+        _change_cost(change_cost),
+        _switch_cost(switch_cost),
+        _preprocess(preprocess) {}
+
+  // disallow copy and assign
+  ClosureRunner(const ClosureRunner&) = delete;
+  void operator=(ClosureRunner) = delete;
+
+  /**
+   * Returns the results in the order of the scenarios, with the unrestricted
+   * optimum as their base objective.
+   */
+  std::vector<ScenarioResult> run(const std::vector<ClosureScenario>& scenarios,
+                                 int threads) const;
+
+ private:
+  void runBlock(const std::vector<ClosureScenario>& scenarios, size_t begin,
+                size_t end, std::vector<ScenarioResult>* results) const;
+
+  const t_stationmap& _stations;
+  const t_linemap& _lines;
+  const double _change_cost;
+  const double _switch_cost;
+  const bool _preprocess;
+};
+
+#endif  // UBAHN_SOLVER_CLOSURE_RUNNER_H_
@@ -28,23 +28,97 @@ using LEDA::node_array;
 using LEDA::edge_array;
 using LEDA::edge_map;
 
-void CplexSolver::solve(bool use_callback, IloCplex::Callback cb) {
+namespace {
+/// nodes are pruned if their bound is this close to the shared incumbent
+const double CUTOFF_TOLERANCE = 1e-6;
+}  // namespace
+
+ILOINCUMBENTCALLBACK1(SharedIncumbentCallback, CplexSolver*, solver) {
+  IloNumArray x(getEnv());
+  getValues(x, solver->getCplexVars());
+
+  // candidates with subtours are rejected by the lazy constraints anyway
+  try {
+    const std::list<edge> tour = solver->buildEulerTour(x.toIntArray());
+    solver->_shared_incumbent->offer(solver->_racer, getObjValue(), tour);
+  } catch (const std::runtime_error&) {
+  }
+  x.end();
+}
+
+ILOBRANCHCALLBACK1(SharedCutoffCallback, CplexSolver*, solver) {
+  if (solver->canPrune(getObjValue())) {
+    prune();
+  }
+}
+
+bool CplexSolver::canPrune(double bound) const {
+  return _shared_incumbent &&
+         bound >= _shared_incumbent->getValue() - CUTOFF_TOLERANCE;
+}
+
+void CplexSolver::solve(const vector<IloCplex::Callback>& callbacks) {
   // reset the current solution
   _solution_found = false;
   _solution_value = 0.0;
   _solution_tour.clear();
+  _statistics = SolverStatistics();
+  _cut_off = false;
 
   try {
-    if (use_callback) {
+    // the callbacks of an earlier solve must not be called twice
+    _cplex->clearCallbacks();
+    if (_shared_incumbent) {
+      _cplex->setParam(IloCplex::MIPSearch, IloCplex::Traditional);
+      _cplex->use(SharedIncumbentCallback(_env, this));
+      _cplex->use(SharedCutoffCallback(_env, this));
+    }
+    if (!callbacks.empty()) {
       // only set this parameter, so that we don't get a warning at runtime
       _cplex->setParam(IloCplex::MIPSearch, IloCplex::Traditional);
 
-      // use the subtour callback
-      _cplex->use(cb);
+      // e.g. the subtour callback, later ones replace those of the same kind
+      for (IloCplex::Callback cb : callbacks) {
+        _cplex->use(cb);
+      }
+    }
+
+    if (_cplex->getNMIPStarts() > 0) {
+      _cplex->deleteMIPStarts(0, _cplex->getNMIPStarts());
+    }
+    // the last solution might be infeasible after changes to the model, CPLEX
+    // then tries to repair or discards it
+    if (_warm_start && _has_incumbent) {
+      _cplex->addMIPStart(getCplexVars(), _incumbent);
     }
 
     bool cplex_solved = _cplex->solve();
 
+    if (_aborted) {
+      throw std::runtime_error("Aborted: No optimal solution found");
+    }
+
+    _statistics.variables = _cplex->getNcols();
+    _statistics.rows = _cplex->getNrows();
+    _statistics.nodes = _cplex->getNnodes();
+
+    // all nodes that might contain a better tour were pruned
+    if (_shared_incumbent) {
+      _cut_off = cplex_solved
+                     ? _cplex->getObjValue() >=
+                           _shared_incumbent->getValue() - CUTOFF_TOLERANCE
+                     : _cplex->getStatus() == IloAlgorithm::Infeasible &&
+                           _shared_incumbent->getValue() < IloInfinity;
+      if (_cut_off && !cplex_solved) {
+        throw std::runtime_error("Cut off: The shared tour is optimal");
+      }
+    }
+
+    // a limit was reached before optimality was proven
+    if (cplex_solved && _cplex->getStatus() == IloAlgorithm::Feasible) {
+      throw std::runtime_error("Limit reached: No optimal solution found");
+    }
+
     // the problem should be infeasible or solved optimally
     if (!cplex_solved || _cplex->getStatus() != IloAlgorithm::Optimal) {
       throw std::runtime_error("Invalid model: No optimal solution found");
@@ -57,8 +131,14 @@ void CplexSolver::solve(bool use_callback, IloCplex::Callback cb) {
     _cplex->getValues(x, getCplexVars());
 
     // this already throws a runtime_error if the garph is not eulerian
-    buildSolutionTour(x.toIntArray());
-    x.end();
+    _solution_tour = buildEulerTour(x.toIntArray());
+
+    // keep the solution for a warm start of the next solve
+    if (_has_incumbent) {
+      _incumbent.end();
+    }
+    _incumbent = x;
+    _has_incumbent = true;
 
     // if everything went well up to this point, we actually found a valid
     // solutions
@@ -70,62 +150,16 @@ void CplexSolver::solve(bool use_callback, IloCplex::Callback cb) {
   }
 }
 
-void CplexSolver::buildSolutionTour(const IloIntArray& int_vals) {
-  leda::graph eulerGraph;
-
-  node_array<node> eulerNodes(_g, 0);
-
-  // in the new graph make a copy for every node in the original graph
-  node n;
-  forall_nodes(n, _g) {
-    const node eulerNode = eulerGraph.new_node();
-
-    eulerNodes[n] = eulerNode;
-  }
-
-  edge_map<edge> edgeRef(eulerGraph);
-
-  // now add only the used arcs to the euler graph
-  node startNode = nullptr;
+std::list<edge> CplexSolver::buildEulerTour(
+    const IloIntArray& int_vals) const {
+  // if the value is greater than 1, the arc is used multiple times
+  std::vector<edge> arcs;
   edge e;
   forall_edges(e, _g) {
-    // the start node is the first node, that has an outgoing arc
-    if (!startNode && int_vals[getCplexId(e)] > 0) {
-      startNode = eulerNodes[source(e)];
-    }
-
-    // if the value is greater than 1, we need to construct multiple parallel
-    // edges
     for (int i = 1; i <= int_vals[getCplexId(e)]; i++) {
-      const edge eulerEdge =
-          eulerGraph.new_edge(eulerNodes[source(e)], eulerNodes[target(e)]);
-      edgeRef[eulerEdge] = e;
+      arcs.push_back(e);
     }
   }
-  assert(startNode);
-
-  Euler euler(eulerGraph);
 
-  std::list<edge> eulerTour;
-  try {
-    eulerTour = euler.getEulerTour(startNode);
-  } catch (const std::runtime_error& e) {
-    std::ostringstream errBuf;
-    errBuf << "Invalid solution: " << e.what();
-    throw std::runtime_error(errBuf.str());
-  }
-
-  int selected_arcs = 0;
-  forall_edges(e, _g) { selected_arcs += int_vals[getCplexId(e)]; }
-
-  if (selected_arcs != eulerTour.size()) {
-    throw std::runtime_error("Invalid solution: Solution contains sub tours");
-  }
-
-  // finally, transform the Euler Tour back to the original graph
-  _solution_tour.clear();
-  for (edge e : eulerTour) {
-    edge original_edge = edgeRef[e];
-    _solution_tour.push_back(original_edge);
-  }
+  return ::buildEulerTour(_g, arcs);
 }
@@ -17,25 +17,96 @@
 #ifndef UBAHN_SOLVER_CPLEX_SOLVER_H_
 #define UBAHN_SOLVER_CPLEX_SOLVER_H_
 
+#include <atomic>
+#include <future>
 #include <list>
+#include <memory>
+#include <vector>
 
 #include "ilcplex/ilocplex.h"
 
 #include "base/graph.h"
+#include "solver/shared_incumbent.h"
+#include "solver/solver_statistics.h"
 #include "transport_defs.h"
 
+/**
+ * The CPLEX environment with an empty model. Creating it starts CPLEX and
+ * checks the license, which does not depend on the problem, so it can be done
+ * while the network is read and the graph is built.
+ */
+class CplexEnvironment {
+ public:
+  CplexEnvironment() : _model(nullptr), _cplex(nullptr) {
+    _model = new IloModel(_env);
+    _cplex = new IloCplex(*_model);
+  }
+
+  /** Frees everything, unless a solver has taken over the environment. */
+  ~CplexEnvironment() {
+    if (_cplex) {
+      _cplex->end();
+      delete _cplex;
+      delete _model;
+      _env.end();
+    }
+  }
+
+  // disallow copy and assign
+  CplexEnvironment(const CplexEnvironment&) = delete;
+  void operator=(CplexEnvironment) = delete;
+
+  /**
+   * Creates an environment in a background thread. With a deferred policy it
+   * is created by the thread calling get() instead.
+   */
+  static std::future<std::unique_ptr<CplexEnvironment>> createAsync(
+      std::launch policy = std::launch::async) {
+    return std::async(policy, [] {
+      return std::unique_ptr<CplexEnvironment>(new CplexEnvironment());
+    });
+  }
+
+ private:
+  friend class CplexSolver;
+
+  IloEnv _env;
+  IloModel* _model;
+  IloCplex* _cplex;
+};
+
 class CplexSolver {
  public:
-  // number of threads that should be used
+  // number of threads that should be used by default
   static const int NUM_THREADS = 1;
 
   explicit CplexSolver(const leda::graph& graph)
-      : _g(graph), _cplex(nullptr), _model(nullptr), _solution_found(false) {
-    _model = new IloModel(_env);
+      : CplexSolver(graph, std::unique_ptr<CplexEnvironment>(
+                               new CplexEnvironment())) {}
+
+  /** Creates the solver in an environment that was created in advance. */
+  CplexSolver(const leda::graph& graph,
+              std::unique_ptr<CplexEnvironment> environment)
+      : _g(graph),
+        _env(environment->_env),
+        _cplex(environment->_cplex),
+        _model(environment->_model),
+        _warm_start(true),
+        _has_incumbent(false),
+        _shared_incumbent(nullptr),
+        _racer(-1),
+        _cut_off(false),
+        _aborted(false),
+        _solution_found(false) {
+    // the solver is responsible for freeing the environment now
+    environment->_cplex = nullptr;
+    environment->_model = nullptr;
 
-    _cplex = new IloCplex(*_model);
     _epInt = _cplex->getParam(IloCplex::EpInt);
 
+    _aborter = IloCplex::Aborter(_env);
+    _cplex->use(_aborter);
+
     // force one thread only
     _cplex->setParam(IloCplex::Threads, NUM_THREADS);
 
@@ -46,6 +117,7 @@ class CplexSolver {
   }
 
   virtual ~CplexSolver() {
+    _aborter.end();
     if (_cplex) {
       _cplex->end();
       delete _cplex;
@@ -75,12 +147,90 @@ class CplexSolver {
     return _solving_time;
   }
 
- protected:
-  void solve(bool use_callback, IloCplex::Callback cb = nullptr);
+  const SolverStatistics& getStatistics() const { return _statistics; }
+
+  /**
+   * Sets the random seed of CPLEX. Different seeds lead to different search
+   * paths and are used to measure the performance variability.
+   */
+  void setRandomSeed(int seed) { _cplex->setParam(IloCplex::RandomSeed, seed); }
+
+  /** Sets the number of threads CPLEX may use for one solve. */
+  void setThreads(int threads) { _cplex->setParam(IloCplex::Threads, threads); }
+
+  /**
+   * Limits the time of each solve in seconds. If the limit is reached before
+   * the optimum is proven, solve() throws an exception.
+   */
+  void setTimeLimit(double seconds) {
+    _cplex->setParam(IloCplex::TiLim, seconds);
+  }
 
-  void buildSolutionTour(const IloIntArray& int_vals);
+  /**
+   * Enables or disables using the solution of the last solve as a MIP start
+   * for the next one. This is enabled by default.
+   */
+  void setWarmStart(bool warm_start) { _warm_start = warm_start; }
+
+  /** Sets the CPLEX MIP emphasis, e.g. IloCplex::MIPEmphasisBestBound. */
+  void setEmphasis(int emphasis) {
+    _cplex->setParam(IloCplex::MIPEmphasis, emphasis);
+  }
+
+  /** Sets the CPLEX symmetry breaking level, -1 lets CPLEX decide. */
+  void setSymmetry(int symmetry) {
+    _cplex->setParam(IloCplex::Symmetry, symmetry);
+  }
+
+  /**
+   * Shares the tours of this solver with other solvers of the same problem.
+   * Every new incumbent is offered under the given index and search nodes
+   * that cannot beat the best shared tour are pruned.
+   */
+  void setSharedIncumbent(SharedIncumbent* incumbent, int racer) {
+    _shared_incumbent = incumbent;
+    _racer = racer;
+  }
+
+  /**
+   * Returns whether the last solve found no better tour than the shared
+   * incumbent, which is optimal then.
+   */
+  bool isCutOff() const { return _cut_off; }
+
+  /**
+   * Stops the running solve and all following ones, which throw an exception
+   * then. May be called from any thread.
+   */
+  void abort() {
+    _aborted = true;
+    _aborter.abort();
+  }
+
+  /** Enables or disables the CPLEX log output. */
+  void setVerbose(bool verbose) {
+    _cplex->setOut(verbose ? _env.out() : _env.getNullStream());
+  }
+
+ protected:
+  /**
+   * Solves the model, using the given callbacks if there are any. A branch
+   * callback replaces the one pruning by the shared incumbent, so it has to
+   * check canPrune() itself.
+   */
+  void solve(const std::vector<IloCplex::Callback>& callbacks);
+
+  /** Returns whether nodes with this bound cannot beat the shared tour. */
+  bool canPrune(double bound) const;
+
+  /**
+   * Returns the closed tour using the arcs as often as given by the values.
+   * Throws an exception if they do not form a single tour.
+   */
+  std::list<leda::edge> buildEulerTour(const IloIntArray& int_vals) const;
 
   IloEnv& getCplexEnv() { return _env; }
+  IloCplex* getCplex() { return _cplex; }
   IloModel* getCplexModel() { return _model; }
   const IloNum& getEpInt() const { return _epInt; }
 
@@ -115,6 +265,8 @@ class CplexSolver {
   IloNumVarArray _edge_vars;
   leda::edge_array<int> _edge_to_var_id;
 
+  SolverStatistics _statistics;
+
  private:
   const leda::graph& _g;  ///< Reference to the problem graph
 
@@ -124,11 +276,27 @@ class CplexSolver {
   IloModel* _model;
   IloNum _epInt;
 
+  /// the solution of the last solve is used as a MIP start for the next
+  bool _warm_start;
+  bool _has_incumbent;
+  IloNumArray _incumbent;
+
+  /// the tours of all solvers racing on the problem
+  SharedIncumbent* _shared_incumbent;
+  int _racer;
+  bool _cut_off;
+
+  IloCplex::Aborter _aborter;
+  std::atomic<bool> _aborted;
+
   /// the solution is stored in the next variables
   bool _solution_found;
   double _solution_value;
   double _solving_time;
   std::list<leda::edge> _solution_tour;
+
+  friend class SharedIncumbentCallbackI;
+  friend class SharedCutoffCallbackI;
 };
 
 #endif  // UBAHN_SOLVER_CPLEX_SOLVER_H_
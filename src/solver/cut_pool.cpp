@@ -0,0 +1,178 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/cut_pool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::endl;
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char HEADER[] = "ubahn-cuts\t1";
+
+void throwInvalid(const string& file, const string& reason) {
+  std::ostringstream errBuf;
+  errBuf << "Invalid cut pool " << file << ": " << reason;
+  throw std::runtime_error(errBuf.str());
+}
+}  // namespace
+
+bool CutPool::add(Cut cut) {
+  // the same node set must always give the same key
+  std::sort(cut.begin(), cut.end());
+  cut.erase(std::unique(cut.begin(), cut.end(),
+                        [](const NodeKey& a, const NodeKey& b) {
+                          return !(a < b) && !(b < a);
+                        }),
+            cut.end());
+
+  return !cut.empty() && _cuts.insert(cut).second;
+}
+
+void CutPool::addFromGraph(const GraphBuilder& builder,
+                           const vector<vector<node>>& cuts) {
+  for (const vector<node>& nodes : cuts) {
+    Cut cut;
+    for (node n : nodes) {
+      cut.push_back(builder.getNodeKey(n));
+    }
+    add(cut);
+  }
+}
+
+vector<vector<node>> CutPool::toGraph(const GraphBuilder& builder) const {
+  map<NodeKey, node> nodes_by_key;
+  node n;
+  forall_nodes(n, builder.getGraph()) {
+    nodes_by_key[builder.getNodeKey(n)] = n;
+  }
+
+  vector<vector<node>> cuts;
+  for (const Cut& cut : _cuts) {
+    vector<node> nodes;
+    for (const NodeKey& key : cut) {
+      auto pos = nodes_by_key.find(key);
+      if (pos != nodes_by_key.end()) {
+        nodes.push_back(pos->second);
+      }
+    }
+
+    if (!nodes.empty()) {
+      cuts.push_back(nodes);
+    }
+  }
+
+  return cuts;
+}
+
+/**
+ * The file contains a table of all keys, one per line with tab separated
+ * station, line and direction, followed by one line per cut listing the
+ * indices of its keys.
+ */
+void CutPool::save(const string& file) const {
+  map<NodeKey, int> index;
+  vector<const NodeKey*> keys;
+  for (const Cut& cut : _cuts) {
+    for (const NodeKey& key : cut) {
+      if (index.insert({key, keys.size()}).second) {
+        keys.push_back(&key);
+      }
+    }
+  }
+
+  std::ofstream out(file);
+  if (!out) {
+    throw std::runtime_error("Cannot create file " + file);
+  }
+
+  out << HEADER << endl << "keys\t" << keys.size() << endl;
+  for (const NodeKey* key : keys) {
+    out << key->station << "\t" << key->line << "\t" << key->reverse << endl;
+  }
+
+  out << "cuts\t" << _cuts.size() << endl;
+  for (const Cut& cut : _cuts) {
+    out << cut.size();
+    for (const NodeKey& key : cut) {
+      out << " " << index[key];
+    }
+    out << endl;
+  }
+
+  if (!out) {
+    throw std::runtime_error("Cannot write file " + file);
+  }
+}
+
+void CutPool::load(const string& file) {
+  std::ifstream in(file);
+  if (!in) {
+    throw std::runtime_error("Cannot open file " + file);
+  }
+
+  string line;
+  if (!std::getline(in, line) || line != HEADER) {
+    throwInvalid(file, "Unknown header");
+  }
+
+  string keyword;
+  int n_keys;
+  if (!(in >> keyword >> n_keys) || keyword != "keys" || n_keys < 0) {
+    throwInvalid(file, "Expected keys");
+  }
+  std::getline(in, line);
+
+  vector<NodeKey> keys;
+  for (int i = 0; i < n_keys; i++) {
+    NodeKey key;
+    if (!std::getline(in, key.station, '\t') ||
+        !std::getline(in, key.line, '\t') || !std::getline(in, line)) {
+      throwInvalid(file, "Invalid key");
+    }
+    key.reverse = line == "1";
+    keys.push_back(key);
+  }
+
+  int n_cuts;
+  if (!(in >> keyword >> n_cuts) || keyword != "cuts" || n_cuts < 0) {
+    throwInvalid(file, "Expected cuts");
+  }
+  for (int i = 0; i < n_cuts; i++) {
+    int size;
+    if (!(in >> size) || size < 0) {
+      throwInvalid(file, "Invalid cut");
+    }
+
+    Cut cut;
+    for (int j = 0; j < size; j++) {
+      int key;
+      if (!(in >> key) || key < 0 || key >= n_keys) {
+        throwInvalid(file, "Invalid cut");
+      }
+      cut.push_back(keys[key]);
+    }
+    add(cut);
+  }
+}
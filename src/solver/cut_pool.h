@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_CUT_POOL_H_
+#define UBAHN_SOLVER_CUT_POOL_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/graph.h"
+#include "graph_builder.h"
+#include "transport_defs.h"
+
+/**
+ * Subtour cuts of earlier solves, stored as sets of station/line/direction
+ * keys instead of graph nodes. This way the cuts survive rebuilding the
+ * graph and can be saved to a file.
+ */
+class CutPool {
+ public:
+  typedef std::vector<NodeKey> Cut;
+
+  CutPool() {}
+
+  // disallow copy and assign
+  CutPool(const CutPool&) = delete;
+  void operator=(CutPool) = delete;
+
+  /** Adds a cut, returns false if the pool already contained it. */
+  bool add(Cut cut);
+
+  /** Adds the cuts given as node sets of the graph of the builder. */
+  void addFromGraph(const GraphBuilder& builder,
+                    const std::vector<std::vector<leda::node>>& cuts);
+
+  /**
+   * Returns the cuts as node sets of the graph of the builder. Keys without
+   * a node in that graph are skipped, empty cuts are omitted. Whether the
+   * resulting cuts are still valid must be checked by the solver.
+   */
+  std::vector<std::vector<leda::node>> toGraph(
+      const GraphBuilder& builder) const;
+
+  const std::set<Cut>& getCuts() const { return _cuts; }
+  size_t size() const { return _cuts.size(); }
+
+  /** Writes the pool to a file, throws an exception on failure. */
+  void save(const std::string& file) const;
+  /** Adds all cuts of a file, throws an exception if it is invalid. */
+  void load(const std::string& file);
+
+ private:
+  std::set<Cut> _cuts;
+};
+
+#endif  // UBAHN_SOLVER_CUT_POOL_H_
@@ -0,0 +1,92 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/cut_registry.h"
+
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+CutRegistry::Signature CutRegistry::getSignature(const vector<node>& nodes) {
+  Signature signature;
+  signature.reserve(nodes.size());
+  for (node n : nodes) {
+    signature.push_back(n->id());
+  }
+  std::sort(signature.begin(), signature.end());
+
+  return signature;
+}
+
+size_t CutRegistry::SignatureHash::operator()(
+    const Signature& signature) const {
+  // FNV-1a over the ids
+  uint64_t hash = 14695981039346656037ULL;
+  for (int id : signature) {
+    hash ^= static_cast<uint32_t>(id);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool CutRegistry::insert(const Signature& signature, long tick) {
+  auto pos = _cuts.find(signature);
+  if (pos != _cuts.end()) {
+    pos->second = tick;
+    return false;
+  }
+
+  _cuts[signature] = tick;
+  return true;
+}
+
+void CutRegistry::markTight(const leda::list<edge>& selected, long tick) {
+  for (auto& cut : _cuts) {
+    const Signature& ids = cut.first;
+
+    int out = 0;
+    int in = 0;
+    edge e;
+    forall(e, selected) {
+      const int s_id = source(e)->id();
+      const int t_id = target(e)->id();
+      const bool s = std::binary_search(ids.begin(), ids.end(), s_id);
+      const bool t = std::binary_search(ids.begin(), ids.end(), t_id);
+      if (s && !t) {
+        out++;
+      } else if (!s && t) {
+        in++;
+      }
+    }
+
+    if (out == 1 && in == 1) {
+      cut.second = tick;
+    }
+  }
+}
+
+vector<CutRegistry::Signature> CutRegistry::purge(long tick, long max_age) {
+  vector<Signature> purged;
+  for (auto it = _cuts.begin(); it != _cuts.end();) {
+    if (tick - it->second > max_age) {
+      purged.push_back(it->first);
+      it = _cuts.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  return purged;
+}
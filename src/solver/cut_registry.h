@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_CUT_REGISTRY_H_
+#define UBAHN_SOLVER_CUT_REGISTRY_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "base/graph.h"
+
+/**
+ * The subtour cuts added during one solve, keyed by the sorted ids of their
+ * nodes. It recognizes cuts that are separated again and tracks when each cut
+ * was last active, i.e. separated or tight for a candidate solution, so that
+ * cuts that have not been active for a long time can be dropped.
+ */
+class CutRegistry {
+ public:
+  typedef std::vector<int> Signature;
+
+  CutRegistry() {}
+
+  // disallow copy and assign
+  CutRegistry(const CutRegistry&) = delete;
+  void operator=(CutRegistry) = delete;
+
+  /** Returns the canonical signature of the node set. */
+  static Signature getSignature(const std::vector<leda::node>& nodes);
+
+  /**
+   * Registers the cut at the given tick. Returns false and marks it active
+   * instead, if it was already registered.
+   */
+  bool insert(const Signature& signature, long tick);
+
+  bool contains(const Signature& signature) const {
+    return _cuts.count(signature) > 0;
+  }
+
+  /**
+   * Marks all cuts as active that the solution crosses exactly once in each
+   * direction, these are the cuts that are tight for it.
+   */
+  void markTight(const leda::list<leda::edge>& selected, long tick);
+
+  /**
+   * Removes all cuts that were not active for more than max_age ticks and
+   * returns their signatures.
+   */
+  std::vector<Signature> purge(long tick, long max_age);
+
+  size_t size() const { return _cuts.size(); }
+  void clear() { _cuts.clear(); }
+
+ private:
+  struct SignatureHash {
+    size_t operator()(const Signature& signature) const;
+  };
+
+  /// the tick at which each cut was last active
+  std::unordered_map<Signature, long, SignatureHash> _cuts;
+};
+
+#endif  // UBAHN_SOLVER_CUT_REGISTRY_H_
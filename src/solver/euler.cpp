@@ -15,10 +15,15 @@
 #include "solver/euler.h"
 
 #include <list>
+#include <sstream>
 #include <stdexcept>
+#include <vector>
 
 #include "base/graph.h"
 
+using leda::edge_map;
+using leda::node_array;
+
 std::list<edge> Euler::getEulerTour(node start) {
   std::list<edge> cycle;
 
@@ -79,3 +84,56 @@ void Euler::eulerRec(node current, node start, std::list<edge>& cycle) {
     throw std::runtime_error("The Graph is not Eulerian");
   }
 }
+
+std::list<edge> buildEulerTour(const leda::graph& graph,
+                               const std::vector<edge>& arcs) {
+  if (arcs.empty()) {
+    throw std::runtime_error("Invalid solution: Solution contains no arcs");
+  }
+
+  leda::graph eulerGraph;
+
+  node_array<node> eulerNodes(graph, 0);
+
+  // in the new graph make a copy for every node in the original graph
+  node n;
+  forall_nodes(n, graph) {
+    const node eulerNode = eulerGraph.new_node();
+
+    eulerNodes[n] = eulerNode;
+  }
+
+  edge_map<edge> edgeRef(eulerGraph);
+
+  // now add only the given arcs to the euler graph, repeated arcs become
+  // parallel edges
+  for (edge e : arcs) {
+    const edge eulerEdge =
+        eulerGraph.new_edge(eulerNodes[source(e)], eulerNodes[target(e)]);
+    edgeRef[eulerEdge] = e;
+  }
+  const node startNode = eulerNodes[source(arcs.front())];
+
+  Euler euler(eulerGraph);
+
+  std::list<edge> eulerTour;
+  try {
+    eulerTour = euler.getEulerTour(startNode);
+  } catch (const std::runtime_error& e) {
+    std::ostringstream errBuf;
+    errBuf << "Invalid solution: " << e.what();
+    throw std::runtime_error(errBuf.str());
+  }
+
+  if (arcs.size() != eulerTour.size()) {
+    throw std::runtime_error("Invalid solution: Solution contains sub tours");
+  }
+
+  // finally, transform the Euler Tour back to the original graph
+  std::list<edge> tour;
+  for (edge e : eulerTour) {
+    edge original_edge = edgeRef[e];
+    tour.push_back(original_edge);
+  }
+  return tour;
+}
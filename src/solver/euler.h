@@ -18,6 +18,7 @@
 #define UBAHN_SOLVER_EULER_H_
 
 #include <list>
+#include <vector>
 
 #include "graph.h"
 
@@ -40,4 +41,12 @@ class Euler {
   leda::edge_array<bool> _arc_visited;
 };
 
+/**
+ * Returns the arcs in the order of an Euler tour, starting at the source of
+ * the first arc. An arc listed several times is used that many times. Throws
+ * an exception if the arcs do not form a single tour.
+ */
+std::list<leda::edge> buildEulerTour(const leda::graph& graph,
+                                     const std::vector<leda::edge>& arcs);
+
 #endif  // UBAHN_SOLVER_EULER_H_
@@ -0,0 +1,377 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/lagrangian_bound.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "base/timer.h"
+
+using leda::edge_array;
+using leda::node_array;
+using std::vector;
+
+namespace {
+
+typedef std::chrono::duration<double, std::milli> t_ms;
+
+const double INFINITE = std::numeric_limits<double>::infinity();
+
+/// the first steps move the multipliers twice the estimated distance
+const double INITIAL_STEP_SCALE = 2.0;
+/// the step is halved after this many steps without a better bound
+const int STALL_ITERATIONS = 5;
+/// smaller steps do not improve the bound noticeably anymore
+const double MIN_STEP_SCALE = 1e-3;
+/// the circulation of every this many steps is repaired into a tour
+const int REPAIR_INTERVAL = 10;
+/// arcs with a smaller reduced cost belong to a shortest path
+const double ADMISSIBLE_TOLERANCE = 1e-9;
+/// relative excess over the most expensive tour that proves infeasibility
+const double INFEASIBLE_TOLERANCE = 1e-6;
+
+/**
+ * Calls f(arc, head, cost, backward) for every arc of the residual graph.
+ * Fixed arcs keep their flow, so they are not part of it.
+ */
+void forResidualArcs(
+    node v, const edge_array<double>& costs, const edge_array<bool>& flow,
+    const edge_array<ArcFixing>& fixings,
+    const std::function<void(edge, node, double, bool)>& f) {
+  edge e;
+  forall_out_edges(e, v) {
+    if (fixings[e] == FREE_ARC && !flow[e]) f(e, target(e), costs[e], false);
+  }
+  forall_in_edges(e, v) {
+    if (fixings[e] == FREE_ARC && flow[e]) f(e, source(e), -costs[e], true);
+  }
+}
+}  // namespace
+
+BoundResult LagrangianBound::compute() {
+  Timer timer;
+  BoundResult result;
+  result.lower_bound = -INFINITE;
+  result.upper_bound = INFINITE;
+
+  edge_array<double> values(_g, 0.0);
+  const edge_array<bool> enabled(_g, true);
+  auto repair = [&]() {
+    const vector<edge> tour = _repair.repair(values, enabled);
+    if (tour.empty()) return;
+
+    double cost = 0.0;
+    for (edge e : tour) cost += _costs[e];
+    if (cost < result.upper_bound) {
+      result.upper_bound = cost;
+      result.tour = tour;
+    }
+  };
+
+  // a tour built from scratch gives the first target of the steps
+  if (_cutoff == INFINITE) repair();
+
+  vector<double> multipliers = _multipliers;
+  vector<RelaxedCut> cuts = _cuts;
+  std::set<CutRegistry::Signature> signatures;
+  for (const RelaxedCut& cut : cuts) {
+    signatures.insert(CutRegistry::getSignature(cut.cut->nodes));
+  }
+
+  // every arc is used at most once, so no tour costs more than this, and a
+  // larger bound proves that there is none
+  double max_tour_cost = 0.0;
+  edge e;
+  forall_edges(e, _g) {
+    if (_fixings[e] != EXCLUDED_ARC) max_tour_cost += std::max(0.0, _costs[e]);
+  }
+  const double infeasible_bound =
+      max_tour_cost + INFEASIBLE_TOLERANCE * std::max(1.0, max_tour_cost);
+
+  edge_array<double> reduced(_g);
+  edge_array<bool> flow(_g, false);
+  double step_scale = INITIAL_STEP_SCALE;
+  int stalled = 0;
+  for (int iteration = 0; iteration < _max_iterations; iteration++) {
+    if (_time_limit_ms > 0 && timer.Elapsed<t_ms>().count() > _time_limit_ms) {
+      break;
+    }
+    result.iterations++;
+
+    // leaving a required station or the node set of a cut earns its
+    // multiplier
+    double value = 0.0;
+    for (int station = 0; station < _n_stations; station++) {
+      if (_required[station]) value += multipliers[station];
+    }
+    forall_edges(e, _g) {
+      const int station = _station_ids[source(e)];
+      reduced[e] = _costs[e];
+      if (_required[station] && station != _station_ids[target(e)]) {
+        reduced[e] -= multipliers[station];
+      }
+    }
+    for (const RelaxedCut& cut : cuts) {
+      value += cut.multiplier;
+      for (edge a : cut.cut->out_arcs) reduced[a] -= cut.multiplier;
+    }
+    value += solveCirculation(reduced, &flow);
+
+    // without a circulation, no tour satisfies the fixings, and without a
+    // tour the multipliers grow without bound
+    if (value > infeasible_bound) {
+      result.lower_bound = INFINITE;
+      break;
+    }
+
+    if (value > result.lower_bound) {
+      result.lower_bound = value;
+      result.multipliers = multipliers;
+      result.cuts = cuts;
+      result.circulation.clear();
+      forall_edges(e, _g) {
+        if (flow[e]) result.circulation.push_back(e);
+      }
+      stalled = 0;
+    } else if (++stalled >= STALL_ITERATIONS) {
+      step_scale /= 2.0;
+      stalled = 0;
+    }
+
+    // the subgradient is the violation of the relaxed rows
+    vector<double> subgradient(_n_stations, 0.0);
+    bool covered = true;
+    for (int station = 0; station < _n_stations; station++) {
+      if (_required[station]) subgradient[station] = 1.0;
+    }
+    forall_edges(e, _g) {
+      const int station = _station_ids[source(e)];
+      if (flow[e] && _required[station] &&
+          station != _station_ids[target(e)]) {
+        subgradient[station] -= 1.0;
+      }
+    }
+    for (int station = 0; station < _n_stations; station++) {
+      if (subgradient[station] > 0.0) covered = false;
+    }
+
+    // a circulation visiting every station without subtours is a tour,
+    // the repair only drops the cycles that are not needed
+    vector<SubtourCut> subtours;
+    if (covered || _separate) subtours = findSubtours(flow);
+    if ((covered && subtours.empty()) || iteration % REPAIR_INTERVAL == 0) {
+      forall_edges(e, _g) { values[e] = flow[e] ? 1.0 : 0.0; }
+      repair();
+    }
+
+    if (_separate) {
+      for (SubtourCut& subtour : subtours) {
+        if (!signatures.insert(CutRegistry::getSignature(subtour.nodes))
+                 .second) {
+          continue;
+        }
+        RelaxedCut cut;
+        cut.cut = std::make_shared<const SubtourCut>(std::move(subtour));
+        cut.multiplier = 0.0;
+        cuts.push_back(cut);
+      }
+    }
+
+    if (result.lower_bound >= _cutoff) break;
+    if (result.upper_bound < INFINITE &&
+        result.upper_bound - result.lower_bound <=
+            _gap * std::max(1.0, std::fabs(result.upper_bound))) {
+      break;
+    }
+
+    // multipliers at zero cannot decrease any further
+    double norm = 0.0;
+    for (int station = 0; station < _n_stations; station++) {
+      if (multipliers[station] <= 0.0 && subgradient[station] < 0.0) {
+        subgradient[station] = 0.0;
+      }
+      norm += subgradient[station] * subgradient[station];
+    }
+    vector<double> cut_subgradient(cuts.size(), 1.0);
+    for (size_t i = 0; i < cuts.size(); i++) {
+      for (edge a : cuts[i].cut->out_arcs) {
+        if (flow[a]) cut_subgradient[i] -= 1.0;
+      }
+      if (cuts[i].multiplier <= 0.0 && cut_subgradient[i] < 0.0) {
+        cut_subgradient[i] = 0.0;
+      }
+      norm += cut_subgradient[i] * cut_subgradient[i];
+    }
+
+    // the circulation is optimal for the relaxation with the relaxed rows
+    if (norm == 0.0 || step_scale < MIN_STEP_SCALE) break;
+
+    const double best = std::min(_cutoff, result.upper_bound);
+    const double target =
+        best < INFINITE ? best : value + std::max(1.0, std::fabs(value));
+    const double step = step_scale * (target - value) / norm;
+    for (int station = 0; station < _n_stations; station++) {
+      multipliers[station] =
+          std::max(0.0, multipliers[station] + step * subgradient[station]);
+    }
+    for (size_t i = 0; i < cuts.size(); i++) {
+      cuts[i].multiplier =
+          std::max(0.0, cuts[i].multiplier + step * cut_subgradient[i]);
+    }
+  }
+
+  result.ms = timer.Elapsed<t_ms>().count();
+  return result;
+}
+
+/** Returns a cut for every subtour of the circulation. */
+vector<SubtourCut> LagrangianBound::findSubtours(
+    const edge_array<bool>& flow) const {
+  leda::list<edge> selected;
+  edge e;
+  forall_edges(e, _g) {
+    if (flow[e]) selected.append(e);
+  }
+  return _separator.separate(selected);
+}
+
+/**
+ * Returns the cost of a minimum cost circulation with unit capacities and
+ * stores its arcs in flow, or infinity if the fixed arcs do not allow one.
+ * Forced and free arcs of negative cost are saturated first, the imbalance
+ * this creates is removed by successive shortest paths in the residual graph.
+ * Node potentials keep the reduced costs non-negative, so that Dijkstra can be
+ * used, and each run is followed by augmenting along as many paths of zero
+ * reduced cost as possible.
+ */
+double LagrangianBound::solveCirculation(const edge_array<double>& costs,
+                                         edge_array<bool>* flow) const {
+  // the number of entering minus the number of leaving arcs
+  node_array<int> excess(_g, 0);
+  int supply = 0;
+  edge e;
+  forall_edges(e, _g) {
+    (*flow)[e] = _fixings[e] == FORCED_ARC ||
+                 (_fixings[e] == FREE_ARC && costs[e] < 0.0);
+    if ((*flow)[e]) {
+      excess[target(e)]++;
+      excess[source(e)]--;
+    }
+  }
+  node n;
+  forall_nodes(n, _g) {
+    if (excess[n] > 0) supply += excess[n];
+  }
+
+  node_array<double> potential(_g, 0.0);
+  while (supply > 0) {
+    // the reduced distances from all nodes with supply to the closest demand
+    node_array<double> dist(_g, INFINITE);
+    typedef std::pair<double, node> Entry;
+    std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> queue;
+    forall_nodes(n, _g) {
+      if (excess[n] > 0) {
+        dist[n] = 0.0;
+        queue.push(Entry(0.0, n));
+      }
+    }
+
+    double reached = INFINITE;
+    while (!queue.empty()) {
+      const Entry top = queue.top();
+      queue.pop();
+
+      const node v = top.second;
+      if (top.first > dist[v]) continue;
+      if (excess[v] < 0) {
+        reached = top.first;
+        break;
+      }
+
+      forResidualArcs(v, costs, *flow, _fixings, [&](edge, node w, double cost,
+                                                     bool) {
+        const double reduced = cost + potential[v] - potential[w];
+        const double d = dist[v] + std::max(0.0, reduced);
+        if (d < dist[w]) {
+          dist[w] = d;
+          queue.push(Entry(d, w));
+        }
+      });
+    }
+    if (reached == INFINITE) return INFINITE;
+
+    // the shortest paths to the closest demand get a reduced cost of zero
+    forall_nodes(n, _g) { potential[n] += std::min(dist[n], reached); }
+
+    // augment along paths of zero reduced cost, visiting every node once
+    node_array<bool> visited(_g, false);
+    node_array<edge> pred(_g, nullptr);
+    node_array<bool> backward(_g, false);
+    node s;
+    forall_nodes(s, _g) {
+      if (excess[s] <= 0 || visited[s]) continue;
+
+      node t = nullptr;
+      vector<node> stack = {s};
+      while (!stack.empty()) {
+        const node v = stack.back();
+        stack.pop_back();
+        if (visited[v]) continue;
+        visited[v] = true;
+
+        if (excess[v] < 0) {
+          t = v;
+          break;
+        }
+
+        forResidualArcs(v, costs, *flow, _fixings,
+                        [&](edge a, node w, double cost, bool reverse) {
+                          const double reduced =
+                              cost + potential[v] - potential[w];
+                          if (!visited[w] &&
+                              reduced <= ADMISSIBLE_TOLERANCE) {
+                            pred[w] = a;
+                            backward[w] = reverse;
+                            stack.push_back(w);
+                          }
+                        });
+      }
+      if (!t) continue;
+
+      for (node w = t; w != s;) {
+        const edge a = pred[w];
+        (*flow)[a] = !backward[w];
+        w = backward[w] ? target(a) : source(a);
+      }
+      excess[s]--;
+      excess[t]++;
+      supply--;
+    }
+  }
+
+  double cost = 0.0;
+  forall_edges(e, _g) {
+    if ((*flow)[e]) cost += costs[e];
+  }
+  return cost;
+}
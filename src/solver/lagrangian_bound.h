@@ -0,0 +1,156 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_LAGRANGIAN_BOUND_H_
+#define UBAHN_SOLVER_LAGRANGIAN_BOUND_H_
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "base/graph.h"
+#include "solver/cut_registry.h"
+#include "solver/subtour_separator.h"
+#include "solver/tour_repair.h"
+
+/** How the branching fixed an arc. */
+enum ArcFixing { FREE_ARC, EXCLUDED_ARC, FORCED_ARC };
+
+/** A subtour cut moved into the objective, together with its multiplier. */
+struct RelaxedCut {
+  std::shared_ptr<const SubtourCut> cut;
+  double multiplier;
+};
+
+/** The bounds on the cost of the optimal tour. */
+struct BoundResult {
+  BoundResult() : lower_bound(0.0), upper_bound(0.0), iterations(0), ms(0.0) {}
+
+  double lower_bound;            ///< infinite, if the fixings are infeasible
+  double upper_bound;            ///< infinite, if no tour was found
+  std::vector<leda::edge> tour;  ///< the arcs of the tour giving upper_bound
+  int iterations;                ///< number of subgradient steps
+  double ms;                     ///< wall clock time of the computation
+
+  /// the circulation and the multipliers giving lower_bound
+  std::vector<leda::edge> circulation;
+  std::vector<double> multipliers;
+  std::vector<RelaxedCut> cuts;
+};
+
+/**
+ * Computes a lower bound for the station problem without CPLEX. The rows
+ * requiring each station to be left at least once are moved into the
+ * objective with Lagrangian multipliers, what remains is a minimum cost
+ * circulation with unit capacities. Its solution is integral, so the bound
+ * equals the LP relaxation without subtour cuts in the limit. The multipliers
+ * are improved by subgradient steps towards the best tour found by repairing
+ * the circulations. With separation, the subtours of the circulations are
+ * relaxed the same way. Arcs can be fixed for a branch and bound.
+ */
+class LagrangianBound {
+ public:
+  /**
+   * @param graph problem graph
+   * @param station_ids maps each node to the id of its station
+   * @param n_stations number of stations
+   * @param costs the cost of every arc
+   */
+  LagrangianBound(const leda::graph& graph,
+                  const leda::node_array<int>& station_ids, int n_stations,
+                  const leda::edge_array<double>& costs)
+      : _g(graph),
+        _station_ids(station_ids),
+        _n_stations(n_stations),
+        _costs(costs),
+        _required(n_stations, true),
+        _repair(graph, station_ids, n_stations, costs),
+        _separator(graph, station_ids, n_stations),
+        _fixings(graph, FREE_ARC),
+        _multipliers(n_stations, 0.0),
+        _max_iterations(200),
+        _time_limit_ms(0.0),
+        _gap(1e-3),
+        _cutoff(std::numeric_limits<double>::infinity()),
+        _separate(false) {}
+
+  // disallow copy and assign
+  LagrangianBound(const LagrangianBound&) = delete;
+  void operator=(LagrangianBound) = delete;
+
+  /** Sets whether the tour must visit the station. */
+  void setRequired(int station, bool required) {
+    _required[station] = required;
+    _repair.setRequired(station, required);
+    _separator.setRequired(station, required);
+  }
+
+  /** Limits the number of subgradient steps, the default is 200. */
+  void setIterationLimit(int iterations) { _max_iterations = iterations; }
+
+  /** Limits the time in milliseconds, 0 means no limit, the default. */
+  void setTimeLimit(double ms) { _time_limit_ms = ms; }
+
+  /** Stops once the relative gap between the bounds is below this. */
+  void setGap(double gap) { _gap = gap; }
+
+  /** Stops once the lower bound reaches the cutoff, e.g. the best tour. */
+  void setCutoff(double cutoff) { _cutoff = cutoff; }
+
+  /** Sets whether the subtours of the circulations are relaxed as well. */
+  void setSeparation(bool separate) { _separate = separate; }
+
+  /** Excludes the arc from the tour, forces it into it, or frees it again. */
+  void fixArc(leda::edge e, ArcFixing fixing) { _fixings[e] = fixing; }
+  ArcFixing getFixing(leda::edge e) const { return _fixings[e]; }
+  void clearFixings() { _fixings.init(_g, FREE_ARC); }
+
+  /** Sets the multipliers of the stations and cuts to start from. */
+  void setMultipliers(const std::vector<double>& multipliers) {
+    _multipliers = multipliers;
+    _multipliers.resize(_n_stations, 0.0);
+  }
+  void setCuts(const std::vector<RelaxedCut>& cuts) { _cuts = cuts; }
+
+  BoundResult compute();
+
+ private:
+  double solveCirculation(const leda::edge_array<double>& costs,
+                          leda::edge_array<bool>* flow) const;
+  std::vector<SubtourCut> findSubtours(
+      const leda::edge_array<bool>& flow) const;
+
+  const leda::graph& _g;
+  const leda::node_array<int>& _station_ids;
+  const int _n_stations;
+  const leda::edge_array<double>& _costs;
+
+  std::vector<bool> _required;
+  TourRepair _repair;
+  SubtourSeparator _separator;
+
+  leda::edge_array<ArcFixing> _fixings;
+  std::vector<double> _multipliers;
+  std::vector<RelaxedCut> _cuts;
+
+  int _max_iterations;
+  double _time_limit_ms;
+  double _gap;
+  double _cutoff;
+  bool _separate;
+};
+
+#endif  // UBAHN_SOLVER_LAGRANGIAN_BOUND_H_
@@ -0,0 +1,433 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/lns_runner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "base/timer.h"
+#include "graph_builder.h"
+#include "solver/euler.h"
+#include "solver/lagrangian_bound.h"
+#include "solver/shared_incumbent.h"
+#include "solver/station_solver.h"
+#include "transport_defs.h"
+
+using leda::edge_array;
+using leda::node_array;
+using std::list;
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+/// subgradient steps of the relaxation giving the initial tour
+const int INITIAL_ITERATIONS = 200;
+/// tries to find a start for a region that is not taken by another one
+const int REGION_ATTEMPTS = 20;
+/// tours have to be at least this much better to replace the current one
+const double IMPROVEMENT_TOLERANCE = 1e-6;
+/// the stations of the sub-MIPs standing in for the fixed parts of the tour
+const char OUTSIDE_NAME[] = "<outside>";
+
+double getCost(const vector<edge>& arcs, const edge_array<double>& costs) {
+  double cost = 0.0;
+  for (edge e : arcs) cost += costs[e];
+  return cost;
+}
+}  // namespace
+
+LnsRunner::LnsRunner(const leda::graph& graph, const edge_array<double>& dist,
+                     const map<string, set<node>>& stations,
+                     const edge_array<bool>& connection_arcs,
+                     const edge_array<string>& lines)
+    : _g(graph),
+      _dist(dist),
+      _connection_arcs(connection_arcs),
+      _n_stations(0),
+      _time_limit(60.0),
+      _region_time_limit(10.0),
+      _region_size(30),
+      _threads(0),
+      _patience(20) {
+  _station_ids.init(_g, -1);
+  for (const auto& station : stations) {
+    for (node n : station.second) _station_ids[n] = _n_stations;
+    _station_names.push_back(station.first);
+    _station_nodes.emplace_back(station.second.begin(), station.second.end());
+    _n_stations++;
+  }
+
+  // stations are adjacent if an arc leads from one to the other
+  map<string, int> line_ids;
+  vector<set<std::pair<int, int>>> adjacent(_n_stations);
+  vector<set<int>> station_lines(_n_stations);
+  edge e;
+  forall_edges(e, _g) {
+    const int s = _station_ids[source(e)];
+    const int t = _station_ids[target(e)];
+    if (s == t) continue;
+
+    int line = -1;
+    const string& name = lines[e];
+    if (name != CHANGE_NAME) {
+      auto pos = line_ids.find(name);
+      if (pos == line_ids.end()) {
+        pos = line_ids.insert(std::make_pair(name, line_ids.size())).first;
+      }
+      line = pos->second;
+      station_lines[s].insert(line);
+      station_lines[t].insert(line);
+    }
+    adjacent[s].insert(std::make_pair(t, line));
+    adjacent[t].insert(std::make_pair(s, line));
+  }
+
+  _neighbors.resize(_n_stations);
+  _line_stations.resize(line_ids.size());
+  for (int station = 0; station < _n_stations; station++) {
+    for (const auto& neighbor : adjacent[station]) {
+      _neighbors[station].push_back(Neighbor{neighbor.first, neighbor.second});
+    }
+    for (int line : station_lines[station]) {
+      _line_stations[line].push_back(station);
+    }
+    // the transfer stations are the hubs of the network
+    if (station_lines[station].size() > 1) _hubs.push_back(station);
+  }
+  if (_hubs.empty()) {
+    for (int station = 0; station < _n_stations; station++) {
+      _hubs.push_back(station);
+    }
+  }
+}
+
+LnsRunner::LnsRunner(const GraphBuilder& builder)
+    : LnsRunner(builder.getGraph(), builder.getDist(),
+                builder.getStationNodes(), builder.getConnections(),
+                builder.getArcNames()) {}
+
+LnsResult LnsRunner::run(ProgressHandler handler) {
+  Timer timer;
+  auto elapsed = [&timer]() {
+    return timer.Elapsed<std::chrono::duration<double>>().count();
+  };
+
+  // the relaxation gives the initial tour and the bound to compare with
+  LagrangianBound bound(_g, _station_ids, _n_stations, _dist);
+  bound.setIterationLimit(INITIAL_ITERATIONS);
+  const BoundResult relaxation = bound.compute();
+
+  vector<edge> arcs(_initial_tour.begin(), _initial_tour.end());
+  if (arcs.empty()) arcs = relaxation.tour;
+  if (arcs.empty()) {
+    throw std::runtime_error("No initial tour found");
+  }
+
+  if (!visitsAllStations(arcs)) {
+    throw std::runtime_error("The initial tour misses a station");
+  }
+
+  LnsResult result;
+  result.lower_bound = relaxation.lower_bound;
+  list<edge> tour = buildEulerTour(_g, arcs);
+  double value = getCost(arcs, _dist);
+  result.initial_value = value;
+
+  const int threads = _threads > 0
+                          ? _threads
+                          : std::max(1u, std::thread::hardware_concurrency());
+  int idle_rounds = 0;
+  while (elapsed() < _time_limit &&
+         (_patience == 0 || idle_rounds < _patience)) {
+    const vector<vector<int>> regions = pickRegions(threads);
+    if (regions.empty()) break;
+
+    const double time_limit =
+        std::min(_region_time_limit, _time_limit - elapsed());
+    vector<RegionResult> region_results(regions.size());
+    vector<std::thread> workers;
+    for (size_t i = 0; i < regions.size(); i++) {
+      workers.emplace_back(&LnsRunner::solveRegion, this,
+                           std::cref(regions[i]), std::cref(tour), value,
+                           time_limit, &region_results[i]);
+    }
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+
+    LnsSample sample;
+    sample.round = ++result.rounds;
+    sample.regions = regions.size();
+    sample.improved = 0;
+    sample.unsolved = 0;
+
+    // the best tours first, the others must still fit the changed tour
+    vector<size_t> order;
+    for (size_t i = 0; i < regions.size(); i++) {
+      if (region_results[i].improved) {
+        order.push_back(i);
+      } else if (!region_results[i].solved) {
+        sample.unsolved++;
+      }
+    }
+    std::sort(order.begin(), order.end(),
+              [&region_results](size_t a, size_t b) {
+                return region_results[a].value < region_results[b].value;
+              });
+
+    for (size_t i : order) {
+      const vector<bool> in_region = getRegionMask(regions[i]);
+      vector<edge> candidate;
+      for (edge e : arcs) {
+        if (!isRegionArc(e, in_region)) candidate.push_back(e);
+      }
+      candidate.insert(candidate.end(), region_results[i].arcs.begin(),
+                       region_results[i].arcs.end());
+
+      const double cost = getCost(candidate, _dist);
+      if (cost >= value - IMPROVEMENT_TOLERANCE ||
+          !visitsAllStations(candidate)) {
+        result.rejected++;
+        continue;
+      }
+      // another region may have changed how the fixed parts are connected
+      try {
+        tour = buildEulerTour(_g, candidate);
+      } catch (const std::runtime_error&) {
+        result.rejected++;
+        continue;
+      }
+
+      arcs = std::move(candidate);
+      value = cost;
+      sample.improved++;
+    }
+
+    idle_rounds = sample.improved > 0 ? 0 : idle_rounds + 1;
+    sample.seconds = elapsed();
+    sample.value = value;
+    result.trace.push_back(sample);
+    if (handler) handler(sample);
+  }
+
+  result.value = value;
+  result.tour = tour;
+  result.seconds = elapsed();
+  return result;
+}
+
+/**
+ * Returns up to count disjoint regions. Each one alternately grows from a hub
+ * or along a line, and then around the stations of the line.
+ */
+vector<vector<int>> LnsRunner::pickRegions(int count) {
+  // the engine output is used directly, as the std distributions differ
+  // between standard libraries and the same seed must pick the same regions
+  auto pick = [this](size_t n) { return _random() % n; };
+
+  vector<bool> taken(_n_stations, false);
+  vector<vector<int>> regions;
+  for (int i = 0; i < count; i++) {
+    for (int attempt = 0; attempt < REGION_ATTEMPTS; attempt++) {
+      int line = -1;
+      int start;
+      if (!_line_stations.empty() && pick(2) == 1) {
+        line = pick(_line_stations.size());
+        start = _line_stations[line][pick(_line_stations[line].size())];
+      } else {
+        start = _hubs[pick(_hubs.size())];
+      }
+      if (taken[start]) continue;
+
+      vector<int> region = {start};
+      taken[start] = true;
+      growRegion(line, &taken, &region);
+      if (line >= 0) growRegion(-1, &taken, &region);
+
+      regions.push_back(std::move(region));
+      break;
+    }
+  }
+
+  return regions;
+}
+
+/**
+ * Adds the closest stations to the region by a breadth first search, only
+ * along the line unless it is -1, until it has the size of a region.
+ */
+void LnsRunner::growRegion(int line, vector<bool>* taken,
+                           vector<int>* region) const {
+  for (size_t next = 0;
+       next < region->size() && int(region->size()) < _region_size; next++) {
+    for (const Neighbor& neighbor : _neighbors[(*region)[next]]) {
+      if ((*taken)[neighbor.station]) continue;
+      if (line >= 0 && neighbor.line != line) continue;
+
+      (*taken)[neighbor.station] = true;
+      region->push_back(neighbor.station);
+      if (int(region->size()) == _region_size) return;
+    }
+  }
+}
+
+/**
+ * Solves the station problem on the subgraph induced by the region, with the
+ * rest of the tour fixed. Every part of the tour outside the region leads
+ * from one node of the region to another one, it becomes an arc with its cost
+ * to a station of its own and an arc back. The stations the fixed parts
+ * leave are visited already.
+ */
+void LnsRunner::solveRegion(const vector<int>& region, const list<edge>& tour,
+                            double value, double time_limit,
+                            RegionResult* result) const {
+  const vector<bool> in_region = getRegionMask(region);
+
+  // starting within the region, no fixed part wraps around the end
+  vector<edge> arcs(tour.begin(), tour.end());
+  auto first = std::find_if(arcs.begin(), arcs.end(), [&](edge e) {
+    return in_region[_station_ids[source(e)]];
+  });
+  std::rotate(arcs.begin(), first, arcs.end());
+
+  struct FixedPart {
+    node from;
+    node to;
+    double cost;
+  };
+  vector<FixedPart> fixed_parts;
+  vector<bool> visited(_n_stations, false);
+  bool in_fixed_part = false;
+  for (edge e : arcs) {
+    if (isRegionArc(e, in_region)) {
+      in_fixed_part = false;
+      continue;
+    }
+    if (!in_fixed_part) {
+      fixed_parts.push_back(FixedPart{source(e), target(e), 0.0});
+      in_fixed_part = true;
+    }
+    fixed_parts.back().to = target(e);
+    fixed_parts.back().cost += _dist[e];
+
+    const int station = _station_ids[source(e)];
+    if (station != _station_ids[target(e)]) visited[station] = true;
+  }
+
+  leda::graph sub;
+  node_array<node> sub_nodes(_g, nullptr);
+  map<string, set<node>> stations;
+  for (int station : region) {
+    set<node>& nodes = stations[_station_names[station]];
+    for (node n : _station_nodes[station]) {
+      sub_nodes[n] = sub.new_node();
+      nodes.insert(sub_nodes[n]);
+    }
+  }
+
+  vector<std::pair<edge, edge>> copies;  // the arc and its original
+  edge e;
+  forall_edges(e, _g) {
+    if (!isRegionArc(e, in_region)) continue;
+
+    copies.push_back(std::make_pair(
+        sub.new_edge(sub_nodes[source(e)], sub_nodes[target(e)]), e));
+  }
+  vector<std::pair<edge, double>> fixed_arcs;
+  for (size_t i = 0; i < fixed_parts.size(); i++) {
+    const node outside = sub.new_node();
+    stations[OUTSIDE_NAME + std::to_string(i)].insert(outside);
+
+    const FixedPart& part = fixed_parts[i];
+    fixed_arcs.push_back(std::make_pair(
+        sub.new_edge(sub_nodes[part.from], outside), part.cost));
+    fixed_arcs.push_back(
+        std::make_pair(sub.new_edge(outside, sub_nodes[part.to]), 0.0));
+  }
+
+  edge_array<double> dist(sub, 0.0);
+  edge_array<bool> connections(sub, false);
+  edge_array<edge> originals(sub, nullptr);
+  for (const auto& copy : copies) {
+    dist[copy.first] = _dist[copy.second];
+    connections[copy.first] = _connection_arcs[copy.second];
+    originals[copy.first] = copy.second;
+  }
+  for (const auto& fixed_arc : fixed_arcs) {
+    dist[fixed_arc.first] = fixed_arc.second;
+  }
+
+  // only tours that beat the current one are of interest
+  SharedIncumbent incumbent;
+  incumbent.offer(-1, value, list<edge>());
+  try {
+    StationSolver solver(sub, dist, stations, connections);
+    solver.setVerbose(false);
+    solver.setThreads(1);
+    solver.setTimeLimit(time_limit);
+    solver.setSharedIncumbent(&incumbent, 0);
+    for (int station : region) {
+      if (visited[station]) {
+        solver.setStationRequired(_station_names[station], false);
+      }
+    }
+
+    try {
+      solver.solve();
+      result->solved = true;
+    } catch (const std::runtime_error&) {
+      // the time limit was reached, or the current tour is optimal here
+      result->solved = solver.isCutOff();
+    }
+  } catch (const std::runtime_error&) {
+    // e.g. a region without any unique station and no fixed parts
+    return;
+  }
+
+  if (incumbent.getOwner() != 0) return;
+
+  result->improved = true;
+  result->value = incumbent.getValue();
+  for (edge arc : incumbent.getTour()) {
+    if (originals[arc]) result->arcs.push_back(originals[arc]);
+  }
+}
+
+vector<bool> LnsRunner::getRegionMask(const vector<int>& region) const {
+  vector<bool> in_region(_n_stations, false);
+  for (int station : region) in_region[station] = true;
+  return in_region;
+}
+
+bool LnsRunner::visitsAllStations(const vector<edge>& arcs) const {
+  vector<bool> left(_n_stations, false);
+  for (edge e : arcs) {
+    const int station = _station_ids[source(e)];
+    if (station != _station_ids[target(e)]) left[station] = true;
+  }
+  return std::all_of(left.begin(), left.end(), [](bool l) { return l; });
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_LNS_RUNNER_H_
+#define UBAHN_SOLVER_LNS_RUNNER_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/graph.h"
+
+class GraphBuilder;
+
+/** The state of the search after one round. */
+struct LnsSample {
+  int round;
+  double seconds;  ///< since the start of the search
+  double value;    ///< of the tour after the round
+  int regions;     ///< solved in parallel during the round
+  int improved;    ///< regions whose tour was spliced into the tour
+  int unsolved;    ///< regions that hit the time limit without improvement
+};
+
+struct LnsResult {
+  LnsResult()
+      : initial_value(0.0),
+        value(0.0),
+        lower_bound(0.0),
+        rounds(0),
+        rejected(0),
+        seconds(0.0) {}
+
+  double initial_value;  ///< of the heuristic tour the search started from
+  double value;
+  double lower_bound;  ///< of the Lagrangian relaxation
+  std::list<leda::edge> tour;
+
+  int rounds;
+  /// improvements that did not fit the tour changed by the same round
+  int rejected;
+  double seconds;
+  std::vector<LnsSample> trace;
+};
+
+/**
+ * Improves a heuristic tour of the station problem by large neighborhood
+ * search. Each round frees several disjoint regions, either the stations
+ * around a hub or a stretch of a line, and solves each of them in parallel by
+ * a StationSolver on the induced subgraph. The parts of the tour outside a
+ * region are fixed, each is replaced by an arc through a station of its own
+ * that must be visited, so that the sub-MIP has to keep them connected.
+ * Improved regions are spliced into the tour one after the other, as long as
+ * the result is still a single tour visiting every station.
+ */
+class LnsRunner {
+ public:
+  typedef std::function<void(const LnsSample&)> ProgressHandler;
+
+  /**
+   * @param graph problem graph
+   * @param dist arc costs
+   * @param stations maps each station to its graph nodes
+   * @param connection_arcs whether the arc only represents a connection
+   * @param lines the line of each arc or CHANGE_NAME if it is not a ride
+   */
+  LnsRunner(const leda::graph& graph, const leda::edge_array<double>& dist,
+            const std::map<std::string, std::set<leda::node>>& stations,
+            const leda::edge_array<bool>& connection_arcs,
+            const leda::edge_array<std::string>& lines);
+
+  /** The graph of the builder must be the one of the station problem. */
+  explicit LnsRunner(const GraphBuilder& builder);
+
+  // disallow copy and assign
+  LnsRunner(const LnsRunner&) = delete;
+  void operator=(LnsRunner) = delete;
+
+  /** Limits the whole search in seconds, the default is 60. */
+  void setTimeLimit(double seconds) { _time_limit = seconds; }
+
+  /** Limits each sub-MIP in seconds, the default is 10. */
+  void setRegionTimeLimit(double seconds) { _region_time_limit = seconds; }
+
+  /** Sets the number of stations of a region, the default is 30. */
+  void setRegionSize(int stations) { _region_size = stations; }
+
+  /** Sets the number of regions solved in parallel, 0 uses all cores. */
+  void setThreads(int threads) { _threads = threads; }
+
+  /**
+   * Stops after the given number of rounds without improvement, 0 only stops
+   * at the time limit. The default is 20.
+   */
+  void setPatience(int rounds) { _patience = rounds; }
+
+  void setSeed(uint32_t seed) { _random.seed(seed); }
+
+  /**
+   * Starts from the given tour instead of the one repaired from the
+   * Lagrangian relaxation.
+   */
+  void setInitialTour(const std::list<leda::edge>& tour) {
+    _initial_tour = tour;
+  }
+
+  /**
+   * Runs the search, calling the handler after every round. Throws an
+   * exception if no initial tour can be found.
+   */
+  LnsResult run(ProgressHandler handler);
+
+ private:
+  /** The outcome of a single sub-MIP. */
+  struct RegionResult {
+    RegionResult() : improved(false), solved(false), value(0.0) {}
+
+    bool improved;
+    bool solved;  ///< no better tour exists with the rest fixed
+    double value;
+    std::vector<leda::edge> arcs;  ///< of the tour within the region
+  };
+
+  /** A station adjacent to another one, via the line or -1. */
+  struct Neighbor {
+    int station;
+    int line;
+  };
+
+  std::vector<std::vector<int>> pickRegions(int count);
+  void growRegion(int line, std::vector<bool>* taken,
+                  std::vector<int>* region) const;
+  void solveRegion(const std::vector<int>& region,
+                   const std::list<leda::edge>& tour, double value,
+                   double time_limit, RegionResult* result) const;
+  std::vector<bool> getRegionMask(const std::vector<int>& region) const;
+  /** Returns whether the arcs leave every station at least once. */
+  bool visitsAllStations(const std::vector<leda::edge>& arcs) const;
+  bool isRegionArc(leda::edge e, const std::vector<bool>& in_region) const {
+    return in_region[_station_ids[leda::source(e)]] &&
+           in_region[_station_ids[leda::target(e)]];
+  }
+
+  const leda::graph& _g;
+  const leda::edge_array<double>& _dist;
+  const leda::edge_array<bool>& _connection_arcs;
+
+  leda::node_array<int> _station_ids;
+  int _n_stations;
+  std::vector<std::string> _station_names;
+  std::vector<std::vector<leda::node>> _station_nodes;
+  std::vector<std::vector<Neighbor>> _neighbors;
+  std::vector<std::vector<int>> _line_stations;
+  std::vector<int> _hubs;
+
+  double _time_limit;
+  double _region_time_limit;
+  int _region_size;
+  int _threads;
+  int _patience;
+  std::mt19937 _random;
+  std::list<leda::edge> _initial_tour;
+};
+
+#endif  // UBAHN_SOLVER_LNS_RUNNER_H_
@@ -0,0 +1,492 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/multilevel_solver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/timer.h"
+#include "graph_builder.h"
+#include "solver/euler.h"
+#include "solver/lagrangian_bound.h"
+#include "solver/lns_runner.h"
+#include "solver/shared_incumbent.h"
+#include "solver/station_solver.h"
+#include "solver/tour_repair.h"
+#include "transport_defs.h"
+
+using leda::edge_array;
+using leda::node_array;
+using std::list;
+using std::map;
+using std::set;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+/// subgradient steps of the relaxation giving the first tour to beat
+const int INITIAL_ITERATIONS = 200;
+/// the share of the time limit left for solving the coarsest level
+const double COARSE_TIME_SHARE = 0.5;
+/// levels that remove fewer stations are not worth solving
+const double MIN_REDUCTION = 0.05;
+
+/** The station problem on one level, the original one or a coarse one. */
+struct Problem {
+  const leda::graph& graph;
+  const edge_array<double>& dist;
+  const map<string, set<node>>& stations;
+  const edge_array<bool>& connection_arcs;
+  const edge_array<string>& lines;
+};
+
+/** A coarse graph and the arcs of the next finer level its arcs stand for. */
+struct CoarseGraph {
+  leda::graph graph;
+  edge_array<double> dist;
+  map<string, set<node>> stations;
+  edge_array<bool> connection_arcs;
+  edge_array<string> lines;
+  edge_array<vector<edge>> expansion;
+
+  Problem getProblem() const {
+    return Problem{graph, dist, stations, connection_arcs, lines};
+  }
+};
+
+int getStationIds(const Problem& problem, node_array<int>* station_ids) {
+  station_ids->init(problem.graph, -1);
+
+  int n_stations = 0;
+  for (const auto& station : problem.stations) {
+    for (node n : station.second) (*station_ids)[n] = n_stations;
+    n_stations++;
+  }
+  return n_stations;
+}
+
+double getCost(const vector<edge>& arcs, const edge_array<double>& dist) {
+  double cost = 0.0;
+  for (edge e : arcs) cost += dist[e];
+  return cost;
+}
+
+/** Returns the lines riding to or from each station. */
+vector<set<string>> getStationLines(const Problem& problem,
+                                    const node_array<int>& station_ids,
+                                    int n_stations) {
+  vector<set<string>> station_lines(n_stations);
+  edge e;
+  forall_edges(e, problem.graph) {
+    if (problem.lines[e] == CHANGE_NAME) continue;
+    station_lines[station_ids[source(e)]].insert(problem.lines[e]);
+    station_lines[station_ids[target(e)]].insert(problem.lines[e]);
+  }
+  return station_lines;
+}
+
+/**
+ * A station is passed if each of its nodes is entered and left by a ride of
+ * its single line only, so that a tour can neither change nor switch there.
+ */
+vector<bool> findPassedStations(const Problem& problem,
+                                const node_array<int>& station_ids,
+                                const vector<set<string>>& station_lines) {
+  const leda::graph& g = problem.graph;
+
+  vector<bool> passed(station_lines.size(), true);
+  node n;
+  forall_nodes(n, g) {
+    const int station = station_ids[n];
+    if (station_lines[station].size() != 1 || g.indeg(n) != 1 ||
+        g.outdeg(n) != 1) {
+      passed[station] = false;
+      continue;
+    }
+
+    const edge in_edge = g.in_edges(n).front();
+    const edge out_edge = g.out_edges(n).front();
+    if (problem.connection_arcs[in_edge] ||
+        problem.connection_arcs[out_edge] ||
+        station_ids[source(in_edge)] == station ||
+        station_ids[target(out_edge)] == station) {
+      passed[station] = false;
+    }
+  }
+  return passed;
+}
+
+/**
+ * Coarsens the problem. Every chain of nodes of passed stations is replaced
+ * by an arc with the cost of the chain to a new node and an arc onwards. The
+ * nodes of the chains visiting the same stations form one new station, that
+ * is visited exactly if one of the chains is ridden completely. Transfer
+ * stations joined by a ride of at most the merge distance become a single
+ * station, so that a coarse tour may leave out some of them.
+ */
+unique_ptr<CoarseGraph> coarsen(const Problem& finer, double merge_distance) {
+  const leda::graph& g = finer.graph;
+  node_array<int> station_ids;
+  const int n_stations = getStationIds(finer, &station_ids);
+  const vector<set<string>> station_lines =
+      getStationLines(finer, station_ids, n_stations);
+  vector<bool> passed = findPassedStations(finer, station_ids, station_lines);
+
+  // a chain starts after a node of a station that is not passed, stations
+  // on a cycle of passed ones only are kept
+  vector<vector<edge>> chains;
+  vector<vector<int>> chain_stations;
+  node_array<int> chain_of(g, -1);
+  for (bool stable = false; !stable;) {
+    chains.clear();
+    chain_stations.clear();
+    chain_of.init(g, -1);
+
+    node n;
+    forall_nodes(n, g) {
+      if (!passed[station_ids[n]]) continue;
+
+      const edge in_edge = g.in_edges(n).front();
+      if (passed[station_ids[source(in_edge)]]) continue;
+
+      vector<edge> chain = {in_edge};
+      vector<int> stations;
+      for (node v = n; passed[station_ids[v]];) {
+        chain_of[v] = chains.size();
+        stations.push_back(station_ids[v]);
+
+        const edge out_edge = g.out_edges(v).front();
+        chain.push_back(out_edge);
+        v = target(out_edge);
+      }
+      std::sort(stations.begin(), stations.end());
+      stations.erase(std::unique(stations.begin(), stations.end()),
+                     stations.end());
+
+      chains.push_back(std::move(chain));
+      chain_stations.push_back(std::move(stations));
+    }
+
+    stable = true;
+    forall_nodes(n, g) {
+      if (passed[station_ids[n]] && chain_of[n] < 0) {
+        passed[station_ids[n]] = false;
+        stable = false;
+      }
+    }
+  }
+
+  // the merged stations are given by the root of their tree
+  vector<int> group(n_stations);
+  std::iota(group.begin(), group.end(), 0);
+  std::function<int(int)> find = [&group, &find](int station) {
+    if (group[station] != station) group[station] = find(group[station]);
+    return group[station];
+  };
+
+  edge e;
+  forall_edges(e, g) {
+    const int s = station_ids[source(e)];
+    const int t = station_ids[target(e)];
+    if (s == t || finer.lines[e] == CHANGE_NAME ||
+        finer.dist[e] > merge_distance) {
+      continue;
+    }
+    if (station_lines[s].size() > 1 && station_lines[t].size() > 1) {
+      group[find(s)] = find(t);
+    }
+  }
+
+  vector<string> names;
+  vector<vector<node>> station_nodes;
+  for (const auto& station : finer.stations) {
+    names.push_back(station.first);
+    station_nodes.emplace_back(station.second.begin(), station.second.end());
+  }
+
+  unique_ptr<CoarseGraph> coarse(new CoarseGraph());
+  leda::graph& cg = coarse->graph;
+
+  node_array<node> copies(g, nullptr);
+  node n;
+  forall_nodes(n, g) {
+    if (chain_of[n] < 0) copies[n] = cg.new_node();
+  }
+
+  // a generated name may be the name of a real or merged station, whose
+  // nodes would then be merged silently, so it is numbered until it is free
+  auto addStation = [&coarse](const string& name, const set<node>& nodes) {
+    string free_name = name;
+    for (int i = 2; coarse->stations.count(free_name) > 0; i++) {
+      free_name = name + " #" + std::to_string(i);
+    }
+    coarse->stations[free_name] = nodes;
+  };
+
+  map<int, vector<int>> members;
+  for (int station = 0; station < n_stations; station++) {
+    if (!passed[station]) members[find(station)].push_back(station);
+  }
+  for (const auto& member : members) {
+    string name;
+    set<node> nodes;
+    for (int station : member.second) {
+      name += (name.empty() ? "" : " + ") + names[station];
+      for (node v : station_nodes[station]) nodes.insert(copies[v]);
+    }
+    addStation(name, nodes);
+  }
+
+  /** The attributes of an arc of the coarse graph. */
+  struct ArcInfo {
+    double dist;
+    bool connection;
+    string line;
+    vector<edge> expansion;
+  };
+  vector<std::pair<edge, ArcInfo>> arcs;
+  forall_edges(e, g) {
+    if (chain_of[source(e)] >= 0 || chain_of[target(e)] >= 0) continue;
+
+    arcs.push_back(std::make_pair(
+        cg.new_edge(copies[source(e)], copies[target(e)]),
+        ArcInfo{finer.dist[e], finer.connection_arcs[e], finer.lines[e], {e}}));
+  }
+  // the chains over the same stations, e.g. both directions of a line, form
+  // a single station
+  map<vector<int>, set<node>> stretches;
+  for (size_t i = 0; i < chains.size(); i++) {
+    const vector<edge>& chain = chains[i];
+    const node stretch = cg.new_node();
+    stretches[chain_stations[i]].insert(stretch);
+
+    // the first arc stands for the whole chain
+    const string& line = finer.lines[chain.front()];
+    arcs.push_back(std::make_pair(
+        cg.new_edge(copies[source(chain.front())], stretch),
+        ArcInfo{getCost(chain, finer.dist), false, line, chain}));
+    arcs.push_back(std::make_pair(
+        cg.new_edge(stretch, copies[target(chain.back())]),
+        ArcInfo{0.0, false, line, vector<edge>()}));
+  }
+  for (const auto& stretch : stretches) {
+    string name;
+    for (int station : stretch.first) {
+      name += (name.empty() ? "[" : " | ") + names[station];
+    }
+    addStation(name + "]", stretch.second);
+  }
+
+  coarse->dist.init(cg, 0.0);
+  coarse->connection_arcs.init(cg, false);
+  coarse->lines.init(cg, CHANGE_NAME);
+  coarse->expansion.init(cg);
+  for (auto& arc : arcs) {
+    coarse->dist[arc.first] = arc.second.dist;
+    coarse->connection_arcs[arc.first] = arc.second.connection;
+    coarse->lines[arc.first] = arc.second.line;
+    coarse->expansion[arc.first] = std::move(arc.second.expansion);
+  }
+
+  return coarse;
+}
+
+/** Returns the arcs of the finer level the arcs of the coarse one stand for. */
+vector<edge> expand(const CoarseGraph& coarse, const vector<edge>& arcs) {
+  vector<edge> expanded;
+  for (edge e : arcs) {
+    expanded.insert(expanded.end(), coarse.expansion[e].begin(),
+                    coarse.expansion[e].end());
+  }
+  return expanded;
+}
+
+/** Joins the stations the tour misses, returns an empty tour if it fails. */
+vector<edge> repairTour(const Problem& problem, const vector<edge>& arcs) {
+  node_array<int> station_ids;
+  const int n_stations = getStationIds(problem, &station_ids);
+  TourRepair repair(problem.graph, station_ids, n_stations, problem.dist);
+
+  edge_array<double> values(problem.graph, 0.0);
+  for (edge e : arcs) values[e] = 1.0;
+  const edge_array<bool> enabled(problem.graph, true);
+  return repair.repair(values, enabled);
+}
+
+/**
+ * Solves the problem by a StationSolver, starting with the tour repaired from
+ * the Lagrangian relaxation as the one to beat. Returns the best tour found
+ * within the time limit, or throws an exception if there is none. Unless the
+ * tour is proven optimal, the report gets the reason.
+ */
+vector<edge> solveExactly(const Problem& problem, double time_limit,
+                          int threads, LevelReport* report) {
+  node_array<int> station_ids;
+  const int n_stations = getStationIds(problem, &station_ids);
+  LagrangianBound bound(problem.graph, station_ids, n_stations, problem.dist);
+  bound.setIterationLimit(INITIAL_ITERATIONS);
+  const BoundResult relaxation = bound.compute();
+
+  SharedIncumbent incumbent;
+  if (!relaxation.tour.empty()) {
+    incumbent.offer(-1, relaxation.upper_bound,
+                    buildEulerTour(problem.graph, relaxation.tour));
+  }
+
+  report->optimal = false;
+  try {
+    StationSolver solver(problem.graph, problem.dist, problem.stations,
+                         problem.connection_arcs);
+    solver.setVerbose(false);
+    if (threads > 0) {
+      solver.setThreads(threads);
+    }
+    solver.setTimeLimit(time_limit);
+    solver.setSharedIncumbent(&incumbent, 0);
+
+    try {
+      solver.solve();
+      report->optimal = true;
+    } catch (const std::runtime_error& e) {
+      // a cut off proves the repaired tour to be optimal
+      report->optimal = solver.isCutOff();
+      if (!report->optimal) report->error = e.what();
+    }
+  } catch (const std::runtime_error& e) {
+    // e.g. the coarse level has no unique station left
+    report->error = e.what();
+  }
+
+  const list<edge> tour = incumbent.getTour();
+  if (tour.empty()) {
+    std::ostringstream errBuf;
+    errBuf << "No tour found on level " << report->level;
+    if (!report->error.empty()) errBuf << ": " << report->error;
+    throw std::runtime_error(errBuf.str());
+  }
+  return vector<edge>(tour.begin(), tour.end());
+}
+
+LevelReport describe(const Problem& problem, int level) {
+  LevelReport report;
+  report.level = level;
+  report.stations = problem.stations.size();
+  report.nodes = problem.graph.number_of_nodes();
+  report.arcs = problem.graph.number_of_edges();
+  report.value = 0.0;
+  report.optimal = false;
+  report.seconds = 0.0;
+  return report;
+}
+}  // namespace
+
+MultilevelResult MultilevelSolver::solve() {
+  Timer timer;
+  auto elapsed = [&timer]() {
+    return timer.Elapsed<std::chrono::duration<double>>().count();
+  };
+
+  // coarsen until the problem is small enough or hardly shrinks any more
+  vector<unique_ptr<CoarseGraph>> coarse_graphs;
+  vector<Problem> problems = {
+      Problem{_builder.getGraph(), _builder.getDist(),
+              _builder.getStationNodes(), _builder.getConnections(),
+              _builder.getArcNames()}};
+  double merge_distance = _merge_distance;
+  while (int(coarse_graphs.size()) < _max_levels &&
+         int(problems.back().stations.size()) > _coarse_stations) {
+    unique_ptr<CoarseGraph> coarse = coarsen(problems.back(), merge_distance);
+    if (coarse->stations.size() >
+        (1.0 - MIN_REDUCTION) * problems.back().stations.size()) {
+      break;
+    }
+
+    problems.push_back(coarse->getProblem());
+    coarse_graphs.push_back(std::move(coarse));
+    merge_distance *= 2.0;
+  }
+
+  // without a coarse level, there is nothing left to refine
+  const double coarse_time =
+      problems.size() > 1 ? COARSE_TIME_SHARE * _time_limit : _time_limit;
+
+  MultilevelResult result;
+  int level = problems.size() - 1;
+  LevelReport report = describe(problems[level], level);
+  vector<edge> arcs =
+      solveExactly(problems[level], coarse_time, _threads, &report);
+  report.value = getCost(arcs, problems[level].dist);
+  report.seconds = elapsed();
+  result.levels.push_back(report);
+
+  // each finer level gets an equal share of the time left
+  for (level--; level >= 0; level--) {
+    const Problem& problem = problems[level];
+    const double start = elapsed();
+    report = describe(problem, level);
+
+    arcs = repairTour(problem, expand(*coarse_graphs[level], arcs));
+    if (arcs.empty()) {
+      std::ostringstream errBuf;
+      errBuf << "Cannot refine the tour of level " << level + 1;
+      throw std::runtime_error(errBuf.str());
+    }
+
+    LnsRunner runner(problem.graph, problem.dist, problem.stations,
+                     problem.connection_arcs, problem.lines);
+    runner.setInitialTour(buildEulerTour(problem.graph, arcs));
+    runner.setThreads(_threads);
+    runner.setTimeLimit(std::max(0.0, _time_limit - start) / (level + 1));
+    const LnsResult refined = runner.run(nullptr);
+    arcs.assign(refined.tour.begin(), refined.tour.end());
+
+    report.value = refined.value;
+    report.seconds = elapsed() - start;
+    result.levels.push_back(report);
+    if (level == 0) result.lower_bound = refined.lower_bound;
+  }
+
+  // without any coarse level, the original graph was solved exactly
+  if (problems.size() == 1) {
+    if (report.optimal) {
+      result.lower_bound = report.value;
+    } else {
+      node_array<int> station_ids;
+      const int n_stations = getStationIds(problems[0], &station_ids);
+      LagrangianBound bound(problems[0].graph, station_ids, n_stations,
+                            problems[0].dist);
+      bound.setIterationLimit(INITIAL_ITERATIONS);
+      result.lower_bound = bound.compute().lower_bound;
+    }
+  }
+
+  result.value = getCost(arcs, problems[0].dist);
+  result.tour = buildEulerTour(problems[0].graph, arcs);
+  result.seconds = elapsed();
+  return result;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_MULTILEVEL_SOLVER_H_
+#define UBAHN_SOLVER_MULTILEVEL_SOLVER_H_
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "base/graph.h"
+
+class GraphBuilder;
+
+/** The size of one level and the tour found on it. */
+struct LevelReport {
+  int level;  ///< 0 is the original graph
+  int stations;
+  int nodes;
+  int arcs;
+  double value;    ///< of the tour on the level
+  bool optimal;    ///< whether the tour is optimal for the level
+  double seconds;  ///< spent on the level
+  /// why the exact solve did not prove the tour optimal, if it did not
+  std::string error;
+};
+
+struct MultilevelResult {
+  MultilevelResult() : value(0.0), lower_bound(0.0), seconds(0.0) {}
+
+  double value;
+  double lower_bound;  ///< the best bound known for the original graph
+  std::list<leda::edge> tour;
+  double seconds;
+  std::vector<LevelReport> levels;  ///< from the coarsest to the original
+};
+
+/**
+ * Finds tours on networks that are too large for the exact solver. The graph
+ * is coarsened level by level: the stretches of a line between stations that
+ * are served by other lines or where the direction can be switched become
+ * single arcs through a station of their own, and transfer stations close to
+ * each other are merged. The coarsest level is solved exactly by a
+ * StationSolver. Its tour is expanded level by level, stations left out by a
+ * merge are joined by TourRepair, and the tour is re-optimized locally by an
+ * LnsRunner.
+ */
+class MultilevelSolver {
+ public:
+  /** The graph of the builder must be the one of the station problem. */
+  explicit MultilevelSolver(const GraphBuilder& builder)
+      : _builder(builder),
+        _time_limit(300.0),
+        _max_levels(3),
+        _coarse_stations(150),
+        _merge_distance(2.0),
+        _threads(0) {}
+
+  // disallow copy and assign
+  MultilevelSolver(const MultilevelSolver&) = delete;
+  void operator=(MultilevelSolver) = delete;
+
+  /**
+   * Limits the whole solve in seconds, the default is 300. Half of it is
+   * left for the coarsest level, all of it if the graph is not coarsened.
+   */
+  void setTimeLimit(double seconds) { _time_limit = seconds; }
+
+  /** Sets the maximum number of coarse levels, the default is 3. */
+  void setMaxLevels(int levels) { _max_levels = levels; }
+
+  /**
+   * Stops coarsening once a level has at most this many stations, the
+   * default is 150.
+   */
+  void setCoarseStations(int stations) { _coarse_stations = stations; }
+
+  /**
+   * Sets the longest ride between two transfer stations that are merged on
+   * the first level, it doubles on every further level. The default is 2.
+   */
+  void setMergeDistance(double distance) { _merge_distance = distance; }
+
+  /** Sets the number of threads, 0 uses all cores, the default. */
+  void setThreads(int threads) { _threads = threads; }
+
+  /**
+   * Coarsens, solves and refines the problem. Throws an exception if no tour
+   * can be found.
+   */
+  MultilevelResult solve();
+
+ private:
+  const GraphBuilder& _builder;
+
+  double _time_limit;
+  int _max_levels;
+  int _coarse_stations;
+  double _merge_distance;
+  int _threads;
+};
+
+#endif  // UBAHN_SOLVER_MULTILEVEL_SOLVER_H_
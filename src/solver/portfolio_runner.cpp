@@ -0,0 +1,199 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/portfolio_runner.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/timer.h"
+#include "graph_builder.h"
+#include "solver/station_solver.h"
+
+using std::string;
+using std::vector;
+
+struct PortfolioRunner::Racer {
+  std::unique_ptr<GraphBuilder> builder;
+  std::unique_ptr<StationSolver> solver;
+};
+
+vector<PortfolioConfig> defaultPortfolio(int size) {
+  struct Setting {
+    const char* name;
+    CutPolicy cut_policy;
+    int emphasis;
+    int symmetry;
+  };
+  // the settings that differ most come first
+  const Setting settings[] = {
+      {"default", DEAGGREGATED_CUTS, IloCplex::MIPEmphasisBalanced, -1},
+      {"bestbound", DEAGGREGATED_CUTS, IloCplex::MIPEmphasisBestBound, -1},
+      {"adaptive", ADAPTIVE_CUTS, IloCplex::MIPEmphasisBalanced, -1},
+      {"symmetry", DEAGGREGATED_CUTS, IloCplex::MIPEmphasisBalanced, 3},
+      {"aggregated", AGGREGATED_CUTS, IloCplex::MIPEmphasisBalanced, -1},
+      {"optimality", DEAGGREGATED_CUTS, IloCplex::MIPEmphasisOptimality, -1},
+      {"feasibility", DEAGGREGATED_CUTS, IloCplex::MIPEmphasisFeasibility,
+       -1}};
+  const int n_settings = sizeof(settings) / sizeof(settings[0]);
+
+  vector<PortfolioConfig> configs;
+  for (int i = 0; i < size; i++) {
+    const Setting& setting = settings[i % n_settings];
+
+    PortfolioConfig config;
+    config.name = setting.name;
+    config.cut_policy = setting.cut_policy;
+    config.emphasis = setting.emphasis;
+    config.symmetry = setting.symmetry;
+    if (i >= n_settings) {
+      config.seed = i / n_settings + 1;
+      config.name += "-seed" + std::to_string(config.seed);
+    }
+    configs.push_back(config);
+  }
+
+  return configs;
+}
+
+PortfolioRunner::PortfolioRunner(const t_stationmap& stations,
+                                 const t_linemap& lines, double change_cost,
+                                 double switch_cost, bool preprocess)
+    : _stations(stations),
+      _lines(lines),
+      _change_cost(change_cost),
+      _switch_cost(switch_cost),
+      _preprocess(preprocess),
+      _time_limit(0.0),
+      _winner(-1) {}
+
+PortfolioRunner::~PortfolioRunner() {}
+
+PortfolioResult PortfolioRunner::run(const vector<PortfolioConfig>& configs) {
+  if (configs.empty()) {
+    throw std::runtime_error("The portfolio is empty");
+  }
+
+  Timer timer;
+  _incumbent.reset(new SharedIncumbent());
+  _racers.clear();
+  for (size_t i = 0; i < configs.size(); i++) {
+    _racers.emplace_back(new Racer());
+  }
+  _winner = -1;
+  _errors.clear();
+
+  vector<std::thread> threads;
+  for (size_t i = 0; i < configs.size(); i++) {
+    threads.emplace_back(&PortfolioRunner::race, this, std::cref(configs[i]),
+                         i);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  if (_winner < 0) {
+    std::ostringstream errBuf;
+    errBuf << "No configuration of the portfolio proved optimality:";
+    for (const string& error : _errors) {
+      errBuf << std::endl << "  " << error;
+    }
+    throw std::runtime_error(errBuf.str());
+  }
+
+  PortfolioResult result;
+  const Racer& winner = *_racers[_winner];
+  result.winner = configs[_winner].name;
+  result.statistics = winner.solver->getStatistics();
+  if (winner.solver->isCutOff()) {
+    // the winner only proved that the tour of another solver is optimal
+    const int owner = _incumbent->getOwner();
+    result.objective = _incumbent->getValue();
+    result.tour = _racers[owner]->builder->getTourLegs(_incumbent->getTour());
+    result.tour_from = configs[owner].name;
+  } else {
+    result.objective = winner.solver->getSolutionValue();
+    result.tour = winner.builder->getTourLegs(winner.solver->getSolutionTour());
+    result.tour_from = result.winner;
+  }
+  result.solve_ms =
+      timer.Elapsed<std::chrono::duration<double, std::milli>>().count();
+
+  _racers.clear();
+  return result;
+}
+
+void PortfolioRunner::race(const PortfolioConfig& config, int index) {
+  Racer& racer = *_racers[index];
+
+  try {
+    racer.builder.reset(new GraphBuilder(_stations, _lines, _change_cost,
+                                         _switch_cost, STATION,
+                                         _preprocess));
+    const GraphBuilder& builder = *racer.builder;
+
+    std::unique_ptr<StationSolver> solver(new StationSolver(
+        builder.getGraph(), builder.getDist(), builder.getStationNodes(),
+        builder.getConnections()));
+    solver->setVerbose(false);
+    solver->setCutPolicy(config.cut_policy);
+    if (_time_limit > 0) {
+      solver->setTimeLimit(_time_limit);
+    }
+    solver->setEmphasis(config.emphasis);
+    solver->setSymmetry(config.symmetry);
+    if (config.seed != 0) {
+      solver->setRandomSeed(config.seed);
+    }
+    solver->setSharedIncumbent(_incumbent.get(), index);
+
+    {
+      // the race may have been decided while the model was built
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_winner >= 0) return;
+      racer.solver = std::move(solver);
+    }
+
+    racer.solver->solve();
+    decide(index);
+  } catch (const std::runtime_error& e) {
+    if (racer.solver && racer.solver->isCutOff()) {
+      decide(index);
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _errors.push_back(config.name + ": " + e.what());
+  }
+}
+
+bool PortfolioRunner::decide(int index) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_winner >= 0) return false;
+
+  _winner = index;
+  for (size_t i = 0; i < _racers.size(); i++) {
+    if (i != index && _racers[i]->solver) {
+      _racers[i]->solver->abort();
+    }
+  }
+  return true;
+}
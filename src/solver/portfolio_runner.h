@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_PORTFOLIO_RUNNER_H_
+#define UBAHN_SOLVER_PORTFOLIO_RUNNER_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "solver/shared_incumbent.h"
+#include "solver/solver_statistics.h"
+#include "solver/station_solver.h"
+#include "transport_defs.h"
+
+/** The settings of one solver of a portfolio. */
+struct PortfolioConfig {
+  PortfolioConfig()
+      : cut_policy(DEAGGREGATED_CUTS),
+        emphasis(0),
+        symmetry(-1),
+        seed(0) {}
+
+  std::string name;
+  CutPolicy cut_policy;
+  int emphasis;  ///< the CPLEX MIP emphasis, 0 is balanced
+  int symmetry;  ///< the CPLEX symmetry breaking level, -1 lets CPLEX decide
+  int seed;      ///< the CPLEX random seed, 0 keeps the default
+};
+
+/**
+ * Returns the given number of configurations. The first ones differ in the
+ * cut policy and the CPLEX search settings, further ones only in the seed.
+ */
+std::vector<PortfolioConfig> defaultPortfolio(int size);
+
+struct PortfolioResult {
+  PortfolioResult() : objective(0.0), solve_ms(0.0) {}
+
+  double objective;
+  std::vector<TourLeg> tour;
+
+  std::string winner;     ///< the configuration that proved the optimum
+  std::string tour_from;  ///< the configuration that found the tour
+  SolverStatistics statistics;  ///< of the winner
+  double solve_ms;
+};
+
+/**
+ * Solves the network with several differently configured solvers in parallel,
+ * each with its own graph and CPLEX environment. The solvers share their
+ * tours as cutoffs and the first one that proves optimality stops the others.
+ * All of them solve the same model, as a tour of the raw graph may be shorter
+ * than the optimum of the preprocessed one and a cutoff by it proves nothing.
+ */
+class PortfolioRunner {
+ public:
+  PortfolioRunner(const t_stationmap& stations, const t_linemap& lines,
+                  double change_cost, double switch_cost, bool preprocess);
+  ~PortfolioRunner();
+
+  // disallow copy and assign
+  PortfolioRunner(const PortfolioRunner&) = delete;
+  void operator=(PortfolioRunner) = delete;
+
+  /** Limits each solver to the given seconds, 0 for no limit. */
+  void setTimeLimit(double seconds) { _time_limit = seconds; }
+
+  /**
+   * Races one single threaded solver per configuration. Throws an exception
+   * if none of them can prove optimality.
+   */
+  PortfolioResult run(const std::vector<PortfolioConfig>& configs);
+
+ private:
+  struct Racer;
+
+  void race(const PortfolioConfig& config, int index);
+  /** Ends the race, returns false if it was already decided. */
+  bool decide(int index);
+
+  const t_stationmap& _stations;
+  const t_linemap& _lines;
+  const double _change_cost;
+  const double _switch_cost;
+  const bool _preprocess;
+  double _time_limit;
+
+  /// guards the racers and the decision
+  std::mutex _mutex;
+  std::vector<std::unique_ptr<Racer>> _racers;
+  int _winner;
+  std::vector<std::string> _errors;
+
+  std::unique_ptr<SharedIncumbent> _incumbent;
+};
+
+#endif  // UBAHN_SOLVER_PORTFOLIO_RUNNER_H_
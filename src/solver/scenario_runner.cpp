@@ -0,0 +1,246 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/scenario_runner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/parallel.h"
+#include "base/timer.h"
+
+using leda::edge_array;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+/** Computes the arc costs of the scenario from the ride times. */
+void computeCosts(const CostScenario& scenario, const leda::graph& g,
+                  const GraphBuilder& builder,
+                  const edge_array<double>& ride_times,
+                  edge_array<double>* costs) {
+  edge e;
+  forall_edges(e, g) {
+    switch (builder.getArcTypes()[e]) {
+      case RIDE_ARC: {
+        double factor = scenario.ride_factor;
+        auto pos = scenario.line_factors.find(builder.getArcNames()[e]);
+        if (pos != scenario.line_factors.end()) {
+          factor *= pos->second;
+        }
+        (*costs)[e] = factor * ride_times[e];
+        break;
+      }
+      case CHANGE_ARC:
+        (*costs)[e] = scenario.change_cost;
+        break;
+      case SWITCH_ARC:
+        (*costs)[e] = scenario.switch_cost;
+        break;
+    }
+  }
+}
+}  // namespace
+
+void solveSession(SolverSession* session, ScenarioResult* result) {
+  Timer timer;
+  session->solve();
+  result->solve_ms =
+      timer.Elapsed<std::chrono::duration<double, std::milli>>().count();
+
+  result->objective = session->getSolutionValue();
+  result->statistics = session->getStatistics();
+
+  std::ostringstream tour;
+  session->getBuilder().printTour(session->getSolutionTour(), true, tour);
+  result->tour = tour.str();
+  result->solved = true;
+}
+
+ScenarioSession::ScenarioSession(const t_stationmap& stations,
+                                 const t_linemap& lines, bool preprocess) {
+  const CostScenario defaults;
+  _session.reset(new SolverSession(stations, lines, defaults.change_cost,
+                                   defaults.switch_cost, preprocess));
+  _session->setVerbose(false);
+
+  // the ride times do not depend on the scenario
+  const leda::graph& g = _session->getGraph();
+  _ride_times.init(g, 0.0);
+  _costs.init(g, 0.0);
+  edge e;
+  forall_edges(e, g) { _ride_times[e] = _session->getArcCost(e); }
+}
+
+ScenarioResult ScenarioSession::solve(const CostScenario& scenario) {
+  ScenarioResult result;
+  result.name = scenario.name;
+
+  try {
+    computeCosts(scenario, _session->getGraph(), _session->getBuilder(),
+                 _ride_times, &_costs);
+    _session->setArcCosts(_costs);
+    solveSession(_session.get(), &result);
+  } catch (const std::runtime_error& e) {
+    result.error = e.what();
+  }
+
+  return result;
+}
+
+string formatScenario(const CostScenario& scenario) {
+  std::ostringstream line;
+  line << std::setprecision(17) << scenario.name << ' ' << scenario.change_cost
+       << ' ' << scenario.switch_cost << ' ' << scenario.ride_factor;
+  for (const auto& factor : scenario.line_factors) {
+    line << ' ' << factor.first << '=' << factor.second;
+  }
+
+  return line.str();
+}
+
+vector<CostScenario> readScenarios(std::istream& in) {
+  vector<CostScenario> scenarios;
+
+  string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    line_number++;
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream fields(line);
+    CostScenario scenario;
+    string change, change_switch;
+    if (!(fields >> scenario.name >> change >> change_switch)) {
+      std::ostringstream errBuf;
+      errBuf << "Invalid scenario in line " << line_number;
+      throw std::runtime_error(errBuf.str());
+    }
+
+    try {
+      scenario.change_cost = boost::lexical_cast<double>(change);
+      scenario.switch_cost = boost::lexical_cast<double>(change_switch);
+
+      string field;
+      while (fields >> field) {
+        const size_t eq = field.find('=');
+        if (eq == string::npos) {
+          scenario.ride_factor = boost::lexical_cast<double>(field);
+        } else {
+          scenario.line_factors[field.substr(0, eq)] =
+              boost::lexical_cast<double>(field.substr(eq + 1));
+        }
+      }
+    } catch (const boost::bad_lexical_cast&) {
+      std::ostringstream errBuf;
+      errBuf << "Invalid number in scenario line " << line_number;
+      throw std::runtime_error(errBuf.str());
+    }
+
+    scenarios.push_back(scenario);
+  }
+
+  return scenarios;
+}
+
+vector<ScenarioResult> ScenarioRunner::run(
+    const vector<CostScenario>& scenarios, int threads) const {
+  vector<ScenarioResult> results(scenarios.size());
+
+  // contiguous blocks keep similar neighbouring scenarios in one session
+  runInBlocks(scenarios.size(), threads, [&](size_t begin, size_t end) {
+    runBlock(scenarios, begin, end, &results);
+  });
+
+  return results;
+}
+
+void ScenarioRunner::runBlock(const vector<CostScenario>& scenarios,
+                              size_t begin, size_t end,
+                              vector<ScenarioResult>* results) const {
+  if (begin >= end) return;
+
+  std::unique_ptr<ScenarioSession> session;
+  try {
+    session.reset(new ScenarioSession(_stations, _lines, _preprocess));
+  } catch (const std::runtime_error& e) {
+    for (size_t i = begin; i < end; i++) {
+      (*results)[i].name = scenarios[i].name;
+      (*results)[i].error = e.what();
+    }
+    return;
+  }
+
+  for (size_t i = begin; i < end; i++) {
+    (*results)[i] = session->solve(scenarios[i]);
+  }
+}
+
+void printScenarioReport(const vector<ScenarioResult>& results,
+                         std::ostream& O) {
+  const bool has_base =
+      std::any_of(results.begin(), results.end(),
+                  [](const ScenarioResult& r) { return r.has_base; });
+
+  O << std::left << std::setw(20) << "scenario" << std::right
+    << std::setw(12) << "objective";
+  if (has_base) O << std::setw(10) << "delta";
+  O << std::setw(12) << "solve ms" << std::setw(10) << "nodes"
+    << std::setw(10) << "cuts" << endl;
+
+  for (const ScenarioResult& r : results) {
+    O << std::left << std::setw(20) << r.name << std::right;
+    if (!r.solved) {
+      O << " failed: " << r.error << endl;
+      continue;
+    }
+
+    O << std::setw(12) << r.objective;
+    if (has_base) {
+      O << std::showpos << std::setw(10) << r.objective - r.base_objective
+        << std::noshowpos;
+    }
+    O << std::setw(12) << std::fixed << std::setprecision(1) << r.solve_ms
+      << std::setw(10) << r.statistics.nodes << std::setw(10)
+      << r.statistics.lazy_cuts + r.statistics.pooled_cuts << endl;
+    O.unsetf(std::ios_base::floatfield);
+    O << std::setprecision(6);
+  }
+}
+
+int reportScenarioResults(const vector<ScenarioResult>& results,
+                          bool print_tours, std::ostream& O) {
+  printScenarioReport(results, O);
+
+  int failed = 0;
+  for (const ScenarioResult& r : results) {
+    if (!r.solved) {
+      failed++;
+    } else if (print_tours) {
+      O << endl << r.name << ":" << endl << r.tour;
+    }
+  }
+
+  return failed > 0 ? 1 : 0;
+}
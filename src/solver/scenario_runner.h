@@ -0,0 +1,152 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_SCENARIO_RUNNER_H_
+#define UBAHN_SOLVER_SCENARIO_RUNNER_H_
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/graph.h"
+#include "solver/cplex_solver.h"
+#include "solver/solver_session.h"
+#include "transport_defs.h"
+
+/**
+ * A cost variant of the network. Only the objective depends on it, so all
+ * scenarios share the same graph and model.
+ */
+struct CostScenario {
+  CostScenario() : change_cost(5.0), switch_cost(5.0), ride_factor(1.0) {}
+
+  std::string name;
+  double change_cost;  ///< cost for changing the line
+  double switch_cost;  ///< cost for switching the direction
+  double ride_factor;  ///< factor applied to all ride times
+
+  /// additional factors for the ride times of individual lines
+  std::map<std::string, double> line_factors;
+};
+
+struct ScenarioResult {
+  ScenarioResult()
+      : solved(false),
+        objective(0.0),
+        has_base(false),
+        base_objective(0.0),
+        solve_ms(0.0) {}
+
+  std::string name;
+  bool solved;
+  std::string error;  ///< the reason, if the scenario could not be solved
+
+  double objective;
+  /// whether the scenario is compared to the objective of the unchanged
+  /// problem, as for closures
+  bool has_base;
+  double base_objective;
+  double solve_ms;
+  SolverStatistics statistics;
+  std::string tour;  ///< the tour as printed by GraphBuilder::printTour
+};
+
+/**
+ * Solves the current problem of the session and stores the objective, time,
+ * statistics and tour in the result. Throws an exception if that fails.
+ */
+void solveSession(SolverSession* session, ScenarioResult* result);
+
+/**
+ * Solves cost scenarios one after another on the same session, each one
+ * warm-started from the optimum of the previous one.
+ */
+class ScenarioSession {
+ public:
+  /** Builds the graph and the model, throws an exception if that fails. */
+  ScenarioSession(const t_stationmap& stations, const t_linemap& lines,
+                  bool preprocess = true);
+
+  // disallow copy and assign
+  ScenarioSession(const ScenarioSession&) = delete;
+  void operator=(ScenarioSession) = delete;
+
+  /** Solves the scenario, failures are reported in the result. */
+  ScenarioResult solve(const CostScenario& scenario);
+
+ private:
+  std::unique_ptr<SolverSession> _session;
+
+  leda::edge_array<double> _ride_times;
+  leda::edge_array<double> _costs;
+};
+
+/** Formats the scenario as a line that is read by readScenarios. */
+std::string formatScenario(const CostScenario& scenario);
+
+/**
+ * Reads scenarios, one per line in the format
+ * "name change_cost switch_cost [ride_factor] [line=factor ...]".
+ * Empty lines and lines starting with # are ignored. Throws an exception on
+ * invalid input.
+ */
+std::vector<CostScenario> readScenarios(std::istream& in);
+
+/**
+ * Solves a list of cost scenarios on one network. Each thread builds the
+ * graph and the model once and re-solves a contiguous block of scenarios by
+ * changing only the objective, warm-started from the previous optimum.
+ */
+class ScenarioRunner {
+ public:
+  ScenarioRunner(const t_stationmap& stations, const t_linemap& lines,
+                 bool preprocess = true)
+      : _stations(stations), _lines(lines), _preprocess(preprocess) {}
+
+  // disallow copy and assign
+  ScenarioRunner(const ScenarioRunner&) = delete;
+  void operator=(ScenarioRunner) = delete;
+
+  /** Returns the results in the order of the scenarios. */
+  std::vector<ScenarioResult> run(const std::vector<CostScenario>& scenarios,
+                                  int threads) const;
+
+ private:
+  void runBlock(const std::vector<CostScenario>& scenarios, size_t begin,
+                size_t end, std::vector<ScenarioResult>* results) const;
+
+  const t_stationmap& _stations;
+  const t_linemap& _lines;
+  const bool _preprocess;
+};
+
+/**
+ * Prints a table of all results, including the change of the objective if
+ * the results have a base objective.
+ */
+void printScenarioReport(const std::vector<ScenarioResult>& results,
+                         std::ostream& O = std::cout);
+
+/**
+ * Prints the table and, if requested, the tour of every solved scenario.
+ * Returns the exit status of the scenario tools, 1 if a scenario failed.
+ */
+int reportScenarioResults(const std::vector<ScenarioResult>& results,
+                          bool print_tours, std::ostream& O = std::cout);
+
+#endif  // UBAHN_SOLVER_SCENARIO_RUNNER_H_
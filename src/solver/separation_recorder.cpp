@@ -0,0 +1,209 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/separation_recorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using leda::node_array;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char HEADER[] = "ubahn-separation 2";
+
+void expect(std::istream& in, const string& keyword) {
+  string word;
+  if (!(in >> word) || word != keyword) {
+    throw std::runtime_error("Invalid separation recording: Expected " +
+                             keyword);
+  }
+}
+
+/** Reads a number in [0, end), throws if it is missing or out of range. */
+int readIndex(std::istream& in, int end, const char* what) {
+  int index;
+  if (!(in >> index) || index < 0 || index >= end) {
+    throw std::runtime_error(string("Invalid separation recording: Invalid ") +
+                             what);
+  }
+  return index;
+}
+
+/** Reads a count, throws if it is missing or negative. */
+int readCount(std::istream& in, const char* what) {
+  return readIndex(in, std::numeric_limits<int>::max(), what);
+}
+
+void writeArcs(const vector<int>& arcs, std::ostream& out) {
+  out << " " << arcs.size();
+  for (int arc : arcs) {
+    out << " " << arc;
+  }
+}
+
+vector<int> readArcs(std::istream& in, int n_arcs) {
+  // a cut cannot contain more arcs than the graph
+  vector<int> arcs(readIndex(in, n_arcs + 1, "cut"));
+  for (int& arc : arcs) {
+    arc = readIndex(in, n_arcs, "cut");
+  }
+  return arcs;
+}
+}  // namespace
+
+vector<RecordedCut> getRecordedCuts(const vector<SubtourCut>& cuts,
+                                    const leda::edge_array<int>& arc_index) {
+  vector<RecordedCut> result;
+  for (const SubtourCut& cut : cuts) {
+    RecordedCut recorded;
+    for (edge e : cut.out_arcs) {
+      recorded.out_arcs.push_back(arc_index[e]);
+    }
+    for (edge e : cut.in_arcs) {
+      recorded.in_arcs.push_back(arc_index[e]);
+    }
+    std::sort(recorded.out_arcs.begin(), recorded.out_arcs.end());
+    std::sort(recorded.in_arcs.begin(), recorded.in_arcs.end());
+    result.push_back(recorded);
+  }
+
+  std::sort(result.begin(), result.end(),
+            [](const RecordedCut& a, const RecordedCut& b) {
+              return a.out_arcs < b.out_arcs ||
+                     (a.out_arcs == b.out_arcs && a.in_arcs < b.in_arcs);
+            });
+  return result;
+}
+
+SeparationRecorder::SeparationRecorder(const string& file,
+                                       const leda::graph& graph,
+                                       const node_array<int>& station_ids,
+                                       int n_stations)
+    : _out(file), _arc_index(graph, -1) {
+  if (!_out) {
+    throw std::runtime_error("Cannot create file " + file);
+  }
+
+  node_array<int> node_index(graph, -1);
+  int n_nodes = 0;
+
+  _out << HEADER << endl;
+  _out << "stations " << n_stations << endl;
+  _out << "nodes " << graph.number_of_nodes() << endl;
+  node n;
+  forall_nodes(n, graph) {
+    node_index[n] = n_nodes++;
+    _out << station_ids[n] << endl;
+  }
+
+  int n_arcs = 0;
+  _out << "arcs " << graph.number_of_edges() << endl;
+  edge e;
+  forall_edges(e, graph) {
+    _arc_index[e] = n_arcs++;
+    _out << node_index[source(e)] << " " << node_index[target(e)] << endl;
+  }
+}
+
+void SeparationRecorder::record(const leda::list<edge>& selected,
+                                const vector<SubtourCut>& cuts) {
+  _out << "x " << cuts.size() << " " << selected.size();
+  edge e;
+  forall(e, selected) { _out << " " << _arc_index[e]; }
+  _out << endl;
+
+  for (const RecordedCut& cut : getRecordedCuts(cuts, _arc_index)) {
+    _out << "c";
+    writeArcs(cut.out_arcs, _out);
+    writeArcs(cut.in_arcs, _out);
+    _out << endl;
+  }
+}
+
+void readSeparationRecording(const string& file,
+                             SeparationRecording* recording) {
+  std::ifstream in(file);
+  if (!in) {
+    throw std::runtime_error("Cannot open file " + file);
+  }
+
+  string header;
+  std::getline(in, header);
+  if (header != HEADER) {
+    throw std::runtime_error("Invalid separation recording: Unknown header");
+  }
+
+  expect(in, "stations");
+  recording->n_stations = readCount(in, "station count");
+  expect(in, "nodes");
+  const int n_nodes = readCount(in, "node count");
+
+  vector<node> nodes;
+  vector<int> station_ids;
+  for (int i = 0; i < n_nodes; i++) {
+    nodes.push_back(recording->graph.new_node());
+    station_ids.push_back(readIndex(in, recording->n_stations, "station"));
+  }
+
+  expect(in, "arcs");
+  const int n_arcs = readCount(in, "arc count");
+  for (int i = 0; i < n_arcs; i++) {
+    const int s = readIndex(in, n_nodes, "arc");
+    const int t = readIndex(in, n_nodes, "arc");
+    recording->arcs.push_back(recording->graph.new_edge(nodes[s], nodes[t]));
+  }
+
+  recording->station_ids.init(recording->graph, -1);
+  for (int i = 0; i < n_nodes; i++) {
+    recording->station_ids[nodes[i]] = station_ids[i];
+  }
+  recording->arc_index.init(recording->graph, -1);
+  for (int i = 0; i < n_arcs; i++) {
+    recording->arc_index[recording->arcs[i]] = i;
+  }
+
+  string keyword;
+  while (in >> keyword) {
+    if (keyword != "x") {
+      throw std::runtime_error("Invalid separation recording: Expected x");
+    }
+
+    SeparationRecording::Solution solution;
+    const int n_cuts = readCount(in, "solution");
+    solution.arcs.resize(readIndex(in, n_arcs + 1, "solution"));
+    for (int& arc : solution.arcs) {
+      arc = readIndex(in, n_arcs, "solution");
+    }
+    for (int i = 0; i < n_cuts; i++) {
+      expect(in, "c");
+      RecordedCut cut;
+      cut.out_arcs = readArcs(in, n_arcs);
+      cut.in_arcs = readArcs(in, n_arcs);
+      solution.cuts.push_back(cut);
+    }
+    recording->solutions.push_back(solution);
+  }
+  if (!in.eof()) {
+    throw std::runtime_error("Invalid separation recording: Read error");
+  }
+}
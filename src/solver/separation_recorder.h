@@ -0,0 +1,91 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_SEPARATION_RECORDER_H_
+#define UBAHN_SOLVER_SEPARATION_RECORDER_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "base/graph.h"
+#include "solver/subtour_separator.h"
+
+/**
+ * Records the integral solutions seen by the lazy callback together with a
+ * snapshot of the problem graph, so that the separation can be replayed and
+ * benchmarked without CPLEX.
+ *
+ * The file format is line based: a header, the station of every node, the
+ * end nodes of every arc and then one line per solution of the form
+ * "x <cuts> <k> <arc_1> ... <arc_k>", listing the indices of the selected
+ * arcs, followed by one line "c <m> <out_1> ... <out_m> <n> <in_1> ... <in_n>"
+ * per cut found for them.
+ */
+class SeparationRecorder {
+ public:
+  /** Creates the file and writes the graph snapshot. Throws on failure. */
+  SeparationRecorder(const std::string& file, const leda::graph& graph,
+                     const leda::node_array<int>& station_ids,
+                     int n_stations);
+
+  // disallow copy and assign
+  SeparationRecorder(const SeparationRecorder&) = delete;
+  void operator=(SeparationRecorder) = delete;
+
+  void record(const leda::list<leda::edge>& selected,
+              const std::vector<SubtourCut>& cuts);
+
+ private:
+  std::ofstream _out;
+  leda::edge_array<int> _arc_index;
+};
+
+/** The arcs of a subtour cut by index, each list sorted. */
+struct RecordedCut {
+  std::vector<int> out_arcs;
+  std::vector<int> in_arcs;
+};
+
+/**
+ * Converts the cuts to arc indices. The cuts are sorted as well, so that the
+ * result does not depend on the order in which they were found.
+ */
+std::vector<RecordedCut> getRecordedCuts(
+    const std::vector<SubtourCut>& cuts,
+    const leda::edge_array<int>& arc_index);
+
+/** A recording read back from a file. */
+struct SeparationRecording {
+  struct Solution {
+    std::vector<int> arcs;
+    std::vector<RecordedCut> cuts;
+  };
+
+  leda::graph graph;
+  leda::node_array<int> station_ids;
+  int n_stations;
+
+  std::vector<leda::edge> arcs;      ///< the arcs of the graph by index
+  leda::edge_array<int> arc_index;  ///< the index of each arc
+  std::vector<Solution> solutions;
+};
+
+/** Reads a recording, throws an exception if the file is invalid. */
+void readSeparationRecording(const std::string& file,
+                             SeparationRecording* recording);
+
+#endif  // UBAHN_SOLVER_SEPARATION_RECORDER_H_
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_SHARED_INCUMBENT_H_
+#define UBAHN_SOLVER_SHARED_INCUMBENT_H_
+
+#include <atomic>
+#include <limits>
+#include <list>
+#include <mutex>
+
+#include "base/graph.h"
+
+/**
+ * The best tour found so far by several solvers racing on the same problem.
+ * Each solver has its own graph, so the tour is stored together with the
+ * index of the solver whose graph it belongs to. All methods are thread safe.
+ */
+class SharedIncumbent {
+ public:
+  SharedIncumbent()
+      : _value(std::numeric_limits<double>::infinity()), _owner(-1) {}
+
+  // disallow copy and assign
+  SharedIncumbent(const SharedIncumbent&) = delete;
+  void operator=(SharedIncumbent) = delete;
+
+  /** Returns the value of the best tour, infinity if there is none. */
+  double getValue() const { return _value.load(); }
+
+  /** Keeps the tour if it is better than the current one. */
+  bool offer(int owner, double value, const std::list<leda::edge>& tour) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (value >= _value.load()) return false;
+
+    _value.store(value);
+    _owner = owner;
+    _tour = tour;
+    return true;
+  }
+
+  /** Returns the solver that found the best tour, -1 if there is none. */
+  int getOwner() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _owner;
+  }
+
+  std::list<leda::edge> getTour() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _tour;
+  }
+
+ private:
+  /// read without locking by the branch callbacks of all solvers
+  std::atomic<double> _value;
+
+  mutable std::mutex _mutex;
+  int _owner;
+  std::list<leda::edge> _tour;
+};
+
+#endif  // UBAHN_SOLVER_SHARED_INCUMBENT_H_
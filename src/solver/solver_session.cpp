@@ -0,0 +1,285 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/solver_session.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using leda::edge_array;
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+/** Returns the index of the station within the line, throws if missing. */
+int findPosition(const Line& line, const string& station) {
+  auto pos = std::find(line.stations.begin(), line.stations.end(), station);
+  if (pos == line.stations.end()) {
+    throw std::runtime_error("Station " + station + " is not on line " +
+                             line.name);
+  }
+
+  return pos - line.stations.begin();
+}
+}  // namespace
+
+SolverSession::SolverSession(const t_stationmap& stations,
+                             const t_linemap& lines, double change_cost,
+                             double switch_cost, bool preprocess)
+    : _builder(stations, lines, change_cost, switch_cost, STATION,
+               preprocess),
+      _solver(_builder.getGraph(), _builder.getDist(),
+              _builder.getStationNodes(), _builder.getConnections()),
+      _closed_arcs(_builder.getGraph(), false) {
+  _solver.setKeepCuts(true);
+
+  const leda::graph& g = _builder.getGraph();
+  _cost.init(g);
+
+  edge e;
+  forall_edges(e, g) {
+    _cost[e] = _builder.getDist()[e];
+
+    const string& name = _builder.getArcNames()[e];
+    if (name != CHANGE_NAME) {
+      _line_arcs[name].push_back(e);
+    }
+  }
+}
+
+void SolverSession::setArcCost(edge e, double cost) {
+  _cost[e] = cost;
+  _solver.setArcCost(e, cost);
+}
+
+void SolverSession::setArcCosts(const leda::edge_array<double>& costs) {
+  _cost = costs;
+  _solver.setArcCosts(costs);
+}
+
+const vector<edge>& SolverSession::getLineArcs(const string& line) const {
+  auto pos = _line_arcs.find(line);
+  if (pos == _line_arcs.end()) {
+    throw std::runtime_error("Unknown line " + line);
+  }
+
+  return pos->second;
+}
+
+void SolverSession::setStationEnabled(const string& station, bool enabled) {
+  if (_builder.getStations().count(station) == 0) {
+    throw std::runtime_error("Unknown station " + station);
+  }
+
+  const set<string> previous = _disabled_stations;
+  if (enabled) {
+    _disabled_stations.erase(station);
+  } else {
+    _disabled_stations.insert(station);
+  }
+  try {
+    checkReachability(_closed_arcs, _closure.stations);
+  } catch (const std::runtime_error&) {
+    _disabled_stations = previous;
+    throw;
+  }
+  updateStation(station);
+}
+
+void SolverSession::setLineEnabled(const string& line, bool enabled) {
+  const vector<edge>& arcs = getLineArcs(line);
+
+  const set<string> previous = _disabled_lines;
+  if (enabled) {
+    _disabled_lines.erase(line);
+  } else {
+    _disabled_lines.insert(line);
+  }
+  try {
+    checkReachability(_closed_arcs, _closure.stations);
+  } catch (const std::runtime_error&) {
+    _disabled_lines = previous;
+    throw;
+  }
+  for (edge e : arcs) {
+    _solver.setArcEnabled(e, isArcEnabled(e, _closed_arcs));
+  }
+}
+
+void SolverSession::setClosure(const Closure& closure) {
+  for (const string& station : closure.stations) {
+    if (_builder.getStations().count(station) == 0) {
+      throw std::runtime_error("Unknown station " + station);
+    }
+  }
+
+  // the closed hops of each line given by the positions of their stations
+  map<string, vector<pair<int, int>>> closed_hops;
+  for (const LineSegment& segment : closure.segments) {
+    auto line = _builder.getLines().find(segment.line);
+    if (line == _builder.getLines().end()) {
+      throw std::runtime_error("Unknown line " + segment.line);
+    }
+
+    if (segment.from == segment.to) {
+      throw std::runtime_error("The closed segment of line " + segment.line +
+                               " starts and ends at " + segment.from);
+    }
+
+    const int from = findPosition(*line->second, segment.from);
+    const int to = findPosition(*line->second, segment.to);
+    closed_hops[segment.line].push_back(
+        {std::min(from, to), std::max(from, to)});
+  }
+
+  const leda::graph& g = _builder.getGraph();
+  const leda::node_map<string>& stations = _builder.getNodeNames();
+
+  edge_array<bool> closed_arcs(g, false);
+  edge e;
+  forall_edges(e, g) {
+    if (_builder.getArcTypes()[e] != RIDE_ARC) {
+      closed_arcs[e] = closure.stations.count(stations[source(e)]) > 0 ||
+                       closure.stations.count(stations[target(e)]) > 0;
+      continue;
+    }
+
+    // after preprocessing a ride arc can span several hops of its line
+    auto hops = closed_hops.find(_builder.getArcNames()[e]);
+    if (hops == closed_hops.end()) continue;
+
+    const int s = _builder.getNodePosition(source(e));
+    const int t = _builder.getNodePosition(target(e));
+    for (const pair<int, int>& hop : hops->second) {
+      if (std::min(s, t) < hop.second && hop.first < std::max(s, t)) {
+        closed_arcs[e] = true;
+      }
+    }
+  }
+
+  checkReachability(closed_arcs, closure.stations);
+
+  forall_edges(e, g) {
+    if (closed_arcs[e] != _closed_arcs[e]) {
+      _closed_arcs[e] = closed_arcs[e];
+      _solver.setArcEnabled(e, isArcEnabled(e, _closed_arcs));
+    }
+  }
+
+  const set<string> previous = _closure.stations;
+  _closure = closure;
+  for (const string& station : previous) {
+    updateStation(station);
+  }
+  for (const string& station : closure.stations) {
+    updateStation(station);
+  }
+}
+
+bool SolverSession::isArcEnabled(edge e,
+                                 const edge_array<bool>& closed_arcs) const {
+  if (closed_arcs[e]) return false;
+
+  return _builder.getArcTypes()[e] != RIDE_ARC ||
+         _disabled_lines.count(_builder.getArcNames()[e]) == 0;
+}
+
+/** Sets whether the station is required according to all restrictions. */
+void SolverSession::updateStation(const string& station) {
+  // stations removed by the preprocessing have no nodes, they are visited by
+  // riding past them, which checkReachability assures
+  if (_builder.getStationNodes().count(station) == 0) return;
+
+  _solver.setStationRequired(station, isRequired(station, _closure.stations));
+}
+
+bool SolverSession::isRequired(const string& station,
+                               const set<string>& closed_stations) const {
+  return _disabled_stations.count(station) == 0 &&
+         closed_stations.count(station) == 0;
+}
+
+/**
+ * Throws an exception if a station that has to be visited has no enabled arc
+ * coming from a different station. A station removed by the preprocessing
+ * must be passed by an enabled arc that has to be ridden to reach one of the
+ * required anchor stations of the arc, otherwise tours could skip it.
+ */
+void SolverSession::checkReachability(
+    const edge_array<bool>& closed_arcs,
+    const set<string>& closed_stations) const {
+  const leda::node_map<string>& stations = _builder.getNodeNames();
+
+  for (const auto& station : _builder.getStations()) {
+    if (!isRequired(station.first, closed_stations)) continue;
+
+    auto nodes = _builder.getStationNodes().find(station.first);
+    if (nodes == _builder.getStationNodes().end()) {
+      checkRemovedStation(station.first, closed_arcs, closed_stations);
+      continue;
+    }
+
+    bool reachable = false;
+    for (node n : nodes->second) {
+      edge e;
+      forall_in_edges(e, n) {
+        if (stations[source(e)] != station.first &&
+            isArcEnabled(e, closed_arcs)) {
+          reachable = true;
+        }
+      }
+    }
+
+    if (!reachable) {
+      throw std::runtime_error("Station " + station.first +
+                               " cannot be reached after the closure");
+    }
+  }
+}
+
+void SolverSession::checkRemovedStation(
+    const string& station, const edge_array<bool>& closed_arcs,
+    const set<string>& closed_stations) const {
+  auto stops = _builder.getRemovedStations().find(station);
+  if (stops == _builder.getRemovedStations().end()) return;
+
+  bool reachable = false;
+  bool visited = false;
+  for (const RemovedStop& stop : stops->second) {
+    if (!isArcEnabled(stop.arc, closed_arcs)) continue;
+
+    reachable = true;
+    for (const string& anchor : stop.anchors) {
+      if (isRequired(anchor, closed_stations)) visited = true;
+    }
+  }
+
+  if (!reachable) {
+    throw std::runtime_error("Station " + station +
+                             " cannot be reached after the closure");
+  }
+  if (!visited) {
+    throw std::runtime_error("Station " + station +
+                             " would be skipped after the closure");
+  }
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_SOLVER_SESSION_H_
+#define UBAHN_SOLVER_SOLVER_SESSION_H_
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/graph.h"
+#include "graph_builder.h"
+#include "solver/station_solver.h"
+#include "transport_defs.h"
+
+/** The part of a line between two of its stations. */
+struct LineSegment {
+  LineSegment() {}
+  LineSegment(const std::string& line, const std::string& from,
+              const std::string& to)
+      : line(line), from(from), to(to) {}
+
+  std::string line;
+  std::string from;
+  std::string to;
+};
+
+/**
+ * Stations and line segments that are closed, e.g. for construction works.
+ * Trains pass closed stations without stopping, so they do not have to be
+ * visited and changing or switching there is impossible. Closed segments
+ * cannot be ridden in either direction.
+ */
+struct Closure {
+  std::set<std::string> stations;
+  std::vector<LineSegment> segments;
+};
+
+/**
+ * A long-lived solver for repeated queries on one network. The graph and the
+ * CPLEX model are built once, changes only modify bounds and coefficients of
+ * the existing model. Subtour cuts and the last solution are kept between
+ * solves.
+ */
+class SolverSession {
+ public:
+  SolverSession(const t_stationmap& stations, const t_linemap& lines,
+                double change_cost, double switch_cost,
+                bool preprocess = true);
+
+  // disallow copy and assign
+  SolverSession(const SolverSession&) = delete;
+  void operator=(SolverSession) = delete;
+
+  const GraphBuilder& getBuilder() const { return _builder; }
+  const leda::graph& getGraph() { return _builder.getGraph(); }
+
+  double getArcCost(leda::edge e) const { return _cost[e]; }
+  void setArcCost(leda::edge e, double cost);
+  /** Replaces the costs of all arcs, only the objective is changed. */
+  void setArcCosts(const leda::edge_array<double>& costs);
+
+  /** Returns the arcs riding the given line, throws if it is unknown. */
+  const std::vector<leda::edge>& getLineArcs(const std::string& line) const;
+
+  /**
+   * Disabled stations do not need to be visited, but can be passed. Throws an
+   * exception if a station that must be visited can no longer be reached.
+   */
+  void setStationEnabled(const std::string& station, bool enabled);
+  /**
+   * The arcs of disabled lines cannot be used. Throws an exception if a
+   * station that must be visited can no longer be reached.
+   */
+  void setLineEnabled(const std::string& line, bool enabled);
+
+  /**
+   * Replaces the current closure. Only the bounds of the affected arcs and
+   * cover rows are changed. Throws an exception if the closure contains
+   * unknown stations, unknown or empty segments or if a station that must be
+   * visited can no longer be reached.
+   */
+  void setClosure(const Closure& closure);
+
+  void setWarmStart(bool warm_start) { _solver.setWarmStart(warm_start); }
+  void setVerbose(bool verbose) { _solver.setVerbose(verbose); }
+
+  /** Solves the current problem, throws an exception if that fails. */
+  void solve() { _solver.solve(); }
+
+  const std::list<leda::edge>& getSolutionTour() {
+    return _solver.getSolutionTour();
+  }
+  double getSolutionValue() { return _solver.getSolutionValue(); }
+  const SolverStatistics& getStatistics() const {
+    return _solver.getStatistics();
+  }
+
+ private:
+  GraphBuilder _builder;
+  StationSolver _solver;
+
+  bool isArcEnabled(leda::edge e,
+                    const leda::edge_array<bool>& closed_arcs) const;
+  void updateStation(const std::string& station);
+  bool isRequired(const std::string& station,
+                  const std::set<std::string>& closed_stations) const;
+  void checkReachability(const leda::edge_array<bool>& closed_arcs,
+                         const std::set<std::string>& closed_stations) const;
+  void checkRemovedStation(const std::string& station,
+                           const leda::edge_array<bool>& closed_arcs,
+                           const std::set<std::string>& closed_stations) const;
+
+  leda::edge_array<double> _cost;
+  std::map<std::string, std::vector<leda::edge>> _line_arcs;
+
+  std::set<std::string> _disabled_stations;
+  std::set<std::string> _disabled_lines;
+
+  Closure _closure;
+  leda::edge_array<bool> _closed_arcs;
+};
+
+#endif  // UBAHN_SOLVER_SOLVER_SESSION_H_
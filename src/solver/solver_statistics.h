@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_SOLVER_STATISTICS_H_
+#define UBAHN_SOLVER_SOLVER_STATISTICS_H_
+
+/** Statistics about the model and the search of the last call to solve(). */
+struct SolverStatistics {
+  SolverStatistics()
+      : variables(0),
+        rows(0),
+        lazy_cuts(0),
+        callback_calls(0),
+        nodes(0),
+        pooled_cuts(0),
+        seed_cuts(0),
+        duplicate_cuts(0),
+        purged_cuts(0),
+        max_lp_rows(0),
+        heuristic_calls(0),
+        repaired_tours(0),
+        improved_tours(0),
+        group_branches(0),
+        stolen_nodes(0) {}
+
+  int variables;        ///< number of columns of the model
+  int rows;             ///< number of rows of the model (without lazy cuts)
+  int lazy_cuts;        ///< number of cuts added by the lazy callback
+  int callback_calls;   ///< number of invocations of the lazy callback
+  long nodes;           ///< number of processed branch and bound nodes
+  int pooled_cuts;      ///< number of cuts of earlier solves added upfront
+  int seed_cuts;        ///< number of structural cuts added upfront
+  int duplicate_cuts;   ///< number of separated cuts that were already added
+  int purged_cuts;      ///< number of cuts forgotten for being inactive
+  int max_lp_rows;      ///< largest LP seen by the lazy callback
+  int heuristic_calls;  ///< number of LP solutions given to the repair
+  int repaired_tours;   ///< number of LP solutions repaired to tours
+  int improved_tours;   ///< number of repaired tours better than the incumbent
+  int group_branches;   ///< number of branches on a group instead of an arc
+  long stolen_nodes;    ///< number of nodes taken from another thread
+};
+
+#endif  // UBAHN_SOLVER_SOLVER_STATISTICS_H_
@@ -15,6 +15,7 @@
 #include "solver/station_solver.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <list>
 #include <map>
@@ -23,11 +24,11 @@
 #include <string>
 #include <vector>
 
-#include "LEDA/graph/graph_alg.h"
 #include "ilcplex/ilocplex.h"
 
 #include "base/utils.h"
 #include "solver/euler.h"
+#include "solver/structural_cuts.h"
 
 using LEDA::node_array;
 using LEDA::edge_array;
@@ -35,74 +36,149 @@ using LEDA::edge_map;
 
 ILOSTLBEGIN
 
-ILOLAZYCONSTRAINTCALLBACK1(StationLazyCallback, const StationSolver*, solver) {
+namespace {
+/// callbacks between the updates of the cut activity
+const long ACTIVITY_INTERVAL = 10;
+/// repaired tours must be this much cheaper than the incumbent
+const double IMPROVEMENT_TOLERANCE = 1e-6;
+}  // namespace
+
+ILOLAZYCONSTRAINTCALLBACK1(StationLazyCallback, StationSolver*, solver) {
   IloEnv masterEnv = getEnv();
 
   // get the current solution
   IloNumArray x(masterEnv);
   getValues(x, solver->getCplexVars());
 
-  // construct the graph G_x induced by the current (integral) solution x
-  leda::GRAPH<node, edge> Gx;
-  node_array<node> original_to_solution_graph;
-  solver->createNewSubgraph(x, Gx, original_to_solution_graph);
+  const leda::list<edge> selected = solver->getSelectedEdges(x);
 
   // we no longer need the actual solution
   x.end();
 
-  // find all connected components in (the undirected version) Gx
-  node_array<int> compnum(Gx, -1);
-  COMPONENTS(Gx, compnum);
+  vector<SubtourCut> cuts = solver->_separator->separate(selected);
 
-  // sort all components by the station ID they are in
-  vector<set<int>> components_per_station(solver->getNumberOfStations());
-  node n;
-  forall_nodes(n, Gx) {
-    assert(compnum[n] >= 0);
-
-    // get the station of the current node
-    const node original_node = Gx[n];
-    const int station_id = solver->getStation(original_node);
+  // the callbacks of parallel CPLEX threads share the state of the solver
+  std::lock_guard<std::mutex> lock(solver->_callback_mutex);
+  const long tick = ++solver->_statistics.callback_calls;
+  solver->recordLpSize(getNrows(), getCplexTime());
+  if (solver->_recorder) {
+    solver->_recorder->record(selected, cuts);
+  }
 
-    components_per_station[station_id].insert(compnum[n]);
+  cuts = solver->selectCuts(std::move(cuts), tick);
+  if (solver->_use_registry && tick % ACTIVITY_INTERVAL == 0) {
+    solver->updateCutActivity(selected, tick);
   }
 
-  // identify those components that have a station which they use exclusively
-  set<int> components_with_excl_station;
-  for (const set<int>& components : components_per_station) {
-    assert(!components.empty());
+  // purgeable cuts may be dropped by CPLEX when they are no longer binding
+  const IloCplex::CutManagement management =
+      solver->_purge_age > 0 ? IloCplex::UseCutPurge : IloCplex::UseCutForce;
 
-    if (components.size() == 1) {
-      const int component = getFirstElement(components);
-      components_with_excl_station.insert(component);
+  const bool deaggregated = solver->useDeaggregatedCuts(getBestObjValue());
+  for (const SubtourCut& cut : cuts) {
+    // create a cut for each exclusive component
+    if (deaggregated) {
+      IloExpr row_out(masterEnv);
+      IloExpr row_in(masterEnv);
+      solver->createDeaggregatedCut(cut, row_out, row_in);
+
+      add(row_out >= 1, management).end();
+      row_out.end();
+      add(row_in >= 1, management).end();
+      row_in.end();
+
+      solver->_statistics.lazy_cuts += 2;
+    } else {
+      // a tour leaves and enters the component at least once
+      IloExpr row(masterEnv);
+      solver->createAggregatedCut(cut, row);
+
+      add(row >= 2, management).end();
+      row.end();
+
+      solver->_statistics.lazy_cuts++;
+    }
+
+    if (solver->_keep_cuts) {
+      solver->_cut_pool.push_back(cut.nodes);
     }
   }
-  // we assumed, that the graph has at least one unique station
-  assert(components_with_excl_station.size() >= 1);
 
-  // cuts are only feasible, if C AND \neg{C} have an exclusive station
-  if (components_with_excl_station.size() == 1) {
-    // there is one tour visiting each station => feasible
+  return;
+}
+
+ILOHEURISTICCALLBACK1(StationHeuristicCallback, StationSolver*, solver) {
+  if (!solver->isHeuristicTurn()) return;
+
+  IloNumArray x(getEnv());
+  getValues(x, solver->getCplexVars());
+
+  // arcs fixed to zero in this subtree must not be used
+  const graph& g = solver->getGraph();
+  edge_array<double> values(g);
+  edge_array<bool> enabled(g);
+  edge e;
+  forall_edges(e, g) {
+    values[e] = x[solver->getCplexId(e)];
+    enabled[e] = getUB(solver->getCplexVar(e)) > 0.5;
+  }
+  x.end();
+
+  const vector<edge> tour = solver->_repair->repair(values, enabled);
+
+  double cost = 0.0;
+  for (edge t : tour) cost += solver->_dist[t];
+  const bool improved = !tour.empty() &&
+                        (!hasIncumbent() ||
+                         cost < getIncumbentObjValue() - IMPROVEMENT_TOLERANCE);
+
+  {
+    std::lock_guard<std::mutex> lock(solver->_callback_mutex);
+    solver->_statistics.heuristic_calls++;
+    if (!tour.empty()) solver->_statistics.repaired_tours++;
+    if (improved) solver->_statistics.improved_tours++;
+  }
+  if (!improved) return;
+
+  IloNumArray solution(getEnv(), solver->getCplexVars().getSize());
+  for (edge t : tour) solution[solver->getCplexId(t)] = 1.0;
+  setSolution(solver->getCplexVars(), solution, cost);
+  solution.end();
+}
+
+ILOBRANCHCALLBACK1(StationBranchCallback, StationSolver*, solver) {
+  // this callback replaces the one pruning by the shared incumbent
+  if (solver->canPrune(getObjValue())) {
+    prune();
     return;
   }
 
-  for (int comp : components_with_excl_station) {
-    // create a cut for each exclusive component
-    IloExpr row_out(masterEnv);
-    IloExpr row_in(masterEnv);
-    solver->createDeaggregatedCut(comp, original_to_solution_graph, compnum,
-                                  components_per_station, row_out, row_in);
+  IloNumArray x(getEnv());
+  getValues(x, solver->getCplexVars());
+  const int group = solver->selectBranchGroup(x);
+  x.end();
 
-    add(row_out >= 1).end();
-    row_out.end();
-    add(row_in >= 1).end();
-    row_in.end();
+  // without a fractional group, CPLEX branches on a single arc
+  if (group < 0) return;
+
+  IloExpr used(getEnv());
+  for (edge e : solver->_branch_groups[group]) {
+    used += solver->getCplexVar(e);
   }
+  makeBranch(used <= 0, getObjValue());
+  makeBranch(used >= 1, getObjValue());
+  used.end();
 
-  return;
+  std::lock_guard<std::mutex> lock(solver->_callback_mutex);
+  solver->_statistics.group_branches++;
 }
 
 namespace {
+/// weight of the earlier callbacks in the smoothed bound progress
+const double BOUND_SMOOTHING = 0.8;
+/// the adaptive policy deaggregates below this relative bound progress
+const double BOUND_STALL = 1e-4;
+
 /** Returns the number of edges leading comming from a different statation. */
 int countNonStationInEdges(const set<node>& station_nodes) {
   int result = 0;
@@ -119,84 +195,74 @@ int countNonStationInEdges(const set<node>& station_nodes) {
   return result;
 }
 
-/** Returns the first station, that can only be visited by a single line. */
-map<string, set<node>>::const_iterator findUniqueStation(
-    const map<string, set<node>>& stations) {
-  for (auto it = stations.begin(); it != stations.end(); ++it) {
-    if (countNonStationInEdges(it->second) == 1) {
-      return it;
+/** Returns the indices of all stations that can only be visited by a line. */
+vector<int> findUniqueStations(const map<string, set<node>>& stations) {
+  vector<int> unique_stations;
+
+  int station_id = 0;
+  for (const auto& station : stations) {
+    if (countNonStationInEdges(station.second) == 1) {
+      unique_stations.push_back(station_id);
     }
+    station_id++;
   }
 
-  return stations.end();
+  return unique_stations;
 }
 }  // namespace
 
-/**
- * Creates the cut including all those arcs either entering or leaving the
- * specified component.
- * As the components are only given on the solution graph the getComponent
- * function is used to derive components of the original graph.
- */
-void StationSolver::createAggregatedCut(
-    int comp, const node_array<node>& nodemap, const node_array<int>& compnum,
-    const vector<set<int>>& components_per_station, IloExpr& row) const {
-  edge e;
-  forall_edges(e, getGraph()) {
-    int comp_s =
-        getComponent(source(e), nodemap, compnum, components_per_station);
-    int comp_t =
-        getComponent(target(e), nodemap, compnum, components_per_station);
+CutPolicy parseCutPolicy(const string& name) {
+  if (name == "aggregated") return AGGREGATED_CUTS;
+  if (name == "deaggregated") return DEAGGREGATED_CUTS;
+  if (name == "adaptive") return ADAPTIVE_CUTS;
 
-    if ((comp_s == comp) ^ (comp_t == comp)) {
-      row += getCplexVar(e);
-    }
+  throw std::runtime_error("Unknown cut policy " + name);
+}
+
+const char* getCutPolicyName(CutPolicy policy) {
+  switch (policy) {
+    case AGGREGATED_CUTS:
+      return "aggregated";
+    case DEAGGREGATED_CUTS:
+      return "deaggregated";
+    case ADAPTIVE_CUTS:
+      return "adaptive";
   }
+  return "unknown";
 }
 
-/**
- * Creates two cuts including all those arcs entering the specified component
- * or leaving respectivly.
- * As the components are only given on the solution graph the getComponent
- * function is used to derive components of the original graph.
- */
-void StationSolver::createDeaggregatedCut(
-    int comp, const node_array<node>& nodemap, const node_array<int>& compnum,
-    const vector<set<int>>& components_per_station, IloExpr& row_out,
-    IloExpr& row_in) const {
-  edge e;
-  forall_edges(e, getGraph()) {
-    int comp_s =
-        getComponent(source(e), nodemap, compnum, components_per_station);
-    int comp_t =
-        getComponent(target(e), nodemap, compnum, components_per_station);
+SeedCuts parseSeedCuts(const string& name) {
+  if (name == "none") return NO_SEED_CUTS;
+  if (name == "lazy") return LAZY_SEED_CUTS;
+  if (name == "rows") return ROW_SEED_CUTS;
 
-    if ((comp_s == comp) && !(comp_t == comp)) {
-      row_out += getCplexVar(e);
-    }
-    if (!(comp_s == comp) && (comp_t == comp)) {
-      row_in += getCplexVar(e);
-    }
+  throw std::runtime_error("Unknown seed cut mode " + name);
+}
+
+/** Creates the cut including all those arcs either entering or leaving S. */
+void StationSolver::createAggregatedCut(const SubtourCut& cut,
+                                        IloExpr& row) const {
+  for (edge e : cut.out_arcs) {
+    row += getCplexVar(e);
+  }
+  for (edge e : cut.in_arcs) {
+    row += getCplexVar(e);
   }
 }
 
 /**
- * Returns the derived component number of a node n in the original graph.
- * If n is also included in the solution graph, use that component.
- * Otherwise return a component that also visits the station of n.
+ * Creates two cuts including all those arcs entering S or leaving S
+ * respectivly.
  */
-int StationSolver::getComponent(
-    node n, const node_array<node>& nodemap, const node_array<int>& compnum,
-    const vector<set<int>>& components_per_station) const {
-  node transformed = nodemap[n];
-  if (transformed) {
-    return compnum[transformed];
+void StationSolver::createDeaggregatedCut(const SubtourCut& cut,
+                                          IloExpr& row_out,
+                                          IloExpr& row_in) const {
+  for (edge e : cut.out_arcs) {
+    row_out += getCplexVar(e);
+  }
+  for (edge e : cut.in_arcs) {
+    row_in += getCplexVar(e);
   }
-
-  int station = getStation(n);
-
-  assert(!components_per_station[station].empty());
-  return getFirstElement(components_per_station[station]);
 }
 
 /**
@@ -222,30 +288,368 @@ leda::list<edge> StationSolver::getSelectedEdges(
 }
 
 /**
- * Creates the graph induced by the given solution.
- * The graph itself contains references to the original nodes/edges.
+ * Aggregated cuts keep the LP small, which pays off as long as the bound
+ * improves. Once the smoothed relative improvement per callback stalls, the
+ * adaptive policy switches to the stronger deaggregated cuts.
  */
-void StationSolver::createNewSubgraph(const IloNumArray& arc_vals,
-                                      leda::GRAPH<node, edge>& subgraph,
-                                      node_array<node>& nodemap) const {
-  leda::list<edge> selected_edges = getSelectedEdges(arc_vals);
+bool StationSolver::useDeaggregatedCuts(double bound) {
+  if (_cut_policy != ADAPTIVE_CUTS) {
+    return _cut_policy == DEAGGREGATED_CUTS;
+  }
 
-  // create a subgraph induced by the selected edges
-  CopyGraph(subgraph, getGraph(), selected_edges);
+  if (_has_bound) {
+    const double progress =
+        (bound - _last_bound) / std::max(1.0, std::fabs(bound));
+    _bound_progress = BOUND_SMOOTHING * _bound_progress +
+                      (1.0 - BOUND_SMOOTHING) * progress;
+  }
+  _has_bound = true;
+  _last_bound = bound;
 
-  // fill the node map, to map subgraph nodes to original
-  nodemap.init(getGraph(), nullptr);
-  node n;
-  forall_nodes(n, subgraph) { nodemap[subgraph[n]] = n; }
+  return _bound_progress < BOUND_STALL;
+}
+
+/**
+ * Returns the cuts that should be added for a candidate and registers them.
+ * Cuts that were added before are skipped, as long as other cuts reject the
+ * candidate. If all of them are known, they are no longer part of the LP,
+ * e.g. because CPLEX purged them, and are added again.
+ */
+vector<SubtourCut> StationSolver::selectCuts(vector<SubtourCut> cuts,
+                                             long tick) {
+  vector<CutRegistry::Signature> signatures;
+  if (_use_registry) {
+    vector<SubtourCut> unknown;
+    for (SubtourCut& cut : cuts) {
+      CutRegistry::Signature signature = CutRegistry::getSignature(cut.nodes);
+      if (_registry.contains(signature)) continue;
+
+      unknown.push_back(std::move(cut));
+      signatures.push_back(std::move(signature));
+    }
+
+    if (unknown.empty()) {
+      for (const SubtourCut& cut : cuts) {
+        signatures.push_back(CutRegistry::getSignature(cut.nodes));
+      }
+    } else {
+      _statistics.duplicate_cuts += cuts.size() - unknown.size();
+      cuts = std::move(unknown);
+    }
+  }
+
+  // the smallest components give the sparsest rows
+  if (_max_cuts > 0 && cuts.size() > _max_cuts) {
+    vector<int> order(cuts.size());
+    for (int i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return cuts[a].nodes.size() < cuts[b].nodes.size();
+    });
+    order.resize(_max_cuts);
+
+    vector<SubtourCut> smallest;
+    vector<CutRegistry::Signature> smallest_signatures;
+    for (int i : order) {
+      smallest.push_back(std::move(cuts[i]));
+      if (_use_registry) {
+        smallest_signatures.push_back(std::move(signatures[i]));
+      }
+    }
+    cuts = std::move(smallest);
+    signatures = std::move(smallest_signatures);
+  }
+
+  for (const CutRegistry::Signature& signature : signatures) {
+    _registry.insert(signature, tick);
+    _purged_cuts.erase(signature);
+  }
+
+  return cuts;
+}
+
+/** Marks the cuts that are tight for the candidate and purges old ones. */
+void StationSolver::updateCutActivity(const leda::list<edge>& selected,
+                                      long tick) {
+  _registry.markTight(selected, tick);
+  if (_purge_age <= 0) return;
+
+  for (CutRegistry::Signature& signature : _registry.purge(tick, _purge_age)) {
+    _purged_cuts.insert(std::move(signature));
+    _statistics.purged_cuts++;
+  }
+}
+
+void StationSolver::recordLpSize(int rows, double time) {
+  _statistics.max_lp_rows = std::max(_statistics.max_lp_rows, rows);
+
+  LpSample sample;
+  sample.callback_calls = _statistics.callback_calls;
+  sample.seconds = time - _solve_start;
+  sample.rows = rows;
+  _lp_trace.push_back(sample);
+}
+
+/**
+ * Returns whether the cut given by the node set S is valid for the current
+ * problem, i.e. whether there is a required station inside S and a required
+ * station outside of S.
+ */
+bool StationSolver::isValidCut(const vector<node>& cut_nodes) const {
+  vector<int> nodes_in_cut(_n_stations, 0);
+  for (node n : cut_nodes) {
+    nodes_in_cut[getStation(n)]++;
+  }
+
+  bool has_inside = false;
+  bool has_outside = false;
+  for (int station = 0; station < _n_stations; station++) {
+    if (!_separator->isRequired(station)) continue;
+
+    if (nodes_in_cut[station] == _station_sizes[station]) {
+      has_inside = true;
+    } else if (nodes_in_cut[station] == 0) {
+      has_outside = true;
+    }
+  }
+
+  return has_inside && has_outside;
+}
+
+/** Returns the cut of the node set with all arcs leaving and entering it. */
+SubtourCut StationSolver::getCrossingArcs(const vector<node>& cut_nodes) const {
+  SubtourCut cut;
+  cut.nodes = cut_nodes;
+
+  node_array<bool> in_cut(getGraph(), false);
+  for (node n : cut_nodes) in_cut[n] = true;
+
+  edge e;
+  forall_edges(e, getGraph()) {
+    if (in_cut[source(e)] && !in_cut[target(e)]) {
+      cut.out_arcs.push_back(e);
+    } else if (!in_cut[source(e)] && in_cut[target(e)]) {
+      cut.in_arcs.push_back(e);
+    }
+  }
+
+  return cut;
+}
+
+/**
+ * Adds all valid cuts as lazy constraints to the model. Returns the number
+ * of added constraints.
+ */
+int StationSolver::injectCuts(const vector<vector<node>>& cuts) {
+  IloEnv env = getCplexEnv();
+  IloConstraintArray constraints(env);
+  for (const vector<node>& cut_nodes : cuts) {
+    if (!isValidCut(cut_nodes)) continue;
+
+    const SubtourCut cut = getCrossingArcs(cut_nodes);
+    if (_use_registry) {
+      _registry.insert(CutRegistry::getSignature(cut_nodes), 0);
+    }
+
+    if (_cut_policy == AGGREGATED_CUTS) {
+      IloExpr row(env);
+      createAggregatedCut(cut, row);
+      constraints.add(row >= 2);
+      row.end();
+    } else {
+      IloExpr row_out(env);
+      IloExpr row_in(env);
+      createDeaggregatedCut(cut, row_out, row_in);
+      constraints.add(row_out >= 1);
+      constraints.add(row_in >= 1);
+      row_out.end();
+      row_in.end();
+    }
+  }
+
+  const int n_constraints = constraints.getSize();
+  if (n_constraints > 0) {
+    getCplex()->addLazyConstraints(constraints);
+  }
+  constraints.end();
+
+  return n_constraints;
+}
+
+/**
+ * Activates the rows of the seed cuts that are valid for the required
+ * stations and deactivates all others. Returns the number of active rows.
+ */
+int StationSolver::updateSeedRows() {
+  int active = 0;
+  for (size_t i = 0; i < _structural_cuts.size(); i++) {
+    const bool enabled =
+        _seed_cuts == ROW_SEED_CUTS && isValidCut(_structural_cuts[i]);
+    _seed_rows[2 * i].setLB(enabled ? 1.0 : 0.0);
+    _seed_rows[2 * i + 1].setLB(enabled ? 1.0 : 0.0);
+    if (enabled) active += 2;
+  }
+
+  return active;
+}
+
+void StationSolver::setSeedCuts(SeedCuts seed_cuts) {
+  _seed_cuts = seed_cuts;
+  if (seed_cuts == NO_SEED_CUTS || _has_seed_rows) return;
+
+  _structural_cuts =
+      findStructuralCuts(getGraph(), _node_to_station_id, _n_stations);
+
+  // the rows are always part of the model, invalid ones have a bound of 0
+  IloEnv env = getCplexEnv();
+  _seed_rows = IloRangeArray(env);
+  for (const vector<node>& cut_nodes : _structural_cuts) {
+    const SubtourCut cut = getCrossingArcs(cut_nodes);
+    IloExpr row_out(env);
+    IloExpr row_in(env);
+    createDeaggregatedCut(cut, row_out, row_in);
+    _seed_rows.add(IloRange(env, 0.0, row_out, IloInfinity));
+    _seed_rows.add(IloRange(env, 0.0, row_in, IloInfinity));
+    row_out.end();
+    row_in.end();
+  }
+  getCplexModel()->add(_seed_rows);
+  _has_seed_rows = true;
+}
+
+/**
+ * Returns the group of arcs whose sum in the LP solution is closest to one
+ * half while below one, or -1 if no group is fractional. Either branch cuts
+ * off the solution then.
+ */
+int StationSolver::selectBranchGroup(const IloNumArray& vals) const {
+  int best = -1;
+  double best_score = getEpInt();
+  for (int i = 0; i < _branch_groups.size(); i++) {
+    double sum = 0.0;
+    for (edge e : _branch_groups[i]) {
+      sum += vals[getCplexId(e)];
+    }
+
+    const double score = std::min(sum, 1.0 - sum);
+    if (score > best_score) {
+      best = i;
+      best_score = score;
+    }
+  }
+
+  return best;
+}
+
+void StationSolver::setBranchPriorities(const edge_array<double>& priorities) {
+  IloNumArray values(getCplexEnv(), getCplexVars().getSize());
+
+  edge e;
+  forall_edges(e, getGraph()) { values[getCplexId(e)] = priorities[e]; }
+
+  getCplex()->setPriorities(getCplexVars(), values);
+  values.end();
+}
+
+bool StationSolver::isHeuristicTurn() {
+  std::lock_guard<std::mutex> lock(_callback_mutex);
+  return _heuristic_frequency > 0 &&
+         ++_heuristic_ticks % _heuristic_frequency == 0;
 }
 
 void StationSolver::solve() {
-  CplexSolver::solve(true, StationLazyCallback(getCplexEnv(), this));
+  const bool has_unique_station =
+      std::any_of(_unique_stations.begin(), _unique_stations.end(),
+                  [this](int s) { return _separator->isRequired(s); });
+  if (!has_unique_station) {
+    throw std::runtime_error(
+        "Invalid input: Optimality can only be guaranteed, if at least one "
+        "required station is unique");
+  }
+
+  _registry.clear();
+  _purged_cuts.clear();
+  _lp_trace.clear();
+  _solve_start = getCplex()->getCplexTime();
+
+  // lazy constraints of earlier solves may no longer be valid
+  getCplex()->clearLazyConstraints();
+  const int pooled_cuts = _keep_cuts ? injectCuts(_cut_pool) : 0;
+
+  int seed_cuts = 0;
+  if (_has_seed_rows) {
+    seed_cuts = updateSeedRows();
+  }
+  if (_seed_cuts == LAZY_SEED_CUTS) {
+    seed_cuts = injectCuts(_structural_cuts);
+  }
+
+  // every solve starts with a progressing bound
+  _has_bound = false;
+  _last_bound = 0.0;
+  _bound_progress = 1.0;
+
+  vector<IloCplex::Callback> callbacks = {
+      StationLazyCallback(getCplexEnv(), this)};
+  if (_heuristic_frequency > 0) {
+    callbacks.push_back(StationHeuristicCallback(getCplexEnv(), this));
+  }
+  if (!_branch_groups.empty()) {
+    callbacks.push_back(StationBranchCallback(getCplexEnv(), this));
+  }
+  _heuristic_ticks = 0;
+
+  CplexSolver::solve(callbacks);
+  _statistics.pooled_cuts = pooled_cuts;
+  _statistics.seed_cuts = seed_cuts;
+
+  // purged cuts were inactive for long, the next solve starts without them
+  if (_keep_cuts && !_purged_cuts.empty()) {
+    auto purged = [this](const vector<node>& cut_nodes) {
+      return _purged_cuts.count(CutRegistry::getSignature(cut_nodes)) > 0;
+    };
+    _cut_pool.erase(
+        std::remove_if(_cut_pool.begin(), _cut_pool.end(), purged),
+        _cut_pool.end());
+  }
+}
+
+void StationSolver::setArcCosts(const edge_array<double>& costs) {
+  IloNumArray coefs(getCplexEnv(), getCplexVars().getSize());
+
+  edge e;
+  forall_edges(e, getGraph()) {
+    coefs[getCplexId(e)] = costs[e];
+    _dist[e] = costs[e];
+  }
+
+  _objective.setLinearCoefs(getCplexVars(), coefs);
+  coefs.end();
+}
+
+void StationSolver::setStationRequired(const string& station, bool required) {
+  auto pos = _station_ids.find(station);
+  if (pos == _station_ids.end()) {
+    throw std::runtime_error("Unknown station " + station);
+  }
+
+  _station_cons[pos->second].setLB(required ? 1.0 : 0.0);
+  _separator->setRequired(pos->second, required);
+  _repair->setRequired(pos->second, required);
+}
+
+void StationSolver::setSeparationRecorder(const string& file) {
+  if (file.empty()) {
+    _recorder.reset();
+  } else {
+    _recorder.reset(new SeparationRecorder(file, getGraph(),
+                                           _node_to_station_id, _n_stations));
+  }
 }
 
 /** Initializes structures for the station infos and checks for valid input. */
 void StationSolver::initializeStations(const map<string, set<node>>& stations) {
-  if (findUniqueStation(stations) == stations.end()) {
+  _unique_stations = findUniqueStations(stations);
+  if (_unique_stations.empty()) {
     throw std::runtime_error(
         "Invalid input: Optimality can only be guaranteed, if the graph "
         "contains at least one unique station");
@@ -258,6 +662,9 @@ void StationSolver::initializeStations(const map<string, set<node>>& stations) {
 
   _n_stations = 0;
   for (const auto& station : stations) {
+    _station_ids[station.first] = _n_stations;
+    _station_sizes.push_back(station.second.size());
+
     for (node n : station.second) {
       if (contains(nodes_in_stations, n)) {
         ostringstream errBuf;
@@ -276,6 +683,11 @@ void StationSolver::initializeStations(const map<string, set<node>>& stations) {
     throw runtime_error(
         "Invalid input: Not all nodes are assigned to stations");
   }
+
+  _separator.reset(
+      new SubtourSeparator(graph, _node_to_station_id, _n_stations));
+  _repair.reset(
+      new TourRepair(graph, _node_to_station_id, _n_stations, _dist));
 }
 
 /** Creates the actual MIP model. */
@@ -285,8 +697,8 @@ void StationSolver::createCplexModel(
     const edge_array<bool>& connection_arcs) {
   IloEnv env = getCplexEnv();
 
-  IloObjective obj = IloMinimize(env);
-  getCplexModel()->add(obj);
+  _objective = IloMinimize(env);
+  getCplexModel()->add(_objective);
 
   int n_nodes = 0;
   node_array<int> node_to_constraint_id(getGraph(), -1);
@@ -313,7 +725,8 @@ void StationSolver::createCplexModel(
 
     // the arc variable has its distance as the cost and must fulfill the in/out
     // degree constraints
-    IloBoolVar var(obj(dist[e]) + in_out_cons[node_to_constraint_id[s]](-1) +
+    IloBoolVar var(_objective(dist[e]) +
+                       in_out_cons[node_to_constraint_id[s]](-1) +
                        in_out_cons[node_to_constraint_id[t]](1),
                    name.str().c_str());
 
@@ -324,7 +737,7 @@ void StationSolver::createCplexModel(
   in_out_cons.end();
 
   // (2) we create the constraints, that every station is visited at least once
-  IloRangeArray out_cons = IloRangeArray(env);
+  _station_cons = IloRangeArray(env);
 
   int cluster_id = 0;
   for (auto& station : station_names) {
@@ -349,9 +762,8 @@ void StationSolver::createCplexModel(
     name << "cl#" << cluster_id++;
     IloRange constr(env, 1.0, lhs, IloInfinity, name.str().c_str());
 
-    out_cons.add(constr);
+    _station_cons.add(constr);
     lhs.end();
   }
-  getCplexModel()->add(out_cons);
-  out_cons.end();
+  getCplexModel()->add(_station_cons);
 }
@@ -19,14 +19,49 @@
 
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "ilcplex/ilocplex.h"
 
 #include "base/graph.h"
 #include "solver/cplex_solver.h"
+#include "solver/cut_registry.h"
+#include "solver/separation_recorder.h"
+#include "solver/subtour_separator.h"
+#include "solver/tour_repair.h"
+
+/** How the subtour cuts of a component are added to the model. */
+enum CutPolicy {
+  AGGREGATED_CUTS,    ///< one row over all arcs leaving or entering it
+  DEAGGREGATED_CUTS,  ///< one row for the leaving and one for the entering
+  ADAPTIVE_CUTS       ///< aggregated while the bound improves, else both
+};
+
+/** Returns the policy with the given name, throws an exception if unknown. */
+CutPolicy parseCutPolicy(const std::string& name);
+const char* getCutPolicyName(CutPolicy policy);
+
+/** How the cuts derived from the structure of the network are used. */
+enum SeedCuts {
+  NO_SEED_CUTS,    ///< they are found by the lazy callback when needed
+  LAZY_SEED_CUTS,  ///< added as lazy constraints before each solve
+  ROW_SEED_CUTS    ///< added as rows of the model
+};
+
+/** Returns the mode with the given name, throws an exception if unknown. */
+SeedCuts parseSeedCuts(const std::string& name);
+
+/** The size of the LP when the lazy callback was called. */
+struct LpSample {
+  long callback_calls;
+  double seconds;  ///< since the start of the solve
+  int rows;
+};
 
 class StationSolver : public CplexSolver {
  public:
@@ -41,7 +76,30 @@ class StationSolver : public CplexSolver {
   StationSolver(const leda::graph& graph, const leda::edge_array<double>& dist,
                 const std::map<std::string, std::set<leda::node>>& stations,
                 const leda::edge_array<bool>& connection_arcs)
-      : CplexSolver(graph) {
+      : StationSolver(graph, dist, stations, connection_arcs,
+                      std::unique_ptr<CplexEnvironment>(
+                          new CplexEnvironment())) {}
+
+  /** Initializes the solver in an environment that was created in advance. */
+  StationSolver(const leda::graph& graph, const leda::edge_array<double>& dist,
+                const std::map<std::string, std::set<leda::node>>& stations,
+                const leda::edge_array<bool>& connection_arcs,
+                std::unique_ptr<CplexEnvironment> environment)
+      : CplexSolver(graph, std::move(environment)),
+        _dist(dist),
+        _cut_policy(DEAGGREGATED_CUTS),
+        _max_cuts(0),
+        _has_bound(false),
+        _last_bound(0.0),
+        _bound_progress(1.0),
+        _use_registry(true),
+        _purge_age(0),
+        _solve_start(0.0),
+        _seed_cuts(NO_SEED_CUTS),
+        _has_seed_rows(false),
+        _heuristic_frequency(0),
+        _heuristic_ticks(0),
+        _keep_cuts(false) {
     initializeStations(stations);
     createCplexModel(dist, stations, connection_arcs);
   }
@@ -53,6 +111,112 @@ class StationSolver : public CplexSolver {
   /** Solves the given problem, throws an exception if something goes wrong */
   void solve();
 
+  /** Sets the cost of the arc in the objective. */
+  void setArcCost(leda::edge e, double cost) {
+    _objective.setLinearCoef(getCplexVar(e), cost);
+    _dist[e] = cost;
+  }
+
+  /** Sets the costs of all arcs in the objective at once. */
+  void setArcCosts(const leda::edge_array<double>& costs);
+
+  /** Disabled arcs must not be used by the tour. */
+  void setArcEnabled(leda::edge e, bool enabled) {
+    getCplexVar(e).setUB(enabled ? 1.0 : 0.0);
+  }
+
+  /**
+   * Sets whether the station must be visited. Throws an exception if the
+   * station is unknown.
+   */
+  void setStationRequired(const std::string& station, bool required);
+
+  /** Sets how subtour cuts are added, the default is DEAGGREGATED_CUTS. */
+  void setCutPolicy(CutPolicy policy) { _cut_policy = policy; }
+
+  /**
+   * Limits the number of components cut off by one callback, the smallest
+   * ones are preferred. 0 means no limit, which is the default.
+   */
+  void setMaxCutsPerCallback(int max_cuts) { _max_cuts = max_cuts; }
+
+  /**
+   * Enables or disables skipping cuts that were already added during the
+   * solve. This is enabled by default.
+   */
+  void setCutRegistry(bool use_registry) { _use_registry = use_registry; }
+
+  /**
+   * Lets CPLEX purge subtour cuts that are no longer binding. Cuts that were
+   * neither separated again nor tight for a candidate during the last
+   * max_age callbacks are forgotten, also by the kept cuts. Requires the cut
+   * registry, 0 disables purging, which is the default.
+   */
+  void setCutPurge(int max_age) { _purge_age = max_age; }
+
+  /**
+   * Sets how the cuts found by findStructuralCuts are used. They are only
+   * computed when first enabled, the default is NO_SEED_CUTS.
+   */
+  void setSeedCuts(SeedCuts seed_cuts);
+
+  /**
+   * Repairs the LP solution into a tour at every frequency-th call of the
+   * heuristic callback and offers it to CPLEX, if it is better than the
+   * incumbent. 0 disables the repair, which is the default.
+   */
+  void setHeuristicFrequency(int frequency) {
+    _heuristic_frequency = frequency;
+  }
+
+  /**
+   * Sets the branching priority of every arc, CPLEX branches on the arcs with
+   * the highest priority first. See getBranchPriorities().
+   */
+  void setBranchPriorities(const leda::edge_array<double>& priorities);
+
+  /**
+   * Branches on whether a tour uses any arc of a group instead of single
+   * arcs, e.g. on whether it visits a station via a line, see
+   * getStationLineGroups(). The group whose LP value is most fractional below
+   * one is chosen, without one CPLEX branches as usual. No groups disable the
+   * callback, which is the default.
+   */
+  void setBranchGroups(std::vector<std::vector<leda::edge>> groups) {
+    _branch_groups = std::move(groups);
+  }
+
+  /** Returns the size of the LP at each callback of the last solve. */
+  const std::vector<LpSample>& getLpTrace() const { return _lp_trace; }
+
+  /**
+   * Enables or disables keeping the subtour cuts found during a solve. The
+   * kept cuts that are still valid are added to each following solve.
+   */
+  void setKeepCuts(bool keep_cuts) {
+    _keep_cuts = keep_cuts;
+    if (!keep_cuts) _cut_pool.clear();
+  }
+
+  /** Returns the node sets of all kept cuts. */
+  const std::vector<std::vector<leda::node>>& getKeptCuts() const {
+    return _cut_pool;
+  }
+
+  /**
+   * Adds cuts, given by their node sets, to the kept cuts. Invalid cuts are
+   * ignored when the next solve starts.
+   */
+  void addKeptCuts(const std::vector<std::vector<leda::node>>& cuts) {
+    _cut_pool.insert(_cut_pool.end(), cuts.begin(), cuts.end());
+  }
+
+  /**
+   * Records every separation of the following solve calls to the given file.
+   * An empty file name disables the recording.
+   */
+  void setSeparationRecorder(const std::string& file);
+
  private:
   void initializeStations(
       const std::map<std::string, std::set<leda::node>>& stations);
@@ -62,23 +226,26 @@ class StationSolver : public CplexSolver {
       const leda::edge_array<bool>& connection_arcs);
 
   leda::list<leda::edge> getSelectedEdges(const IloNumArray& vals) const;
-  void createNewSubgraph(const IloNumArray& arc_vals,
-                         leda::GRAPH<leda::node, leda::edge>& subgraph,
-                         leda::node_array<leda::node>& nodemap) const;
-  int getComponent(
-      leda::node n, const leda::node_array<leda::node>& nodemap,
-      const leda::node_array<int>& compnum,
-      const std::vector<std::set<int>>& components_per_station) const;
-  void createAggregatedCut(
-      int comp, const leda::node_array<node>& nodemap,
-      const leda::node_array<int>& compnum,
-      const std::vector<std::set<int>>& components_per_station,
-      IloExpr& row) const;
-  void createDeaggregatedCut(
-      int comp, const leda::node_array<node>& nodemap,
-      const leda::node_array<int>& compnum,
-      const std::vector<std::set<int>>& components_per_station,
-      IloExpr& row_out, IloExpr& row_in) const;
+  void createAggregatedCut(const SubtourCut& cut, IloExpr& row) const;
+  void createDeaggregatedCut(const SubtourCut& cut, IloExpr& row_out,
+                             IloExpr& row_in) const;
+
+  std::vector<SubtourCut> selectCuts(std::vector<SubtourCut> cuts, long tick);
+  void updateCutActivity(const leda::list<leda::edge>& selected, long tick);
+  void recordLpSize(int rows, double time);
+
+  /** Decides the form of the next cuts given the current global bound. */
+  bool useDeaggregatedCuts(double bound);
+
+  bool isValidCut(const std::vector<leda::node>& cut_nodes) const;
+  SubtourCut getCrossingArcs(const std::vector<leda::node>& cut_nodes) const;
+  int injectCuts(const std::vector<std::vector<leda::node>>& cuts);
+  int updateSeedRows();
+
+  /** Returns whether the heuristic callback should repair the solution. */
+  bool isHeuristicTurn();
+
+  int selectBranchGroup(const IloNumArray& vals) const;
 
   int getNumberOfStations() const { return _n_stations; }
 
@@ -87,8 +254,61 @@ class StationSolver : public CplexSolver {
   leda::node_array<int> _node_to_station_id;
   int _n_stations;
 
+  std::map<std::string, int> _station_ids;
+  std::vector<int> _station_sizes;
+  std::vector<int> _unique_stations;
+
+  /// the current arc costs, as in the objective
+  leda::edge_array<double> _dist;
+
+  IloObjective _objective;
+  IloRangeArray _station_cons;
+
+  CutPolicy _cut_policy;
+  int _max_cuts;
+
+  /// the progress of the bound observed by the adaptive policy
+  bool _has_bound;
+  double _last_bound;
+  double _bound_progress;
+
+  /// the cuts added during the current solve
+  bool _use_registry;
+  int _purge_age;
+  CutRegistry _registry;
+  std::set<CutRegistry::Signature> _purged_cuts;
+
+  double _solve_start;
+  std::vector<LpSample> _lp_trace;
+
+  /// the cuts derived from the structure, only rows of valid ones are active
+  SeedCuts _seed_cuts;
+  std::vector<std::vector<leda::node>> _structural_cuts;
+  bool _has_seed_rows;
+  IloRangeArray _seed_rows;
+
+  /// the primal heuristic and its calls during the current solve
+  int _heuristic_frequency;
+  long _heuristic_ticks;
+  std::unique_ptr<TourRepair> _repair;
+
+  /// the arc sets the branch callback branches on
+  std::vector<std::vector<leda::edge>> _branch_groups;
+
+  /// guards the state used by the callback
+  std::mutex _callback_mutex;
+
+  /// the node sets of all cuts of earlier solves
+  bool _keep_cuts;
+  std::vector<std::vector<leda::node>> _cut_pool;
+
+  std::unique_ptr<SubtourSeparator> _separator;
+  std::unique_ptr<SeparationRecorder> _recorder;
+
   // the dynamic constrained generation method should have access to private
   friend class StationLazyCallbackI;
+  friend class StationHeuristicCallbackI;
+  friend class StationBranchCallbackI;
 };
 
 #endif  // UBAHN_SOLVER_STATION_SOLVER_H_
@@ -0,0 +1,159 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/structural_cuts.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+using leda::node_array;
+using std::vector;
+
+namespace {
+
+/** The depth first search tree of a connected undirected graph. */
+struct SearchTree {
+  vector<int> preorder;  ///< the vertices in the order of their discovery
+  vector<int> index;     ///< the position of each vertex in preorder
+  vector<int> size;      ///< the number of vertices in the subtree of each
+  vector<int> parent;
+  vector<int> low;       ///< the lowest index reachable by one back edge
+};
+
+/** Runs an iterative DFS, so that long lines do not exhaust the stack. */
+SearchTree search(const vector<vector<int>>& adjacent, int root) {
+  const int n = adjacent.size();
+  SearchTree tree;
+  tree.index.assign(n, -1);
+  tree.size.assign(n, 1);
+  tree.parent.assign(n, -1);
+  tree.low.assign(n, 0);
+
+  // vertices on the current path and the next neighbor to look at
+  vector<std::pair<int, size_t>> stack;
+  tree.index[root] = 0;
+  tree.low[root] = 0;
+  tree.preorder.push_back(root);
+  stack.emplace_back(root, 0);
+
+  while (!stack.empty()) {
+    const int v = stack.back().first;
+    size_t& next = stack.back().second;
+
+    if (next < adjacent[v].size()) {
+      const int w = adjacent[v][next++];
+      if (tree.index[w] < 0) {
+        tree.index[w] = tree.low[w] = tree.preorder.size();
+        tree.parent[w] = v;
+        tree.preorder.push_back(w);
+        stack.emplace_back(w, 0);
+      } else if (w != tree.parent[v]) {
+        tree.low[v] = std::min(tree.low[v], tree.index[w]);
+      }
+    } else {
+      stack.pop_back();
+      const int p = tree.parent[v];
+      if (p >= 0) {
+        tree.low[p] = std::min(tree.low[p], tree.low[v]);
+        tree.size[p] += tree.size[v];
+      }
+    }
+  }
+
+  return tree;
+}
+
+/** Returns the stations of the subtree of v. */
+vector<int> getSubtree(const SearchTree& tree, int v) {
+  const auto begin = tree.preorder.begin() + tree.index[v];
+  return vector<int>(begin, begin + tree.size[v]);
+}
+}  // namespace
+
+vector<vector<node>> findStructuralCuts(const graph& g,
+                                        const node_array<int>& station_ids,
+                                        int n_stations) {
+  vector<vector<int>> adjacent(n_stations);
+  vector<vector<node>> station_nodes(n_stations);
+  node n;
+  forall_nodes(n, g) { station_nodes[station_ids[n]].push_back(n); }
+
+  edge e;
+  forall_edges(e, g) {
+    const int s = station_ids[source(e)];
+    const int t = station_ids[target(e)];
+    if (s != t) {
+      adjacent[s].push_back(t);
+      adjacent[t].push_back(s);
+    }
+  }
+  for (vector<int>& neighbors : adjacent) {
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()),
+                    neighbors.end());
+  }
+
+  if (n_stations == 0) return vector<vector<node>>();
+  const SearchTree tree = search(adjacent, 0);
+  const size_t station_count = adjacent.size();
+
+  // a disconnected network has no tour at all
+  if (tree.preorder.size() != station_count) return vector<vector<node>>();
+
+  std::set<vector<int>> parts;
+  auto addPart = [&](vector<int> part) {
+    if (part.size() < 2 || part.size() + 1 >= station_count) return;
+    std::sort(part.begin(), part.end());
+    parts.insert(part);
+  };
+
+  for (int v = 0; v < n_stations; v++) {
+    // the children whose subtrees are only connected through v
+    vector<int> separated;
+    for (int w : adjacent[v]) {
+      if (tree.parent[w] == v && tree.low[w] >= tree.index[v]) {
+        separated.push_back(w);
+      }
+    }
+    // the root separates its subtrees only if it has more than one
+    if (tree.parent[v] < 0 && separated.size() < 2) continue;
+    if (separated.empty()) continue;
+
+    vector<int> with_v(1, v);
+    for (int w : separated) {
+      const vector<int> subtree = getSubtree(tree, w);
+      addPart(subtree);
+      with_v.insert(with_v.end(), subtree.begin(), subtree.end());
+    }
+
+    // the stations above v are separated from v and the parts below
+    if (tree.parent[v] >= 0) {
+      addPart(with_v);
+    }
+  }
+
+  vector<vector<node>> cuts;
+  for (const vector<int>& part : parts) {
+    vector<node> nodes;
+    for (int station : part) {
+      nodes.insert(nodes.end(), station_nodes[station].begin(),
+                   station_nodes[station].end());
+    }
+    cuts.push_back(nodes);
+  }
+
+  return cuts;
+}
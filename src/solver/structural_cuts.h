@@ -0,0 +1,40 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_STRUCTURAL_CUTS_H_
+#define UBAHN_SOLVER_STRUCTURAL_CUTS_H_
+
+#include <vector>
+
+#include "base/graph.h"
+
+/**
+ * Returns the node sets of subtour cuts that follow from the structure of the
+ * network alone. In the undirected station graph, removing an articulation
+ * station splits the network into parts, e.g. the stations beyond a bridge or
+ * those only served by a pendant line. A tour visiting all stations has to
+ * enter and leave each of these parts. Parts of a single station and parts
+ * containing all but one station are omitted, their cuts are implied by the
+ * station constraints. Every node set consists of whole stations.
+ * @param graph problem graph
+ * @param station_ids maps each node to the id of its station
+ * @param n_stations number of stations
+ */
+std::vector<std::vector<leda::node>> findStructuralCuts(
+    const leda::graph& graph, const leda::node_array<int>& station_ids,
+    int n_stations);
+
+#endif  // UBAHN_SOLVER_STRUCTURAL_CUTS_H_
@@ -0,0 +1,119 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/subtour_separator.h"
+
+#include <set>
+#include <vector>
+
+#include "LEDA/graph/graph_alg.h"
+
+#include "base/utils.h"
+
+using leda::node_array;
+using std::set;
+using std::vector;
+
+namespace {
+
+/** Returns the cut of the component or -1, if there is none. */
+int getCut(const vector<int>& comp_to_cut, int comp) {
+  return comp >= 0 ? comp_to_cut[comp] : -1;
+}
+}  // namespace
+
+vector<SubtourCut> SubtourSeparator::separate(
+    const leda::list<edge>& selected) const {
+  // construct the graph G_x induced by the current (integral) solution x
+  leda::GRAPH<node, edge> Gx;
+  CopyGraph(Gx, _g, selected);
+
+  // find all connected components in (the undirected version) Gx
+  node_array<int> compnum(Gx, -1);
+  const int n_components = COMPONENTS(Gx, compnum);
+
+  // sort all components by the station ID they are in
+  vector<set<int>> components_per_station(_n_stations);
+  node_array<int> component(_g, -1);
+  node n;
+  forall_nodes(n, Gx) {
+    assert(compnum[n] >= 0);
+
+    const node original_node = Gx[n];
+    component[original_node] = compnum[n];
+    components_per_station[_station_ids[original_node]].insert(compnum[n]);
+  }
+
+  // identify those components that have a required station which they use
+  // exclusively
+  vector<int> comp_to_cut(n_components, -1);
+  int n_cuts = 0;
+  for (int station = 0; station < _n_stations; station++) {
+    if (!_required[station]) continue;
+
+    const set<int>& components = components_per_station[station];
+    assert(!components.empty());
+
+    if (components.size() == 1) {
+      const int comp = getFirstElement(components);
+      if (comp_to_cut[comp] < 0) {
+        comp_to_cut[comp] = n_cuts++;
+      }
+    }
+  }
+  // cuts are only feasible, if C AND \neg{C} have an exclusive station
+  if (n_cuts <= 1) {
+    // there is one tour visiting each station => feasible
+    return vector<SubtourCut>();
+  }
+
+  // a node that is not contained in Gx is assigned to a component that also
+  // visits the station of that node, nodes of unvisited stations remain
+  // without a component
+  forall_nodes(n, _g) {
+    if (component[n] < 0) {
+      const set<int>& components = components_per_station[_station_ids[n]];
+      if (!components.empty()) {
+        component[n] = getFirstElement(components);
+      }
+    }
+  }
+
+  vector<SubtourCut> cuts(n_cuts);
+  forall_nodes(n, _g) {
+    const int cut = getCut(comp_to_cut, component[n]);
+    if (cut >= 0) {
+      cuts[cut].nodes.push_back(n);
+    }
+  }
+
+  // a single pass over all arcs collects the arcs crossing each cut
+  edge e;
+  forall_edges(e, _g) {
+    const int comp_s = component[source(e)];
+    const int comp_t = component[target(e)];
+    if (comp_s == comp_t) continue;
+
+    const int cut_s = getCut(comp_to_cut, comp_s);
+    if (cut_s >= 0) {
+      cuts[cut_s].out_arcs.push_back(e);
+    }
+    const int cut_t = getCut(comp_to_cut, comp_t);
+    if (cut_t >= 0) {
+      cuts[cut_t].in_arcs.push_back(e);
+    }
+  }
+
+  return cuts;
+}
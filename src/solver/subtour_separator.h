@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_SUBTOUR_SEPARATOR_H_
+#define UBAHN_SOLVER_SUBTOUR_SEPARATOR_H_
+
+#include <vector>
+
+#include "base/graph.h"
+
+/**
+ * A subtour elimination cut given by the node set S of a component. Every
+ * tour has to leave and to enter S at least once.
+ */
+struct SubtourCut {
+  std::vector<leda::node> nodes;     ///< the nodes of S
+  std::vector<leda::edge> out_arcs;  ///< all arcs leaving S
+  std::vector<leda::edge> in_arcs;   ///< all arcs entering S
+};
+
+/**
+ * The separation of the subtour elimination constraints for the station
+ * problem. It does not depend on CPLEX, so that it can also be used offline.
+ */
+class SubtourSeparator {
+ public:
+  /**
+   * @param graph problem graph
+   * @param station_ids maps each node to the id of its station
+   * @param n_stations number of stations
+   */
+  SubtourSeparator(const leda::graph& graph,
+                   const leda::node_array<int>& station_ids, int n_stations)
+      : _g(graph),
+        _station_ids(station_ids),
+        _n_stations(n_stations),
+        _required(n_stations, true) {}
+
+  // disallow copy and assign
+  SubtourSeparator(const SubtourSeparator&) = delete;
+  void operator=(SubtourSeparator) = delete;
+
+  /**
+   * Sets whether the station must be visited. Only required stations are
+   * used to identify components that have to be connected.
+   */
+  void setRequired(int station, bool required) {
+    _required[station] = required;
+  }
+  bool isRequired(int station) const { return _required[station]; }
+
+  /**
+   * Returns a cut for every component of the solution graph that visits a
+   * required station exclusively. If the solution is a single tour, no cuts are
+   * returned.
+   * @param selected arcs of an integral solution
+   */
+  std::vector<SubtourCut> separate(
+      const leda::list<leda::edge>& selected) const;
+
+ private:
+  const leda::graph& _g;
+  const leda::node_array<int>& _station_ids;
+  const int _n_stations;
+
+  std::vector<bool> _required;
+};
+
+#endif  // UBAHN_SOLVER_SUBTOUR_SEPARATOR_H_
@@ -0,0 +1,275 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "solver/tour_repair.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+using leda::edge_array;
+using leda::node_array;
+using std::vector;
+
+namespace {
+/// arcs with at least this LP value are part of the initial selection
+const double ROUNDING_THRESHOLD = 0.5;
+}  // namespace
+
+vector<edge> TourRepair::repair(const edge_array<double>& values,
+                                const edge_array<bool>& enabled) const {
+  edge_array<bool> used(_g, false);
+  edge e;
+  forall_edges(e, _g) {
+    used[e] = enabled[e] && values[e] >= ROUNDING_THRESHOLD;
+  }
+
+  vector<edge> tour;
+  if (!connect(enabled, &used)) return tour;
+
+  forall_edges(e, _g) {
+    if (used[e]) tour.push_back(e);
+  }
+  return tour;
+}
+
+/**
+ * Adds shortest paths from every node with more entering than leaving arcs to
+ * the nodes with more leaving arcs, until the selection is Eulerian. As every
+ * arc can only be used once, a path may also run backwards along selected
+ * arcs that are not kept, removing them, but only if there is no other way.
+ * Returns false if a path is missing.
+ */
+bool TourRepair::balance(const edge_array<bool>& enabled,
+                         const edge_array<bool>& kept,
+                         edge_array<bool>* used) const {
+  // the number of entering minus the number of leaving arcs
+  node_array<int> excess(_g, 0);
+  edge e;
+  forall_edges(e, _g) {
+    if ((*used)[e]) {
+      excess[target(e)]++;
+      excess[source(e)]--;
+    }
+  }
+
+  auto has_deficit = [&excess](node n, edge) { return excess[n] < 0; };
+
+  // any path of new arcs is cheaper than removing a single one
+  double removal_cost = 1.0;
+  forall_edges(e, _g) { removal_cost += std::max(0.0, _costs[e]); }
+
+  node n;
+  forall_nodes(n, _g) {
+    while (excess[n] > 0) {
+      node end;
+      const vector<edge> path = findShortestPath(
+          {n}, has_deficit, enabled, *used, kept, removal_cost, &end);
+      if (path.empty()) return false;
+
+      for (edge p : path) (*used)[p] = !(*used)[p];
+      excess[n]--;
+      excess[end]++;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Joins the required stations to the component with the most arcs by adding
+ * the shortest path to the closest missing station, or out of a missing
+ * station the tour passes without leaving it, the way back is added by
+ * balancing. Without any arcs, the tour starts at the first required station.
+ * Components that are not needed are dropped. Returns false if a station
+ * cannot be reached.
+ */
+bool TourRepair::connect(const edge_array<bool>& enabled,
+                         edge_array<bool>* used) const {
+  // the path joining the last station must not be undone by the way back
+  edge_array<bool> joined(_g, false);
+
+  // every iteration joins at least one more required station
+  for (int iteration = 0; iteration <= _n_stations + 1; iteration++) {
+    if (!balance(enabled, joined, used)) return false;
+
+    // label the weakly connected components of the selected arcs
+    node_array<int> component(_g, -1);
+    vector<int> component_arcs;
+    node n;
+    forall_nodes(n, _g) {
+      if (component[n] >= 0) continue;
+
+      const int id = component_arcs.size();
+      int arcs = 0;
+      vector<node> stack = {n};
+      component[n] = id;
+      while (!stack.empty()) {
+        const node v = stack.back();
+        stack.pop_back();
+
+        edge e;
+        forall_out_edges(e, v) {
+          if (!(*used)[e]) continue;
+          arcs++;
+          if (component[target(e)] < 0) {
+            component[target(e)] = id;
+            stack.push_back(target(e));
+          }
+        }
+        forall_in_edges(e, v) {
+          if ((*used)[e] && component[source(e)] < 0) {
+            component[source(e)] = id;
+            stack.push_back(source(e));
+          }
+        }
+      }
+      component_arcs.push_back(arcs);
+    }
+
+    const int largest =
+        std::max_element(component_arcs.begin(), component_arcs.end()) -
+        component_arcs.begin();
+    const bool empty = component_arcs[largest] == 0;
+
+    // a station is visited, if the tour leaves it
+    vector<bool> visited(_n_stations, false);
+    edge e;
+    forall_edges(e, _g) {
+      if ((*used)[e] && !empty && component[source(e)] == largest &&
+          _station_ids[source(e)] != _station_ids[target(e)]) {
+        visited[_station_ids[source(e)]] = true;
+      }
+    }
+
+    int first_missing = -1;
+    vector<bool> missing(_n_stations, false);
+    for (int station = 0; station < _n_stations; station++) {
+      missing[station] = _required[station] && !visited[station];
+      if (missing[station] && first_missing < 0) first_missing = station;
+    }
+    if (empty && first_missing < 0) return false;
+
+    // other components are only worth joining for their missing stations
+    vector<bool> keep(component_arcs.size(), false);
+    keep[largest] = true;
+    forall_nodes(n, _g) {
+      if (missing[_station_ids[n]]) keep[component[n]] = true;
+    }
+    forall_edges(e, _g) {
+      if (!keep[component[source(e)]]) (*used)[e] = false;
+    }
+
+    if (first_missing < 0) return true;
+
+    // if no unused arc leads back to the start of the path, balancing
+    // reroutes the tour around it
+    node_array<bool> in_tour(_g, false);
+    vector<node> tour_nodes;
+    forall_nodes(n, _g) {
+      in_tour[n] = empty ? _station_ids[n] == first_missing
+                         : component[n] == largest;
+      if (in_tour[n]) tour_nodes.push_back(n);
+    }
+    // e.g. after preprocessing, the tour may only switch the direction at a
+    // terminal, which does not count as leaving its station
+    auto joins_missing = [&](node m, edge last) {
+      const int from = _station_ids[source(last)];
+      return (missing[_station_ids[m]] && !in_tour[m]) ||
+             (missing[from] && from != _station_ids[m]);
+    };
+    node end;
+    const vector<edge> path =
+        findShortestPath(tour_nodes, joins_missing, enabled, *used, joined,
+                         std::numeric_limits<double>::infinity(), &end);
+    if (path.empty()) return false;
+
+    joined.init(_g, false);
+    for (edge p : path) {
+      (*used)[p] = true;
+      joined[p] = true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Returns the cheapest path of enabled, unused arcs from one of the sources
+ * to a target, or an empty path if there is none. Targets are decided by the
+ * node and the last arc of the path to it. With a finite removal cost the
+ * path may also run backwards along used arcs that are not kept at that cost.
+ * The target is stored in end.
+ */
+vector<edge> TourRepair::findShortestPath(
+    const vector<node>& sources,
+    const std::function<bool(node, edge)>& is_target,
+    const edge_array<bool>& enabled, const edge_array<bool>& used,
+    const edge_array<bool>& kept, double removal_cost, node* end) const {
+  node_array<double> dist(_g, std::numeric_limits<double>::infinity());
+  node_array<edge> pred(_g, nullptr);
+
+  typedef std::pair<double, node> Entry;
+  std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> queue;
+  for (node s : sources) {
+    dist[s] = 0.0;
+    queue.push(Entry(0.0, s));
+  }
+
+  while (!queue.empty()) {
+    const Entry top = queue.top();
+    queue.pop();
+
+    const node v = top.second;
+    if (top.first > dist[v]) continue;
+
+    // the sources themselves are never a target
+    if (pred[v] && is_target(v, pred[v])) {
+      vector<edge> path;
+      for (node w = v; pred[w]; w = _g.opposite(w, pred[w])) {
+        path.push_back(pred[w]);
+      }
+      std::reverse(path.begin(), path.end());
+      *end = v;
+      return path;
+    }
+
+    auto relax = [&](edge e, node w, double cost) {
+      const double d = dist[v] + cost;
+      if (d < dist[w]) {
+        dist[w] = d;
+        pred[w] = e;
+        queue.push(Entry(d, w));
+      }
+    };
+
+    // negative costs would break the search
+    edge e;
+    forall_out_edges(e, v) {
+      if (enabled[e] && !used[e]) {
+        relax(e, target(e), std::max(0.0, _costs[e]));
+      }
+    }
+    if (removal_cost < std::numeric_limits<double>::infinity()) {
+      forall_in_edges(e, v) {
+        if (used[e] && !kept[e]) relax(e, source(e), removal_cost);
+      }
+    }
+  }
+
+  return vector<edge>();
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_SOLVER_TOUR_REPAIR_H_
+#define UBAHN_SOLVER_TOUR_REPAIR_H_
+
+#include <functional>
+#include <vector>
+
+#include "base/graph.h"
+
+/**
+ * Turns fractional arc values of an LP solution into a tour of the station
+ * problem. The arcs with a value of at least one half are selected, nodes
+ * with more entering than leaving arcs are balanced by shortest paths, and
+ * the required stations the largest component misses are joined by shortest
+ * cycles. Without any selected arcs, this builds a tour from scratch. Every
+ * arc is used at most once, as in the model. It does not depend on CPLEX, so
+ * that it can also be used offline.
+ */
+class TourRepair {
+ public:
+  /**
+   * @param graph problem graph
+   * @param station_ids maps each node to the id of its station
+   * @param n_stations number of stations
+   * @param costs the cost of every arc, they may change between repairs
+   */
+  TourRepair(const leda::graph& graph, const leda::node_array<int>& station_ids,
+             int n_stations, const leda::edge_array<double>& costs)
+      : _g(graph),
+        _station_ids(station_ids),
+        _n_stations(n_stations),
+        _costs(costs),
+        _required(n_stations, true) {}
+
+  // disallow copy and assign
+  TourRepair(const TourRepair&) = delete;
+  void operator=(TourRepair) = delete;
+
+  /** Sets whether the tour must visit the station. */
+  void setRequired(int station, bool required) {
+    _required[station] = required;
+  }
+
+  /**
+   * Returns the arcs of a tour close to the given solution, or an empty list
+   * if it cannot be repaired.
+   * @param values the value of every arc in the LP solution
+   * @param enabled whether the tour may use the arc
+   */
+  std::vector<leda::edge> repair(const leda::edge_array<double>& values,
+                                 const leda::edge_array<bool>& enabled) const;
+
+ private:
+  bool balance(const leda::edge_array<bool>& enabled,
+               const leda::edge_array<bool>& kept,
+               leda::edge_array<bool>* used) const;
+  bool connect(const leda::edge_array<bool>& enabled,
+               leda::edge_array<bool>* used) const;
+
+  std::vector<leda::edge> findShortestPath(
+      const std::vector<leda::node>& sources,
+      const std::function<bool(leda::node, leda::edge)>& is_target,
+      const leda::edge_array<bool>& enabled,
+      const leda::edge_array<bool>& used, const leda::edge_array<bool>& kept,
+      double removal_cost, leda::node* end) const;
+
+  const leda::graph& _g;
+  const leda::node_array<int>& _station_ids;
+  const int _n_stations;
+  const leda::edge_array<double>& _costs;
+
+  std::vector<bool> _required;
+};
+
+#endif  // UBAHN_SOLVER_TOUR_REPAIR_H_
@@ -0,0 +1,91 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/scenario_tool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+void printUsage(const char* name, const string& kind, const string& format) {
+  cerr << "Usage: " << name << " [options] network.xml " << kind << "s.txt"
+       << endl
+       << "Options:" << endl
+       << "  --threads N  number of parallel sessions (default: number of "
+          "cores)"
+       << endl
+       << "  --tours      also print the tour of every scenario" << endl
+       << format << endl;
+}
+}  // namespace
+
+int runScenarioTool(int argc, char* args[], const string& kind,
+                    const string& format, ScenarioSolver solve) {
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  bool print_tours = false;
+  vector<string> files;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--tours") {
+        print_tours = true;
+      } else if (arg == "--threads" && i + 1 < argc) {
+        threads = boost::lexical_cast<int>(args[++i]);
+      } else if (arg.compare(0, 2, "--") == 0) {
+        throw std::runtime_error("Unknown option " + arg);
+      } else {
+        files.push_back(arg);
+      }
+    }
+    if (files.size() != 2) {
+      throw std::runtime_error("Expected a network and a " + kind + " file");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0], kind, format);
+    return 1;
+  }
+
+  vector<ScenarioResult> results;
+  try {
+    XMLReader reader;
+    reader.readTransportFile(files[0]);
+
+    std::ifstream in(files[1]);
+    if (!in) {
+      throw std::runtime_error("Cannot open " + kind + " file " + files[1]);
+    }
+    results = solve(reader, in, threads);
+  } catch (const std::runtime_error& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  return reportScenarioResults(results, print_tours, cout);
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_TOOLS_SCENARIO_TOOL_H_
+#define UBAHN_TOOLS_SCENARIO_TOOL_H_
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "io/xml_reader.h"
+#include "solver/scenario_runner.h"
+
+/**
+ * Reads the scenarios from the stream and solves them on the network with
+ * the given number of threads. Throws an exception on invalid input.
+ */
+typedef std::function<std::vector<ScenarioResult>(
+    const XMLReader& network, std::istream& scenarios, int threads)>
+    ScenarioSolver;
+
+/**
+ * The main function of the tools that solve a file of scenarios on one
+ * network: "[--threads N] [--tours] network.xml scenarios". The kind names
+ * the scenario file in messages, the format is appended to the usage.
+ */
+int runScenarioTool(int argc, char* args[], const std::string& kind,
+                    const std::string& format, ScenarioSolver solve);
+
+#endif  // UBAHN_TOOLS_SCENARIO_TOOL_H_
@@ -0,0 +1,136 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "solver/batch_runner.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options] manifest.txt" << endl
+       << "Options:" << endl
+       << "  --cores N        number of cores shared by all jobs (default: "
+          "number of cores)"
+       << endl
+       << "  --job-threads N  CPLEX threads of jobs without a threads option"
+          " (default: 1)"
+       << endl
+       << "  --output FILE    write the results to FILE instead of stdout"
+       << endl
+       << "Each line of the manifest has the format" << endl
+       << "  file [name=NAME] [change=COST] [switch=COST] "
+          "[type=station|segment]"
+       << endl
+       << "       [preprocess=on|off] [time_limit=SECONDS] [threads=N]" << endl
+       << "Relative files are resolved against the directory of the manifest."
+       << endl;
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  int cores = std::max(1u, std::thread::hardware_concurrency());
+  int job_threads = 1;
+  string output_file;
+  string manifest;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--cores" && i + 1 < argc) {
+        cores = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--job-threads" && i + 1 < argc) {
+        job_threads = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--output" && i + 1 < argc) {
+        output_file = args[++i];
+      } else if (arg.compare(0, 2, "--") == 0 || !manifest.empty()) {
+        throw std::runtime_error("Unknown argument " + arg);
+      } else {
+        manifest = arg;
+      }
+    }
+    if (manifest.empty()) {
+      throw std::runtime_error("Expected a manifest file");
+    }
+    if (cores < 1 || job_threads < 1) {
+      throw std::runtime_error("The number of cores and threads must be >= 1");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  vector<BatchJob> jobs;
+  try {
+    std::ifstream in(manifest);
+    if (!in) {
+      throw std::runtime_error("Cannot open manifest " + manifest);
+    }
+    jobs = readBatchJobs(in);
+  } catch (const std::runtime_error& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  const size_t slash = manifest.rfind('/');
+  if (slash != string::npos) {
+    for (BatchJob& job : jobs) {
+      if (job.file[0] != '/') {
+        job.file = manifest.substr(0, slash + 1) + job.file;
+      }
+    }
+  }
+
+  std::unique_ptr<std::ofstream> output;
+  if (!output_file.empty()) {
+    output.reset(new std::ofstream(output_file));
+    if (!*output) {
+      cerr << "Error: Cannot open " << output_file << endl;
+      return 1;
+    }
+  }
+  std::ostream& O = output ? *output : cout;
+
+  // each line is flushed, so that the results can be followed while running
+  int failed = 0;
+  BatchRunner runner(cores, job_threads);
+  runner.run(jobs, [&](const BatchResult& result) {
+    writeJsonLine(result, O);
+    if (!result.solved) {
+      failed++;
+      cerr << "Job " << result.job << " (" << result.name
+           << ") failed: " << result.error << endl;
+    }
+  });
+
+  cerr << jobs.size() - failed << " of " << jobs.size() << " jobs solved"
+       << endl;
+  return failed > 0 ? 1 : 0;
+}
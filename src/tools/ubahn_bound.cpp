@@ -0,0 +1,182 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/graph.h"
+#include "graph_builder.h"
+#include "io/xml_reader.h"
+#include "solver/branch_and_bound.h"
+#include "solver/euler.h"
+#include "solver/lagrangian_bound.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options] network.xml ..." << endl
+       << "Options:" << endl
+       << "  --iterations N   maximum number of subgradient steps (default: "
+          "200)"
+       << endl
+       << "  --time-limit MS  stop after MS milliseconds (default: none)"
+       << endl
+       << "  --gap G          stop once the relative gap is below G "
+          "(default: 0.001)"
+       << endl
+       << "  --change C       cost of changing the line (default: 5)" << endl
+       << "  --switch S       cost of switching the direction (default: 5)"
+       << endl
+       << "  --raw            do not preprocess the graph" << endl
+       << "  --exact          solve to optimality by branch and bound" << endl
+       << "  --threads N      threads of the branch and bound (default: "
+          "number of cores)"
+       << endl
+       << "  --tour           also print the best tour" << endl;
+}
+
+/** Solves the network by branch and bound and prints the result. */
+void solveExact(const GraphBuilder& builder,
+                const leda::node_array<int>& station_ids, int n_stations,
+                int threads, double time_limit, bool print_tour) {
+  BranchAndBound solver(builder.getGraph(), station_ids, n_stations,
+                        builder.getDist());
+  solver.setThreads(threads);
+  solver.setTimeLimit(time_limit);
+  solver.solve();
+
+  const SolverStatistics& statistics = solver.getStatistics();
+  if (solver.isOptimal()) {
+    cout << "optimal tour " << solver.getSolutionValue();
+  } else {
+    cout << "lower bound " << solver.getLowerBound();
+    if (statistics.improved_tours > 0) {
+      cout << ", tour " << solver.getSolutionValue();
+    }
+  }
+  cout << " (" << statistics.nodes << " nodes, " << statistics.stolen_nodes
+       << " stolen, " << solver.getTime() * 1000.0 << " ms)" << endl;
+
+  if (print_tour && statistics.improved_tours > 0) {
+    builder.printTour(solver.getSolutionTour());
+  }
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  int iterations = 200;
+  double time_limit = 0.0;
+  double gap = 1e-3;
+  double change_cost = 5.0;
+  double switch_cost = 5.0;
+  bool preprocess = true;
+  bool exact = false;
+  int threads = 0;
+  bool print_tour = false;
+  vector<string> files;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--raw") {
+        preprocess = false;
+      } else if (arg == "--exact") {
+        exact = true;
+      } else if (arg == "--tour") {
+        print_tour = true;
+      } else if (arg == "--threads" && i + 1 < argc) {
+        threads = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--iterations" && i + 1 < argc) {
+        iterations = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--time-limit" && i + 1 < argc) {
+        time_limit = boost::lexical_cast<double>(args[++i]);
+      } else if (arg == "--gap" && i + 1 < argc) {
+        gap = boost::lexical_cast<double>(args[++i]);
+      } else if (arg == "--change" && i + 1 < argc) {
+        change_cost = boost::lexical_cast<double>(args[++i]);
+      } else if (arg == "--switch" && i + 1 < argc) {
+        switch_cost = boost::lexical_cast<double>(args[++i]);
+      } else if (arg.compare(0, 2, "--") == 0) {
+        throw std::runtime_error("Unknown option " + arg);
+      } else {
+        files.push_back(arg);
+      }
+    }
+    if (files.empty()) {
+      throw std::runtime_error("Expected at least one network");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  int status = 0;
+  for (const string& file : files) {
+    try {
+      XMLReader reader;
+      reader.readTransportFile(file);
+
+      GraphBuilder builder(reader.getStations(), reader.getLines(),
+                           change_cost, switch_cost, STATION, preprocess);
+      leda::node_array<int> station_ids;
+      const int n_stations = builder.getStationIds(&station_ids);
+
+      if (exact) {
+        cout << file << ": ";
+        solveExact(builder, station_ids, n_stations, threads, time_limit,
+                   print_tour);
+        continue;
+      }
+
+      LagrangianBound bound(builder.getGraph(), station_ids, n_stations,
+                            builder.getDist());
+      bound.setIterationLimit(iterations);
+      bound.setTimeLimit(time_limit);
+      bound.setGap(gap);
+      const BoundResult result = bound.compute();
+
+      cout << file << ": lower bound " << result.lower_bound;
+      if (result.tour.empty()) {
+        cout << ", no tour found";
+      } else {
+        cout << ", tour " << result.upper_bound << ", gap "
+             << 100.0 * (result.upper_bound - result.lower_bound) /
+                    result.upper_bound
+             << "%";
+      }
+      cout << " (" << result.iterations << " steps, " << result.ms << " ms)"
+           << endl;
+
+      if (print_tour && !result.tour.empty()) {
+        builder.printTour(buildEulerTour(builder.getGraph(), result.tour));
+      }
+    } catch (const std::runtime_error& e) {
+      cerr << file << ": Error: " << e.what() << endl;
+      status = 1;
+    }
+  }
+
+  return status;
+}
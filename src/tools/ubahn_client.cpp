@@ -0,0 +1,115 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "base/timer.h"
+#include "daemon/protocol.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options] socket command [field ...]" << endl
+       << "Options:" << endl
+       << "  --repeat N  send the request N times and report the latency "
+          "(default: 1)"
+       << endl
+       << "  --quiet     do not print the response" << endl
+       << "Examples:" << endl
+       << "  " << name << " /tmp/ubahn.sock solve network=bvg.xml" << endl
+       << "  " << name
+       << " /tmp/ubahn.sock whatif network=bvg.xml \"station=Kottbusser Tor\""
+       << endl;
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  int repeat = 1;
+  bool quiet = false;
+  vector<string> positional;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--repeat" && i + 1 < argc) {
+        repeat = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--quiet") {
+        quiet = true;
+      } else if (arg.compare(0, 2, "--") == 0) {
+        throw std::runtime_error("Unknown option " + arg);
+      } else {
+        positional.push_back(arg);
+      }
+    }
+    if (positional.size() < 2 || repeat < 1) {
+      throw std::runtime_error("Expected a socket and a command");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  // the fields of a request are separated by tabs
+  string request = positional[1];
+  for (size_t i = 2; i < positional.size(); i++) {
+    request += '\t' + positional[i];
+  }
+
+  vector<double> latencies;
+  string response;
+  try {
+    const int fd = connectUnixSocket(positional[0]);
+    for (int i = 0; i < repeat; i++) {
+      Timer timer;
+      writeMessage(fd, request);
+      if (!readMessage(fd, &response)) {
+        throw std::runtime_error("Connection closed by the daemon");
+      }
+      latencies.push_back(
+          timer.Elapsed<std::chrono::duration<double, std::milli>>().count());
+    }
+    close(fd);
+  } catch (const std::runtime_error& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  if (!quiet) {
+    cout << response << endl;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  cerr << "latency over " << repeat << " requests: min "
+       << latencies.front() << " ms, median "
+       << latencies[latencies.size() / 2] << " ms, max " << latencies.back()
+       << " ms" << endl;
+
+  return response.find("\"status\": \"ok\"") == string::npos ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "daemon/solver_daemon.h"
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const int DEFAULT_MAX_CONNECTIONS = 64;
+const int DEFAULT_MAX_NETWORKS = 8;
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options] socket" << endl
+       << "Options:" << endl
+       << "  --workers N          number of parallel solves (default: number "
+          "of cores)"
+       << endl
+       << "  --queue N            requests that may wait for a worker before "
+          "clients get"
+       << endl
+       << "                       a busy response (default: 2 * workers)"
+       << endl
+       << "  --max-connections N  number of open connections (default: "
+       << DEFAULT_MAX_CONNECTIONS << ")" << endl
+       << "  --max-networks N     networks kept in memory (default: "
+       << DEFAULT_MAX_NETWORKS << ")" << endl
+       << "  --preload FILE       read the network and build a session before "
+          "serving"
+       << endl;
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  int workers = std::max(1u, std::thread::hardware_concurrency());
+  int queue_size = 0;
+  int max_connections = DEFAULT_MAX_CONNECTIONS;
+  int max_networks = DEFAULT_MAX_NETWORKS;
+  vector<string> preload;
+  string socket_path;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--workers" && i + 1 < argc) {
+        workers = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--queue" && i + 1 < argc) {
+        queue_size = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--max-connections" && i + 1 < argc) {
+        max_connections = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--max-networks" && i + 1 < argc) {
+        max_networks = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--preload" && i + 1 < argc) {
+        preload.push_back(args[++i]);
+      } else if (arg.compare(0, 2, "--") == 0 || !socket_path.empty()) {
+        throw std::runtime_error("Unknown argument " + arg);
+      } else {
+        socket_path = arg;
+      }
+    }
+    if (socket_path.empty()) {
+      throw std::runtime_error("Expected a socket path");
+    }
+    if (workers < 1 || queue_size < 0 || max_connections < 1 ||
+        max_networks < 1) {
+      throw std::runtime_error(
+          "Invalid worker, queue, connection or network limit");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  if (queue_size == 0) {
+    queue_size = 2 * workers;
+  }
+
+  SolverDaemon daemon(workers, queue_size, max_connections);
+  daemon.setMaxNetworks(max_networks);
+  try {
+    for (const string& file : preload) {
+      DaemonRequest request;
+      request.network = file;
+      daemon.preload(request);
+      cerr << "Preloaded " << file << endl;
+    }
+
+    cerr << "Listening on " << socket_path << " with " << workers
+         << " workers" << endl;
+    daemon.serve(socket_path);
+  } catch (const std::runtime_error& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
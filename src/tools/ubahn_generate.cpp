@@ -0,0 +1,155 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "generator/network_generator.h"
+#include "io/xml_writer.h"
+#include "transport_network.h"
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace {
+
+void printUsage(const char* name, std::ostream& out) {
+  out << "Usage: " << name << " [options]" << endl
+      << "Options:" << endl
+      << "  --layout L            grid, radial or multi (default grid)" << endl
+      << "  --stations N          number of stations (default 100)" << endl
+      << "  --lines N             number of lines (default 10)" << endl
+      << "  --cities N            number of cities of the multi layout "
+         "(default 3)"
+      << endl
+      << "  --transfer-density D  fraction of line crossings with a transfer "
+         "station (default 0.5)"
+      << endl
+      << "  --terminal-loops P    probability that a terminal continues to "
+         "another line (default 0)"
+      << endl
+      << "  --times DIST          uniform:MIN:MAX, normal:MEAN:DEV, "
+         "exponential:MEAN or"
+      << endl
+      << "                        distance:MINUTES_PER_UNIT (default "
+         "uniform:1:3)"
+      << endl
+      << "  --seed S              random seed (default 1)" << endl
+      << "  --output FILE         write to FILE instead of stdout" << endl;
+}
+
+void parseTimes(const string& spec, GeneratorConfig* config) {
+  std::vector<string> parts;
+  size_t start = 0;
+  for (size_t pos; (pos = spec.find(':', start)) != string::npos;
+       start = pos + 1) {
+    parts.push_back(spec.substr(start, pos - start));
+  }
+  parts.push_back(spec.substr(start));
+
+  const string& name = parts[0];
+  size_t n_params;
+  if (name == "uniform") {
+    config->times = UNIFORM_TIMES;
+    n_params = 2;
+  } else if (name == "normal") {
+    config->times = NORMAL_TIMES;
+    n_params = 2;
+  } else if (name == "exponential") {
+    config->times = EXPONENTIAL_TIMES;
+    n_params = 1;
+  } else if (name == "distance") {
+    config->times = DISTANCE_TIMES;
+    n_params = 1;
+  } else {
+    throw std::runtime_error("Unknown travel time distribution " + name);
+  }
+
+  if (parts.size() != n_params + 1) {
+    throw std::runtime_error("Invalid parameters for distribution " + name);
+  }
+  config->time_a = boost::lexical_cast<double>(parts[1]);
+  if (n_params > 1) {
+    config->time_b = boost::lexical_cast<double>(parts[2]);
+  }
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  GeneratorConfig config;
+  string output;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--help" || arg == "-h") {
+        printUsage(args[0], std::cout);
+        return 0;
+      }
+      if (i + 1 >= argc) {
+        throw std::runtime_error("Missing value for option " + arg);
+      }
+
+      const string value = args[++i];
+      if (arg == "--layout") {
+        config.layout = parseLayout(value);
+      } else if (arg == "--stations") {
+        config.stations = boost::lexical_cast<int>(value);
+      } else if (arg == "--lines") {
+        config.lines = boost::lexical_cast<int>(value);
+      } else if (arg == "--cities") {
+        config.cities = boost::lexical_cast<int>(value);
+      } else if (arg == "--transfer-density") {
+        config.transfer_density = boost::lexical_cast<double>(value);
+      } else if (arg == "--terminal-loops") {
+        config.terminal_loops = boost::lexical_cast<double>(value);
+      } else if (arg == "--times") {
+        parseTimes(value, &config);
+      } else if (arg == "--seed") {
+        config.seed = boost::lexical_cast<uint32_t>(value);
+      } else if (arg == "--output") {
+        output = value;
+      } else {
+        throw std::runtime_error("Unknown option " + arg);
+      }
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0], cerr);
+    return 1;
+  }
+
+  try {
+    TransportNetwork network;
+    NetworkGenerator generator(config);
+    generator.generate(&network);
+
+    if (output.empty()) {
+      writeTransportFile(network.getStations(), network.getLines(), std::cout);
+    } else {
+      writeTransportFile(network.getStations(), network.getLines(), output);
+    }
+  } catch (const std::runtime_error& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,34 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <vector>
+
+#include "io/xml_reader.h"
+#include "solver/scenario_runner.h"
+#include "tools/scenario_tool.h"
+
+using std::vector;
+
+int main(int argc, char* args[]) {
+  return runScenarioTool(
+      argc, args, "scenario",
+      "Each line of the scenario file has the format\n"
+      "  name change_cost switch_cost [ride_factor] [line=factor ...]",
+      [](const XMLReader& network, std::istream& in, int threads) {
+        const vector<CostScenario> scenarios = readScenarios(in);
+        ScenarioRunner runner(network.getStations(), network.getLines());
+        return runner.run(scenarios, threads);
+      });
+}
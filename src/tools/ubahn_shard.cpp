@@ -0,0 +1,199 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
+
+#include "daemon/sharding.h"
+#include "io/xml_reader.h"
+#include "solver/scenario_runner.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char DEFAULT_BIND[] = "127.0.0.1";
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " coordinate [options] network.xml "
+       << "scenarios.txt" << endl
+       << "       " << name << " worker HOST:PORT" << endl
+       << "Options:" << endl
+       << "  --bind ADDR    address to listen on, 0.0.0.0 for all interfaces "
+          "(default: "
+       << DEFAULT_BIND << ")" << endl
+       << "  --port P       port to listen on (default: any free port)" << endl
+       << "  --spawn N      start N local workers" << endl
+       << "  --speculate F  duplicate scenarios running F times longer than "
+          "the median (default: 3, 0 disables)"
+       << endl
+       << "  --raw          do not preprocess the graph" << endl
+       << "  --tours        also print the tour of every scenario" << endl;
+}
+
+/** Starts a worker process of this executable connecting to the port. */
+pid_t spawnWorker(const string& bind, int port) {
+  // local workers reach a coordinator listening on all interfaces via loopback
+  const string host = bind == "0.0.0.0" || bind == "::" ? "localhost" : bind;
+  const string address = host + ":" + std::to_string(port);
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    throw std::runtime_error("Cannot start a worker process");
+  }
+  if (pid == 0) {
+    execl("/proc/self/exe", "ubahn_shard", "worker", address.c_str(),
+          static_cast<char*>(nullptr));
+    _exit(127);
+  }
+  return pid;
+}
+
+int runWorker(const string& address) {
+  const size_t colon = address.rfind(':');
+  if (colon == string::npos) {
+    cerr << "Error: Expected HOST:PORT, got " << address << endl;
+    return 1;
+  }
+
+  try {
+    runShardWorker(address.substr(0, colon),
+                   boost::lexical_cast<int>(address.substr(colon + 1)));
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int runCoordinator(int argc, char* args[]) {
+  string bind = DEFAULT_BIND;
+  int port = 0;
+  int spawn = 0;
+  double speculation = 3.0;
+  bool preprocess = true;
+  bool print_tours = false;
+  vector<string> files;
+
+  try {
+    for (int i = 2; i < argc; i++) {
+      const string arg = args[i];
+      if (arg == "--tours") {
+        print_tours = true;
+      } else if (arg == "--raw") {
+        preprocess = false;
+      } else if (arg == "--bind" && i + 1 < argc) {
+        bind = args[++i];
+      } else if (arg == "--port" && i + 1 < argc) {
+        port = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--spawn" && i + 1 < argc) {
+        spawn = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--speculate" && i + 1 < argc) {
+        speculation = boost::lexical_cast<double>(args[++i]);
+      } else if (arg.compare(0, 2, "--") == 0) {
+        throw std::runtime_error("Unknown option " + arg);
+      } else {
+        files.push_back(arg);
+      }
+    }
+    if (files.size() != 2) {
+      throw std::runtime_error("Expected a network and a scenario file");
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
+  }
+
+  XMLReader reader;
+  vector<CostScenario> scenarios;
+  try {
+    reader.readTransportFile(files[0]);
+
+    std::ifstream in(files[1]);
+    if (!in) {
+      throw std::runtime_error("Cannot open scenario file " + files[1]);
+    }
+    scenarios = readScenarios(in);
+  } catch (const std::runtime_error& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  ShardCoordinator coordinator(reader.getStations(), reader.getLines(),
+                               preprocess);
+  coordinator.setSpeculation(speculation);
+
+  std::set<pid_t> children;
+  try {
+    port = coordinator.listen(bind, port);
+    cerr << "Coordinator listening on " << bind << ":" << port << endl;
+
+    for (int i = 0; i < spawn; i++) {
+      children.insert(spawnWorker(bind, port));
+    }
+  } catch (const std::runtime_error& e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  // remote workers may always connect later, spawned ones can be counted
+  if (spawn > 0) {
+    coordinator.setWorkersExpected([&children]() {
+      pid_t pid;
+      while ((pid = waitpid(-1, nullptr, WNOHANG)) > 0) {
+        children.erase(pid);
+      }
+      return !children.empty();
+    });
+  }
+
+  const vector<ScenarioResult> results = coordinator.run(scenarios);
+
+  const int status = reportScenarioResults(results, print_tours, cout);
+
+  for (pid_t pid : children) {
+    waitpid(pid, nullptr, 0);
+  }
+
+  return status;
+}
+}  // namespace
+
+int main(int argc, char* args[]) {
+  const string mode = argc > 1 ? args[1] : "";
+  if (mode == "worker" && argc == 3) {
+    return runWorker(args[2]);
+  }
+  if (mode == "coordinate") {
+    return runCoordinator(argc, args);
+  }
+
+  printUsage(args[0]);
+  return 1;
+}
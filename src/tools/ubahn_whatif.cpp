@@ -0,0 +1,41 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <vector>
+
+#include "io/xml_reader.h"
+#include "solver/closure_runner.h"
+#include "tools/scenario_tool.h"
+
+using std::vector;
+
+namespace {
+
+const double CHANGING_TIME = 5.0;
+const double SWITCHING_TIME = 5.0;
+}  // namespace
+
+int main(int argc, char* args[]) {
+  return runScenarioTool(
+      argc, args, "closure",
+      "Each line of the closure file contains tab separated fields\n"
+      "  name [station=NAME ...] [segment=LINE|FROM|TO ...]",
+      [](const XMLReader& network, std::istream& in, int threads) {
+        const vector<ClosureScenario> scenarios = readClosures(in);
+        ClosureRunner runner(network.getStations(), network.getLines(),
+                             CHANGING_TIME, SWITCHING_TIME);
+        return runner.run(scenarios, threads);
+      });
+}
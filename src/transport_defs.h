@@ -49,4 +49,32 @@ typedef std::map<std::string, Line*> t_linemap;
 
 enum ProblemType { STATION, SEGMENT };
 
+/**
+ * Identifies a node of the problem graph by its station, line and direction,
+ * so that it can be found again after the graph was rebuilt.
+ */
+struct NodeKey {
+  NodeKey() : reverse(false) {}
+  NodeKey(const std::string& station, const std::string& line, bool reverse)
+      : station(station), line(line), reverse(reverse) {}
+
+  bool operator<(const NodeKey& other) const {
+    if (station != other.station) return station < other.station;
+    if (line != other.line) return line < other.line;
+    return reverse < other.reverse;
+  }
+
+  std::string station;
+  std::string line;
+  bool reverse;  ///< whether the node belongs to the reversed line
+};
+
+/** One arc of a tour, given by the names of its stations and line. */
+struct TourLeg {
+  std::string from;
+  std::string line;  ///< the line or CHANGE_NAME
+  std::string to;
+  double time;
+};
+
 #endif  // UBAHN_TRANSPORT_DEFS_H_
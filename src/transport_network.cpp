@@ -0,0 +1,88 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "transport_network.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using std::ostringstream;
+using std::runtime_error;
+using std::string;
+
+TransportNetwork::~TransportNetwork() {
+  for (auto it = _stations.begin(); it != _stations.end(); ++it) {
+    delete it->second;
+  }
+  for (auto it = _lines.begin(); it != _lines.end(); ++it) {
+    delete it->second;
+  }
+}
+
+Station* TransportNetwork::addStation(const string& name,
+                                      const string& location) {
+  if (CHANGE_NAME.compare(name) == 0) {
+    ostringstream errBuf;
+    errBuf << "Invalid station name: " << name;
+    throw runtime_error(errBuf.str());
+  }
+  if (_stations.find(name) != _stations.end()) {
+    ostringstream errBuf;
+    errBuf << "Station " << name << " is defined twice";
+    throw runtime_error(errBuf.str());
+  }
+
+  return _stations[name] = new Station(name, location);
+}
+
+Line* TransportNetwork::addLine(const string& name) {
+  if (CHANGE_NAME.compare(name) == 0) {
+    ostringstream errBuf;
+    errBuf << "Invalid line name: " << name;
+    throw runtime_error(errBuf.str());
+  }
+  if (_lines.find(name) != _lines.end()) {
+    ostringstream errBuf;
+    errBuf << "Line " << name << " is defined twice";
+    throw runtime_error(errBuf.str());
+  }
+
+  return _lines[name] = new Line(name);
+}
+
+void TransportNetwork::addStop(Line* line, const string& station,
+                               unsigned int time) {
+  auto pos = _stations.find(station);
+  if (pos == _stations.end()) {
+    ostringstream errBuf;
+    errBuf << "Station " << station << " is not in station list";
+    throw runtime_error(errBuf.str());
+  }
+  if (!line->times.empty() && line->times.back() >= time) {
+    ostringstream errBuf;
+    errBuf << "Station " << station << " has no valid travel time";
+    throw runtime_error(errBuf.str());
+  }
+  if (pos->second->lines.count(line->name) > 0) {
+    ostringstream errBuf;
+    errBuf << "Line " << line->name << " visits station " << station
+           << " twice";
+    throw runtime_error(errBuf.str());
+  }
+
+  line->stations.push_back(station);
+  line->times.push_back(time);
+  pos->second->lines.insert(line->name);
+}
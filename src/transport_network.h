@@ -0,0 +1,62 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_TRANSPORT_NETWORK_H_
+#define UBAHN_TRANSPORT_NETWORK_H_
+
+#include <string>
+
+#include "transport_defs.h"
+
+/**
+ * A transportation network that is created in memory instead of being read
+ * from a file. It owns all its stations and lines.
+ */
+class TransportNetwork {
+ public:
+  TransportNetwork() {}
+  ~TransportNetwork();
+
+  // disallow copy and assign
+  TransportNetwork(const TransportNetwork&) = delete;
+  void operator=(TransportNetwork) = delete;
+
+  /** Adds a new station, throws an exception if the name is invalid. */
+  Station* addStation(const std::string& name,
+                      const std::string& location = "");
+
+  /** Adds a new line without stops, throws if the name is invalid. */
+  Line* addLine(const std::string& name);
+
+  /**
+   * Appends a stop to the given line. The station must already exist and the
+   * time must be larger than the time of the previous stop.
+   */
+  void addStop(Line* line, const std::string& station, unsigned int time);
+
+  bool hasStation(const std::string& name) const {
+    return _stations.find(name) != _stations.end();
+  }
+
+  const t_stationmap& getStations() const { return _stations; }
+  const t_linemap& getLines() const { return _lines; }
+
+ private:
+  t_stationmap _stations;
+  t_linemap _lines;
+};
+
+#endif  // UBAHN_TRANSPORT_NETWORK_H_
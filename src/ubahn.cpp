@@ -12,16 +12,29 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fstream>
+#include <future>
 #include <iostream>
 #include <list>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
+
+#include "boost/lexical_cast.hpp"
 
 #include "base/timer.h"
 #include "graph_builder.h"
+#include "io/solution_cache.h"
 #include "io/xml_reader.h"
+#include "solver/branching.h"
+#include "solver/cut_pool.h"
+#include "solver/lns_runner.h"
+#include "solver/multilevel_solver.h"
+#include "solver/portfolio_runner.h"
 #include "solver/station_solver.h"
+#include "ubahn_api.h"
 
 const char DEFAULT_FILE[] = "ubahn.xml";
 
@@ -30,19 +43,111 @@ const double SWITCHING_TIME = 5.0;
 const bool PREPROCESSING = true;
 const ProblemType TYPE = STATION;
 
+/// default size limit of the solution cache in MB
+const int DEFAULT_CACHE_SIZE = 100;
+
 using std::cout;
 using std::endl;
 using std::cerr;
 using std::unique_ptr;
 
+namespace {
+
+void printUsage(const char* name) {
+  cerr << "Usage: " << name << " [options] [network.xml]" << endl
+       << "Options:" << endl
+       << "  --cache-dir DIR          answer identical problems from DIR"
+       << endl
+       << "  --cache-size MB          size limit of the cache (default "
+       << DEFAULT_CACHE_SIZE << ")" << endl
+       << "  --cut-pool FILE          load and save subtour cuts in FILE"
+       << endl
+       << "  --portfolio N            race N solver configurations" << endl
+       << "  --seed-cuts MODE         none, lazy or rows (default none)"
+       << endl
+       << "  --heuristic N            repair every N-th LP solution into a "
+          "tour"
+       << endl
+       << "  --branch-priorities      branch on changes and switches first"
+       << endl
+       << "  --line-branching         branch on station-line groups" << endl
+       << "  --lns SECONDS            improve a heuristic tour by large "
+          "neighborhood search"
+       << endl
+       << "  --lns-region N           stations per region of the search "
+          "(default 30)"
+       << endl
+       << "  --multilevel SECONDS     solve on coarser graphs and refine"
+       << endl;
+}
+
+/** Prints the tour starting at the given station, if it is visited. */
+void printTourLegs(std::vector<TourLeg> legs, const std::string& start) {
+  rotateTourLegs(start, &legs);
+  GraphBuilder::printTourLegs(legs, cout);
+}
+}  // namespace
+
 int main(int argc, char* args[]) {
   XMLReader reader;
 
   std::string file = DEFAULT_FILE;
-  if (argc > 1) {
-    file = args[1];
+  std::string cache_dir;
+  int cache_size = DEFAULT_CACHE_SIZE;
+  std::string cut_pool_file;
+  int portfolio = 0;
+  SeedCuts seed_cuts = NO_SEED_CUTS;
+  int heuristic_frequency = 0;
+  bool branch_priorities = false;
+  bool line_branching = false;
+  double lns_time = 0.0;
+  int lns_region = 0;
+  double multilevel_time = 0.0;
+  bool has_file = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = args[i];
+      if (arg == "--cache-dir" && i + 1 < argc) {
+        cache_dir = args[++i];
+      } else if (arg == "--cache-size" && i + 1 < argc) {
+        cache_size = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--cut-pool" && i + 1 < argc) {
+        cut_pool_file = args[++i];
+      } else if (arg == "--portfolio" && i + 1 < argc) {
+        portfolio = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--seed-cuts" && i + 1 < argc) {
+        seed_cuts = parseSeedCuts(args[++i]);
+      } else if (arg == "--branch-priorities") {
+        branch_priorities = true;
+      } else if (arg == "--line-branching") {
+        line_branching = true;
+      } else if (arg == "--heuristic" && i + 1 < argc) {
+        heuristic_frequency = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--lns" && i + 1 < argc) {
+        lns_time = boost::lexical_cast<double>(args[++i]);
+      } else if (arg == "--lns-region" && i + 1 < argc) {
+        lns_region = boost::lexical_cast<int>(args[++i]);
+      } else if (arg == "--multilevel" && i + 1 < argc) {
+        multilevel_time = boost::lexical_cast<double>(args[++i]);
+      } else if (arg.compare(0, 1, "-") == 0) {
+        throw std::runtime_error("Unknown option or missing value: " + arg);
+      } else if (!has_file) {
+        file = arg;
+        has_file = true;
+      } else {
+        throw std::runtime_error("Unexpected argument " + arg);
+      }
+    }
+  } catch (const std::exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    printUsage(args[0]);
+    return 1;
   }
 
+  // starting CPLEX and checking the license is independent of the network
+  std::future<unique_ptr<CplexEnvironment>> environment =
+      CplexEnvironment::createAsync();
+
   cout << "Opening transportation network file: " << file << endl;
   try {
     reader.readTransportFile(file);
@@ -54,18 +159,197 @@ int main(int argc, char* args[]) {
   reader.printStatistic();
   cout << endl;
 
+  // identical problems are answered from the cache without solving
+  unique_ptr<SolutionCache> cache;
+  std::string cache_key;
+  if (!cache_dir.empty()) {
+    try {
+      cache.reset(new SolutionCache(cache_dir,
+                                    uint64_t(cache_size) * 1024 * 1024));
+      cache_key =
+          computeCacheKey(reader.getStations(), reader.getLines(),
+                          CHANGING_TIME, SWITCHING_TIME, TYPE, PREPROCESSING);
+
+      CachedSolution cached;
+      if (cache->lookup(cache_key, &cached)) {
+        cout << "Found the solution in the cache." << endl << endl;
+        cout << "Visiting all stations takes approximately "
+             << cached.objective << " minutes"
+             << " (assuming that changing takes " << CHANGING_TIME
+             << " minutes on average)." << endl;
+        printTourLegs(cached.tour, "Zoologischer Garten");
+        return 0;
+      }
+    } catch (const std::runtime_error& e) {
+      cerr << "Solution cache disabled: " << e.what() << endl;
+      cache.reset();
+    }
+  }
+
+  // differently configured solvers race for the optimum on the idle cores
+  if (portfolio > 1) {
+    cout << "Racing " << portfolio << " solver configurations..." << endl;
+    PortfolioRunner runner(reader.getStations(), reader.getLines(),
+                           CHANGING_TIME, SWITCHING_TIME, PREPROCESSING);
+    PortfolioResult result;
+    try {
+      result = runner.run(defaultPortfolio(portfolio));
+    } catch (const std::runtime_error& e) {
+      cerr << "Error: " << e.what() << endl;
+      return 1;
+    }
+
+    cout << "Configuration " << result.winner << " proved the optimum";
+    if (result.tour_from != result.winner) {
+      cout << " of the tour found by " << result.tour_from;
+    }
+    cout << " after " << result.solve_ms << " ms." << endl << endl;
+    cout << "Visiting all stations takes approximately " << result.objective
+         << " minutes"
+         << " (assuming that changing takes " << CHANGING_TIME
+         << " minutes on average)." << endl;
+    printTourLegs(result.tour, "Zoologischer Garten");
+
+    if (cache) {
+      CachedSolution solution;
+      solution.objective = result.objective;
+      solution.solving_time = result.solve_ms / 1000.0;
+      solution.statistics = result.statistics;
+      solution.tour = result.tour;
+
+      try {
+        cache->store(cache_key, solution);
+      } catch (const std::runtime_error& e) {
+        cerr << "Cannot cache the solution: " << e.what() << endl;
+      }
+    }
+    return 0;
+  }
+
   GraphBuilder ubahnGraph(reader.getStations(), reader.getLines(),
                           CHANGING_TIME, SWITCHING_TIME, TYPE, PREPROCESSING);
   ubahnGraph.printStatistics();
   cout << endl;
 
+  // networks too large for the full model are solved on a coarser graph
+  if (multilevel_time > 0) {
+    MultilevelSolver solver(ubahnGraph);
+    solver.setTimeLimit(multilevel_time);
+
+    cout << "Solving on coarser graphs for " << multilevel_time << " s..."
+         << endl;
+    MultilevelResult result;
+    try {
+      result = solver.solve();
+    } catch (const std::runtime_error& e) {
+      cerr << "Error: " << e.what() << endl;
+      return 1;
+    }
+
+    for (const LevelReport& level : result.levels) {
+      cout << "Level " << level.level << " (" << level.stations
+           << " stations, " << level.nodes << " nodes, " << level.arcs
+           << " arcs): " << (level.optimal ? "optimal " : "") << "tour "
+           << level.value << " after " << level.seconds << " s" << endl;
+      if (!level.error.empty()) {
+        cout << "  not solved exactly: " << level.error << endl;
+      }
+    }
+    cout << "The tour is "
+         << 100.0 * (result.value - result.lower_bound) / result.value
+         << "% above the lower bound of " << result.lower_bound << "." << endl
+         << endl;
+    cout << "Visiting all stations takes approximately " << result.value
+         << " minutes"
+         << " (assuming that changing takes " << CHANGING_TIME
+         << " minutes on average)." << endl;
+    try {
+      ubahnGraph.printTour(result.tour, "Zoologischer Garten", true);
+    } catch (const std::runtime_error&) {
+      ubahnGraph.printTour(result.tour);
+    }
+    return 0;
+  }
+
+  // networks too large for the full model are improved region by region
+  if (lns_time > 0) {
+    LnsRunner runner(ubahnGraph);
+    runner.setTimeLimit(lns_time);
+    if (lns_region > 0) {
+      runner.setRegionSize(lns_region);
+    }
+
+    cout << "Improving a heuristic tour for " << lns_time << " s..." << endl;
+    LnsResult result;
+    try {
+      result = runner.run([](const LnsSample& sample) {
+        cout << "Round " << sample.round << " after " << sample.seconds
+             << " s: " << sample.value << " minutes, " << sample.improved
+             << " of " << sample.regions << " regions improved";
+        if (sample.unsolved > 0) {
+          cout << ", " << sample.unsolved << " hit the time limit";
+        }
+        cout << endl;
+      });
+    } catch (const std::runtime_error& e) {
+      cerr << "Error: " << e.what() << endl;
+      return 1;
+    }
+
+    cout << "Improved the tour from " << result.initial_value << " to "
+         << result.value << " minutes in " << result.rounds << " rounds, "
+         << 100.0 * (result.value - result.lower_bound) / result.value
+         << "% above the lower bound of " << result.lower_bound << "."
+         << endl
+         << endl;
+    cout << "Visiting all stations takes approximately " << result.value
+         << " minutes"
+         << " (assuming that changing takes " << CHANGING_TIME
+         << " minutes on average)." << endl;
+    try {
+      ubahnGraph.printTour(result.tour, "Zoologischer Garten", true);
+    } catch (const std::runtime_error&) {
+      ubahnGraph.printTour(result.tour);
+    }
+    return 0;
+  }
+
+  // the cuts of earlier runs are added as lazy constraints
+  CutPool cut_pool;
+  if (!cut_pool_file.empty() && std::ifstream(cut_pool_file)) {
+    try {
+      cut_pool.load(cut_pool_file);
+      cout << "Loaded " << cut_pool.size() << " cuts from " << cut_pool_file
+           << endl;
+    } catch (const std::runtime_error& e) {
+      cerr << "Ignoring the cut pool: " << e.what() << endl;
+    }
+  }
+
   unique_ptr<CplexSolver> solver;
   switch (TYPE) {
-    case STATION:
-      solver = unique_ptr<CplexSolver>(new StationSolver(
+    case STATION: {
+      StationSolver* station_solver = new StationSolver(
           ubahnGraph.getGraph(), ubahnGraph.getDist(),
-          ubahnGraph.getStationNodes(), ubahnGraph.getConnections()));
+          ubahnGraph.getStationNodes(), ubahnGraph.getConnections(),
+          environment.get());
+      solver = unique_ptr<CplexSolver>(station_solver);
+      station_solver->setSeedCuts(seed_cuts);
+      station_solver->setHeuristicFrequency(heuristic_frequency);
+      if (branch_priorities) {
+        station_solver->setBranchPriorities(
+            getBranchPriorities(ubahnGraph, BranchWeights()));
+      }
+      if (line_branching) {
+        station_solver->setBranchGroups(getStationLineGroups(ubahnGraph));
+      }
+
+      if (!cut_pool_file.empty()) {
+        station_solver->setKeepCuts(true);
+        station_solver->addKeptCuts(cut_pool.toGraph(ubahnGraph));
+      }
       break;
+    }
     default:
       std::ostringstream err_buf;
       err_buf << "Problem type " << TYPE << " is not supported";
@@ -77,6 +361,22 @@ int main(int argc, char* args[]) {
   solver->solve();
   cout << "Done." << endl;
 
+  if (!cut_pool_file.empty()) {
+    const StationSolver* station_solver =
+        static_cast<const StationSolver*>(solver.get());
+    cut_pool.addFromGraph(ubahnGraph, station_solver->getKeptCuts());
+    try {
+      cut_pool.save(cut_pool_file);
+    } catch (const std::runtime_error& e) {
+      cerr << "Cannot save the cut pool: " << e.what() << endl;
+    }
+
+    const SolverStatistics& statistics = solver->getStatistics();
+    cout << "Started with " << statistics.pooled_cuts << " pooled cuts, "
+         << statistics.callback_calls << " callback calls added "
+         << statistics.lazy_cuts << " cuts." << endl;
+  }
+
   cout << "Solving took " << solve_timer << " ms."
        // << " (Spent " << solver.getCutGenerationTime() << " ms on cuts)"
        << endl
@@ -97,5 +397,19 @@ int main(int argc, char* args[]) {
     ubahnGraph.printTour(solver->getSolutionTour());
   }
 
+  if (cache) {
+    CachedSolution solution;
+    solution.objective = solver->getSolutionValue();
+    solution.solving_time = solver->getTime();
+    solution.statistics = solver->getStatistics();
+    solution.tour = ubahnGraph.getTourLegs(solver->getSolutionTour());
+
+    try {
+      cache->store(cache_key, solution);
+    } catch (const std::runtime_error& e) {
+      cerr << "Cannot cache the solution: " << e.what() << endl;
+    }
+  }
+
   return 0;
 }
@@ -0,0 +1,167 @@
+// Copyright 2017 Wolfgang Welz welzwo@gmail.com
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ubahn_api.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "base/timer.h"
+#include "graph_builder.h"
+#include "io/xml_reader.h"
+#include "solver/portfolio_runner.h"
+#include "solver/station_solver.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+typedef std::chrono::duration<double, std::milli> t_ms;
+typedef std::future<unique_ptr<CplexEnvironment>> t_environment;
+
+/** Starts CPLEX in the background, if the options allow it. */
+t_environment startEnvironment(const SolveOptions& options) {
+  // each solver of a portfolio creates its own environment
+  const bool pipelined = options.pipelined && options.portfolio <= 1;
+  return CplexEnvironment::createAsync(pipelined ? std::launch::async
+                                                 : std::launch::deferred);
+}
+
+SolveResult solvePortfolio(const t_stationmap& stations,
+                           const t_linemap& lines,
+                           const SolveOptions& options) {
+  if (options.type != STATION) {
+    std::ostringstream errBuf;
+    errBuf << "Problem type " << options.type << " is not supported";
+    throw std::runtime_error(errBuf.str());
+  }
+
+  PortfolioRunner runner(stations, lines, options.change_cost,
+                         options.switch_cost, options.preprocess);
+  if (options.time_limit > 0) {
+    runner.setTimeLimit(options.time_limit);
+  }
+  const PortfolioResult portfolio =
+      runner.run(defaultPortfolio(options.portfolio));
+
+  SolveResult result;
+  result.objective = portfolio.objective;
+  result.tour = portfolio.tour;
+  result.statistics = portfolio.statistics;
+  result.configuration = portfolio.winner;
+  result.solve_ms = portfolio.solve_ms;
+  if (!options.start_station.empty()) {
+    rotateTourLegs(options.start_station, &result.tour);
+  }
+
+  return result;
+}
+
+SolveResult solveWithEnvironment(const t_stationmap& stations,
+                                 const t_linemap& lines,
+                                 const SolveOptions& options,
+                                 t_environment* environment) {
+  if (options.portfolio > 1) {
+    return solvePortfolio(stations, lines, options);
+  }
+
+  SolveResult result;
+
+  Timer timer;
+  GraphBuilder builder(stations, lines, options.change_cost,
+                       options.switch_cost, options.type, options.preprocess);
+  result.build_ms = timer.Elapsed<t_ms>().count();
+  result.graph_nodes = builder.getGraph().number_of_nodes();
+  result.graph_arcs = builder.getGraph().number_of_edges();
+
+  if (options.type != STATION) {
+    std::ostringstream errBuf;
+    errBuf << "Problem type " << options.type << " is not supported";
+    throw std::runtime_error(errBuf.str());
+  }
+
+  // without pipelining, CPLEX is started only now
+  timer.Reset();
+  timer.Start();
+  StationSolver solver(builder.getGraph(), builder.getDist(),
+                       builder.getStationNodes(), builder.getConnections(),
+                       environment->get());
+  solver.setVerbose(false);
+  solver.setThreads(options.threads);
+  if (options.time_limit > 0) {
+    solver.setTimeLimit(options.time_limit);
+  }
+  solver.solve();
+  result.solve_ms = timer.Elapsed<t_ms>().count();
+
+  result.objective = solver.getSolutionValue();
+  result.statistics = solver.getStatistics();
+  result.tour = builder.getTourLegs(solver.getSolutionTour());
+  if (!options.start_station.empty()) {
+    rotateTourLegs(options.start_station, &result.tour);
+  }
+
+  return result;
+}
+}  // namespace
+
+SolveResult solveNetwork(const t_stationmap& stations, const t_linemap& lines,
+                         const SolveOptions& options) {
+  Timer timer;
+  t_environment environment = startEnvironment(options);
+
+  SolveResult result =
+      solveWithEnvironment(stations, lines, options, &environment);
+  result.total_ms = timer.Elapsed<t_ms>().count();
+
+  return result;
+}
+
+SolveResult solveNetwork(const TransportNetwork& network,
+                         const SolveOptions& options) {
+  return solveNetwork(network.getStations(), network.getLines(), options);
+}
+
+SolveResult solveNetworkFile(const string& file, const SolveOptions& options) {
+  Timer timer;
+  t_environment environment = startEnvironment(options);
+
+  XMLReader reader;
+  reader.readTransportFile(file);
+  const double parse_ms = timer.Elapsed<t_ms>().count();
+
+  SolveResult result = solveWithEnvironment(
+      reader.getStations(), reader.getLines(), options, &environment);
+  result.parse_ms = parse_ms;
+  result.total_ms = timer.Elapsed<t_ms>().count();
+
+  return result;
+}
+
+void rotateTourLegs(const string& start, vector<TourLeg>* legs) {
+  auto it = std::find_if(legs->rbegin(), legs->rend(), [&](const TourLeg& leg) {
+    return leg.from == start;
+  });
+  if (it != legs->rend()) {
+    std::rotate(legs->begin(), (it + 1).base(), legs->end());
+  }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2017 Wolfgang Welz welzwo@gmail.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UBAHN_UBAHN_API_H_
+#define UBAHN_UBAHN_API_H_
+
+#include <string>
+#include <vector>
+
+#include "solver/solver_statistics.h"
+#include "transport_defs.h"
+#include "transport_network.h"
+
+/*
+ * The entry points of libubahn for embedding the solver into other programs.
+ * This header does not depend on LEDA, CPLEX or Xerces. All functions throw
+ * a std::runtime_error if the network cannot be solved.
+ */
+
+struct SolveOptions {
+  SolveOptions()
+      : change_cost(5.0),
+        switch_cost(5.0),
+        type(STATION),
+        preprocess(true),
+        threads(1),
+        time_limit(0.0),
+        pipelined(true),
+        portfolio(0) {}
+
+  double change_cost;  ///< cost for changing the line
+  double switch_cost;  ///< cost for switching the direction
+  ProblemType type;
+  bool preprocess;
+  int threads;        ///< number of CPLEX threads
+  double time_limit;  ///< in seconds, 0 for no limit
+
+  /// whether CPLEX is started while the network is read and the graph built
+  bool pipelined;
+
+  /**
+   * If greater than 1, this many differently configured single threaded
+   * solvers race in parallel, see PortfolioRunner. Ignores threads.
+   */
+  int portfolio;
+
+  /// the tour is rotated to start at this station, if it is visited
+  std::string start_station;
+};
+
+struct SolveResult {
+  SolveResult()
+      : objective(0.0),
+        graph_nodes(0),
+        graph_arcs(0),
+        parse_ms(0.0),
+        build_ms(0.0),
+        solve_ms(0.0),
+        total_ms(0.0) {}
+
+  double objective;
+  std::vector<TourLeg> tour;
+  SolverStatistics statistics;
+
+  /// the portfolio configuration that proved the optimum
+  std::string configuration;
+
+  int graph_nodes;  ///< not set for portfolios
+  int graph_arcs;
+
+  double parse_ms;  ///< only set when solving a file
+  double build_ms;
+  double solve_ms;  ///< including the creation of the model
+  double total_ms;  ///< from the call to the result
+};
+
+SolveResult solveNetwork(const t_stationmap& stations, const t_linemap& lines,
+                         const SolveOptions& options = SolveOptions());
+SolveResult solveNetwork(const TransportNetwork& network,
+                         const SolveOptions& options = SolveOptions());
+
+/** Reads the network from an XML file and solves it. */
+SolveResult solveNetworkFile(const std::string& file,
+                             const SolveOptions& options = SolveOptions());
+
+/**
+ * Rotates the closed tour, so that it starts with the last leg leaving the
+ * given station. The tour is unchanged if the station is not visited.
+ */
+void rotateTourLegs(const std::string& start, std::vector<TourLeg>* legs);
+
+#endif  // UBAHN_UBAHN_API_H_